@@ -24,6 +24,7 @@ THE SOFTWARE.
 
 #include "CustomBaseNode.h"
 #include "Shorteners.h"
+#include "FenneXCCBLoader.h"
 
 NS_FENNEX_BEGIN
 CustomBaseNode::CustomBaseNode()
@@ -53,7 +54,8 @@ bool CustomBaseNode::onAssignCCBMemberVariable(Ref * pTarget, const char* pMembe
 
 void CustomBaseNode::onNodeLoaded(Node * pNode, NodeLoader * pNodeLoader)
 {
-    
+    //The reader calls this instead of its own listener for custom nodes
+    tagCCBNode(pNode, pNodeLoader, this);
 }
 
 bool CustomBaseNode::onAssignCCBCustomProperty(Ref* pTarget, const char* pMemberVariableName, const cocos2d::Value& pCCBValue)
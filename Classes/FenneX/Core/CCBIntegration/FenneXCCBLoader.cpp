@@ -34,6 +34,8 @@ THE SOFTWARE.
 #include "CustomLabel.h"
 #include "CustomDropDownList.h"
 
+#include <typeindex>
+
 using namespace cocosbuilder;
 
 NS_FENNEX_BEGIN
@@ -46,6 +48,241 @@ static std::function<std::string(const std::string&, const std::string&, const V
 //Don't retain the CCBAnimationManager, because it's troublesome to release them at the right time. Soft references is enough.
 static std::vector<CCBAnimationManager*> animManagers;
 
+//Custom loaders are registered once, and the library is shared by all CCBReaders
+static NodeLoaderLibrary* nodeLoaderLibrary = nullptr;
+
+//The node graph is read and rescaled for the load size and loading scale, so they are part of the key along with the layout
+struct CCBTemplateKey
+{
+    std::string file;
+    bool phoneLayout;
+    float loadWidth;
+    float loadHeight;
+    float loadingScale;
+    
+    bool operator<(const CCBTemplateKey& other) const
+    {
+        return std::tie(file, phoneLayout, loadWidth, loadHeight, loadingScale) < std::tie(other.file, other.phoneLayout, other.loadWidth, other.loadHeight, other.loadingScale);
+    }
+};
+
+//Exact class of a node in a template description. Nodes of other classes (CCBFile, controls, ...) can only be loaded by reading the file
+enum class CCBNodeClass
+{
+    Node,
+    Layer,
+    Sprite,
+    Label,
+    Scale9Sprite,
+    CustomNode,
+    CustomSprite,
+    CustomLabel,
+    CustomInput,
+    CustomScaleSprite,
+    CustomDropDownList,
+};
+
+//A SpriteFrame as plain data: it doesn't retain the texture, which is loaded again if it was purged
+struct CCBFrameDescription
+{
+    std::string textureFile; //Empty for sprites without a texture
+    Rect rect; //In pixels, like offset and originalSize
+    bool rotated;
+    Vec2 offset;
+    Size originalSize;
+};
+
+//A node as it is once read and rescaled, as plain data. Only the fields of its class are used
+struct CCBNodeDescription
+{
+    CCBNodeClass nodeClass;
+    CCBNodeType type;
+    
+    Vec2 position;
+    Vec2 anchorPoint;
+    bool ignoreAnchorPoint;
+    Size contentSize;
+    float scaleX;
+    float scaleY;
+    float rotationX;
+    float rotationY;
+    float skewX;
+    float skewY;
+    bool visible;
+    int tag;
+    int zOrder;
+    Color3B color;
+    GLubyte opacity;
+    
+    //CustomBaseNode
+    std::string name;
+    std::string eventName;
+    int scene;
+    int zindex;
+    ValueMap parameters;
+    
+    //Sprite and Scale9Sprite
+    CCBFrameDescription frame;
+    bool flippedX;
+    bool flippedY;
+    BlendFunc blendFunc;
+    Rect capInsets;
+    
+    //Label
+    std::string fontName;
+    float fontSize;
+    std::string text;
+    Size dimensions;
+    TextHAlignment hAlignment;
+    TextVAlignment vAlignment;
+    LabelFitType fitType;
+    
+    //CustomInput
+    int inputMode;
+    int maxChar;
+    int inputFontSize;
+    std::string placeHolder;
+    std::string inputFontName;
+    
+    std::vector<CCBNodeDescription> children;
+};
+
+/* The first load of a template reads its bytes, then describes the rescaled node graph and drops them:
+ the next loads instantiate the description, without reading the file nor rescaling again.
+ Node graphs which can't be described (unknown classes, animation sequences) keep their bytes and are read each time */
+struct CCBTemplate
+{
+    std::string filePath; //Resolved .ccbi, -phone or not
+    std::shared_ptr<Data> data; //Shared with the CCBReaders using it, null once described
+    std::shared_ptr<CCBNodeDescription> description;
+    bool describable = true;
+};
+
+static std::map<CCBTemplateKey, CCBTemplate> ccbTemplates;
+static std::map<std::string, CCBTemplateStats> ccbTemplateStats;
+
+struct CCBNodeTag
+{
+    CCBNodeType type;
+    CustomBaseNode* customNode;
+};
+
+//Types of the nodes created by each loader of the shared library. Other loaders create Panels
+static std::unordered_map<NodeLoader*, CCBNodeType> loaderTypes;
+//Nodes read by the current loadCCBFromFileToFenneX. Cleared once they are loaded
+static std::unordered_map<Node*, CCBNodeTag> nodeTags;
+//Objects created by the current loadCCBFromFileToFenneX, in creation order, or nullptr when not loading a file
+static std::vector<RawObject*>* loadedObjects = nullptr;
+
+class CCBNodeTagger : public NodeLoaderListener
+{
+public:
+    virtual void onNodeLoaded(Node* node, NodeLoader* loader)
+    {
+        tagCCBNode(node, loader, nullptr);
+    }
+};
+static CCBNodeTagger nodeTagger;
+
+static NodeLoaderLibrary* getNodeLoaderLibrary()
+{
+    if(nodeLoaderLibrary == nullptr)
+    {
+        nodeLoaderLibrary = NodeLoaderLibrary::newDefaultNodeLoaderLibrary();
+        nodeLoaderLibrary->retain();
+        nodeLoaderLibrary->registerNodeLoader("CustomSprite", CustomSpriteLoader::loader());
+        nodeLoaderLibrary->registerNodeLoader("CustomScaleSprite", CustomScaleSpriteLoader::loader());
+        nodeLoaderLibrary->registerNodeLoader("CustomNode", CustomNodeLoader::loader());
+        nodeLoaderLibrary->registerNodeLoader("CustomInput", CustomInputLoader::loader());
+        nodeLoaderLibrary->registerNodeLoader("CustomLabel", CustomLabelLoader::loader());
+        nodeLoaderLibrary->registerNodeLoader("CustomDropDownList", CustomDropDownListLoader::loader());
+        const std::vector<std::pair<const char*, CCBNodeType>> typedLoaders = {
+            {"CCLabelTTF", CCBNodeType::Label},
+            {"CustomLabel", CCBNodeType::Label},
+            {"CustomInput", CCBNodeType::Input},
+            {"CustomDropDownList", CCBNodeType::DropDownList},
+            {"CCScale9Sprite", CCBNodeType::ScaleSprite},
+            {"CustomScaleSprite", CCBNodeType::ScaleSprite},
+            {"CCSprite", CCBNodeType::Image},
+            {"CustomSprite", CCBNodeType::Image},
+        };
+        for(const auto& typedLoader : typedLoaders)
+        {
+            loaderTypes[nodeLoaderLibrary->getNodeLoader(typedLoader.first)] = typedLoader.second;
+        }
+    }
+    return nodeLoaderLibrary;
+}
+
+//Resolve the .ccbi of a file for the current layout, -phone or not. Return false if it doesn't exist
+static bool resolveCCBFilePath(const std::string& file, std::string& filePath)
+{
+    //IF this one fail, it needs to be silent
+    bool shouldNotify = FileUtils::getInstance()->isPopupNotify();
+    FileUtils::getInstance()->setPopupNotify(false);
+    filePath = file +  (isPhoneLayout ? "-phone" : "") + ".ccbi";
+#if VERBOSE_LOAD_CCB
+    log("Filepath : %s", filePath.c_str());
+#endif
+    bool exists = FileUtils::getInstance()->isFileExist(filePath);
+    FileUtils::getInstance()->setPopupNotify(shouldNotify);
+    if(!exists && isPhoneLayout)
+    {
+        filePath = file + ".ccbi";
+        exists = true;
+    }
+    return exists;
+}
+
+//The load size is the screen size by default, which is only known once the Director is set up
+static const Size& getLoadSize()
+{
+    if(_loadSize.width == -1)
+    {
+        _loadSize = Director::getInstance()->getWinSize();
+    }
+    return _loadSize;
+}
+
+static CCBTemplateKey getCCBTemplateKey(const std::string& file)
+{
+    return {file, isPhoneLayout, getLoadSize().width, getLoadSize().height, _loadingScale};
+}
+
+//Return the template for the current loading parameters, reading the file if it isn't cached yet. Its data and description are null if the file doesn't exist
+static CCBTemplate& getCCBTemplate(const std::string& file, CCBTemplateStats& stats)
+{
+    CCBTemplateKey key = getCCBTemplateKey(file);
+    auto it = ccbTemplates.find(key);
+    if(it != ccbTemplates.end())
+    {
+        stats.hits++;
+        return it->second;
+    }
+    stats.misses++;
+    
+    CCBTemplate result;
+    if(resolveCCBFilePath(file, result.filePath))
+    {
+#if VERBOSE_LOAD_CCB
+        log("File exist");
+#endif
+        Data data = FileUtils::getInstance()->getDataFromFile(FileUtils::getInstance()->fullPathForFilename(result.filePath));
+        if(!data.isNull())
+        {
+            result.data = std::make_shared<Data>(std::move(data));
+        }
+    }
+    //Missing files are not cached, they may be downloaded later
+    if(result.data == nullptr)
+    {
+        static CCBTemplate missingTemplate;
+        missingTemplate = result;
+        return missingTemplate;
+    }
+    return ccbTemplates.emplace(key, std::move(result)).first->second;
+}
+
 void resizeChildren(Node* parentNode, Node* resizeNode, float usedScale, int depth)
 {
     Vector<Node*> nodeChildren = resizeNode->getChildren();
@@ -97,59 +334,9 @@ void resizeChildren(Node* parentNode, Node* resizeNode, float usedScale, int dep
 }
 
 
-void setCCBLoadingTextTransform(std::function<std::string(const std::string&, const std::string&, const ValueMap&)> _textTransform)
-{
-    textTransform = _textTransform;
-}
-
-Panel* loadCCBFromFileToFenneX(std::string file, std::string inPanel, int zIndex)
+//Rescale a node graph read by CCBReader for the current loading scale
+static void rescaleNodeGraph(Node* myNode)
 {
-    if(inPanel.empty())
-    {
-        animManagers.clear();
-    }
-    NodeLoaderLibrary * nodeLoaderLibrary = NodeLoaderLibrary::newDefaultNodeLoaderLibrary();
-    nodeLoaderLibrary->registerNodeLoader("CustomSprite", CustomSpriteLoader::loader());
-    nodeLoaderLibrary->registerNodeLoader("CustomScaleSprite", CustomScaleSpriteLoader::loader());
-    nodeLoaderLibrary->registerNodeLoader("CustomNode", CustomNodeLoader::loader());
-    nodeLoaderLibrary->registerNodeLoader("CustomInput", CustomInputLoader::loader());
-    nodeLoaderLibrary->registerNodeLoader("CustomLabel", CustomLabelLoader::loader());
-    nodeLoaderLibrary->registerNodeLoader("CustomDropDownList", CustomDropDownListLoader::loader());
-    CCBReader *ccbReader = new CCBReader(nodeLoaderLibrary);
-    
-    //IF this one fail, it needs to be silent
-    bool shouldNotify = FileUtils::getInstance()->isPopupNotify();
-    FileUtils::getInstance()->setPopupNotify(false);
-    
-#if VERBOSE_PERFORMANCE_TIME
-    timeval startTime;
-    gettimeofday(&startTime, nullptr);
-#endif
-    std::string filePath = file +  (isPhoneLayout ? "-phone" : "") + ".ccbi";
-    log("Filepath : %s", filePath.c_str());
-    FileUtils::getInstance()->setPopupNotify(shouldNotify);
-    Node* myNode = nullptr;
-    if(_loadSize.width == -1)
-    {
-        _loadSize = Director::getInstance()->getWinSize();
-    }
-    if(FileUtils::getInstance()->isFileExist(filePath))
-    {
-        log("File exist");
-        myNode = ccbReader->readNodeGraphFromFile(filePath.c_str(), nullptr, _loadSize);
-    }
-    else if(isPhoneLayout)
-    {
-        filePath = file + ".ccbi";
-        myNode = ccbReader->readNodeGraphFromFile(filePath.c_str(), nullptr, _loadSize);
-    }
-    
-#if VERBOSE_PERFORMANCE_TIME
-    timeval middleTime;
-    gettimeofday(&middleTime, nullptr);
-    log("CCBReader loaded file %s in %f ms", file.c_str(), getTimeDifferenceMS(startTime, middleTime));
-#endif
-    
     //Despite cocosbuilder saying so, Label and Node (for Panel) aren't resized properly, so there it is
     /*Size frameSize = CCBLoaderGetLoadSize();
      float scaleX = (float)frameSize.width / designResolutionSize.width;
@@ -160,9 +347,6 @@ Panel* loadCCBFromFileToFenneX(std::string file, std::string inPanel, int zIndex
     float usedScale = _loadingScale;
     
     //this code is dubious at best .... refactor it later
-#if VERBOSE_LOAD_CCB
-    log("ccb file %s loaded, doing rescaling ...", file.c_str());
-#endif
     for(auto node : myNode->getChildren())
     {
         //Note : Panels are never tested against isKindOfClass because :
@@ -243,30 +427,552 @@ Panel* loadCCBFromFileToFenneX(std::string file, std::string inPanel, int zIndex
             }
         }
     }
+}
+
+//Layer touch and accelerometer flags are deprecated, but LayerLoader still sets them
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+static bool usesLayerInputs(Layer* layer)
+{
+    return layer->isTouchEnabled() || layer->isAccelerometerEnabled();
+}
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+//Same key as CC_2x2_WHITE_IMAGE_KEY in CCSprite.cpp, used by sprites created without a texture
+static const std::string defaultTextureKey = "/cc_2x2_white_image";
+
+static bool describeSpriteFrame(Sprite* sprite, CCBFrameDescription& frame)
+{
+    std::string textureFile = Director::getInstance()->getTextureCache()->getKeyForTexture(sprite->getTexture());
+    if(textureFile == defaultTextureKey)
+    {
+        frame.textureFile.clear();
+        return true;
+    }
+    if(textureFile.empty())
+    {
+        return false;
+    }
+    SpriteFrame* spriteFrame = sprite->getSpriteFrame();
+    frame.textureFile = textureFile;
+    frame.rect = spriteFrame->getRectInPixels();
+    frame.rotated = spriteFrame->isRotated();
+    frame.offset = spriteFrame->getOffsetInPixels();
+    frame.originalSize = spriteFrame->getOriginalSizeInPixels();
+    return true;
+}
+
+//Return nullptr for sprites without a texture, or if the texture can't be loaded anymore
+static SpriteFrame* createSpriteFrame(const CCBFrameDescription& frame)
+{
+    Texture2D* texture = frame.textureFile.empty() ? nullptr : Director::getInstance()->getTextureCache()->addImage(frame.textureFile);
+    return texture != nullptr ? SpriteFrame::createWithTexture(texture, frame.rect, frame.rotated, frame.offset, frame.originalSize) : nullptr;
+}
+
+static CCBNodeType getCCBNodeType(Node* node, CustomBaseNode*& customNode);
+
+//Describe a node read by CCBReader and its children. Return false if a node can't be described, in which case the file is read on each load
+static bool describeCCBNode(Node* node, CCBNodeDescription& description)
+{
+    static const std::unordered_map<std::type_index, CCBNodeClass> nodeClasses = {
+        {typeid(Node), CCBNodeClass::Node},
+        {typeid(Layer), CCBNodeClass::Layer},
+        {typeid(Sprite), CCBNodeClass::Sprite},
+        {typeid(Label), CCBNodeClass::Label},
+        {typeid(ui::Scale9Sprite), CCBNodeClass::Scale9Sprite},
+        {typeid(CustomNode), CCBNodeClass::CustomNode},
+        {typeid(CustomSprite), CCBNodeClass::CustomSprite},
+        {typeid(CustomLabel), CCBNodeClass::CustomLabel},
+        {typeid(CustomInput), CCBNodeClass::CustomInput},
+        {typeid(CustomScaleSprite), CCBNodeClass::CustomScaleSprite},
+        {typeid(CustomDropDownList), CCBNodeClass::CustomDropDownList},
+    };
+    auto nodeClass = nodeClasses.find(typeid(*node));
+    if(nodeClass == nodeClasses.end() || (nodeClass->second == CCBNodeClass::Layer && usesLayerInputs((Layer*)node)))
+    {
+        return false;
+    }
+    description.nodeClass = nodeClass->second;
+    CustomBaseNode* customNode = nullptr;
+    description.type = getCCBNodeType(node, customNode);
     
-    Panel* parent = nullptr;
-    if(!inPanel.empty())
+    description.position = node->getPosition();
+    description.anchorPoint = node->getAnchorPoint();
+    description.ignoreAnchorPoint = node->isIgnoreAnchorPointForPosition();
+    description.contentSize = node->getContentSize();
+    description.scaleX = node->getScaleX();
+    description.scaleY = node->getScaleY();
+    description.rotationX = node->getRotationSkewX();
+    description.rotationY = node->getRotationSkewY();
+    description.skewX = node->getSkewX();
+    description.skewY = node->getSkewY();
+    description.visible = node->isVisible();
+    description.tag = node->getTag();
+    description.zOrder = node->getLocalZOrder();
+    description.color = node->getColor();
+    description.opacity = node->getOpacity();
+    
+    customNode = dynamic_cast<CustomBaseNode*>(node);
+    if(customNode != nullptr)
     {
-        myNode->setContentSize(Size(0, 0));
-        parent = GraphicLayer::sharedLayer()->createPanelWithNode(inPanel, myNode, zIndex);
+        description.name = customNode->getName();
+        description.eventName = customNode->getEventName();
+        description.scene = customNode->getScene();
+        description.zindex = customNode->getZindex();
+        description.parameters = customNode->getParameters();
     }
     
-    loadNodeToFenneX(file, myNode, parent);
-    reorderZindex();
-    linkInputLabels();
+    switch(description.nodeClass)
+    {
+        case CCBNodeClass::Sprite:
+        case CCBNodeClass::CustomSprite:
+        case CCBNodeClass::CustomDropDownList:
+        {
+            Sprite* sprite = (Sprite*)node;
+            if(!describeSpriteFrame(sprite, description.frame))
+            {
+                return false;
+            }
+            description.flippedX = sprite->isFlippedX();
+            description.flippedY = sprite->isFlippedY();
+            description.blendFunc = sprite->getBlendFunc();
+            break;
+        }
+        case CCBNodeClass::Scale9Sprite:
+        case CCBNodeClass::CustomScaleSprite:
+        case CCBNodeClass::CustomInput:
+        {
+            ui::Scale9Sprite* sprite = (ui::Scale9Sprite*)node;
+            if(!describeSpriteFrame(sprite, description.frame))
+            {
+                return false;
+            }
+            description.capInsets = sprite->getCapInsets();
+            if(description.nodeClass == CCBNodeClass::CustomInput)
+            {
+                CustomInput* input = (CustomInput*)node;
+                description.inputMode = input->getInputMode();
+                description.maxChar = input->getMaxChar();
+                description.inputFontSize = input->getFontSize();
+                description.placeHolder = input->getPlaceHolder();
+                description.inputFontName = input->getFontName();
+            }
+            break;
+        }
+        case CCBNodeClass::Label:
+        case CCBNodeClass::CustomLabel:
+        {
+            Label* label = (Label*)node;
+            description.fontName = label->getSystemFontName();
+            description.fontSize = label->getSystemFontSize();
+            description.text = label->getString();
+            description.dimensions = label->getDimensions();
+            description.hAlignment = label->getHorizontalAlignment();
+            description.vAlignment = label->getVerticalAlignment();
+            description.blendFunc = label->getBlendFunc();
+            if(description.nodeClass == CCBNodeClass::CustomLabel)
+            {
+                description.fitType = ((CustomLabel*)node)->getFitType();
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    
+    description.children.resize(node->getChildrenCount());
+    for(int i = 0; i < node->getChildrenCount(); i++)
+    {
+        if(!describeCCBNode(node->getChildren().at(i), description.children[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Create the node graph of a description, tagging the nodes like CCBReader does
+static Node* instantiateCCBNode(const CCBNodeDescription& description)
+{
+    Node* node = nullptr;
+    CustomBaseNode* customNode = nullptr;
+    switch(description.nodeClass)
+    {
+        case CCBNodeClass::Node:
+            node = Node::create();
+            break;
+        case CCBNodeClass::Layer:
+            node = Layer::create();
+            break;
+        case CCBNodeClass::Sprite:
+            node = Sprite::create();
+            break;
+        case CCBNodeClass::Label:
+            node = Label::create();
+            break;
+        case CCBNodeClass::Scale9Sprite:
+            node = ui::Scale9Sprite::create();
+            break;
+        case CCBNodeClass::CustomNode:
+        {
+            CustomNode* custom = CustomNode::create();
+            node = custom;
+            customNode = custom;
+            break;
+        }
+        case CCBNodeClass::CustomSprite:
+        {
+            CustomSprite* custom = CustomSprite::create();
+            node = custom;
+            customNode = custom;
+            break;
+        }
+        case CCBNodeClass::CustomLabel:
+        {
+            CustomLabel* custom = CustomLabel::create();
+            custom->setFitType(description.fitType);
+            node = custom;
+            customNode = custom;
+            break;
+        }
+        case CCBNodeClass::CustomInput:
+        {
+            CustomInput* custom = CustomInput::create();
+            custom->setInputMode(description.inputMode);
+            custom->setMaxChar(description.maxChar);
+            custom->setFontSize(description.inputFontSize);
+            custom->setPlaceHolder(description.placeHolder);
+            custom->setFontName(description.inputFontName);
+            node = custom;
+            customNode = custom;
+            break;
+        }
+        case CCBNodeClass::CustomScaleSprite:
+        {
+            CustomScaleSprite* custom = CustomScaleSprite::create();
+            node = custom;
+            customNode = custom;
+            break;
+        }
+        case CCBNodeClass::CustomDropDownList:
+        {
+            CustomDropDownList* custom = CustomDropDownList::create();
+            node = custom;
+            customNode = custom;
+            break;
+        }
+    }
+    if(customNode != nullptr)
+    {
+        customNode->setName(description.name);
+        customNode->setEventName(description.eventName);
+        customNode->setScene(description.scene);
+        customNode->setZindex(description.zindex);
+        customNode->getParameters() = description.parameters;
+    }
     
-    animManagers.push_back(ccbReader->getAnimationManager());
+    bool hasContentSize = true;
+    switch(description.nodeClass)
+    {
+        case CCBNodeClass::Sprite:
+        case CCBNodeClass::CustomSprite:
+        case CCBNodeClass::CustomDropDownList:
+        {
+            Sprite* sprite = (Sprite*)node;
+            SpriteFrame* frame = createSpriteFrame(description.frame);
+            if(frame != nullptr)
+            {
+                sprite->setSpriteFrame(frame);
+            }
+            sprite->setFlippedX(description.flippedX);
+            sprite->setFlippedY(description.flippedY);
+            sprite->setBlendFunc(description.blendFunc);
+            //The sprite frame sets the content size, only change it if it was in the file
+            hasContentSize = !sprite->getContentSize().equals(description.contentSize);
+            break;
+        }
+        case CCBNodeClass::Scale9Sprite:
+        case CCBNodeClass::CustomScaleSprite:
+        case CCBNodeClass::CustomInput:
+        {
+            SpriteFrame* frame = createSpriteFrame(description.frame);
+            if(frame != nullptr)
+            {
+                ((ui::Scale9Sprite*)node)->setSpriteFrame(frame, description.capInsets);
+            }
+            break;
+        }
+        case CCBNodeClass::Label:
+        case CCBNodeClass::CustomLabel:
+        {
+            Label* label = (Label*)node;
+            label->setSystemFontName(description.fontName);
+            label->setSystemFontSize(description.fontSize);
+            label->setDimensions(description.dimensions.width, description.dimensions.height);
+            label->setHorizontalAlignment(description.hAlignment);
+            label->setVerticalAlignment(description.vAlignment);
+            label->setString(description.text);
+            label->setBlendFunc(description.blendFunc);
+            //The content size of a label is computed from its text
+            hasContentSize = false;
+            break;
+        }
+        default:
+            break;
+    }
     
-    ccbReader->release();
+    node->setAnchorPoint(description.anchorPoint);
+    node->setIgnoreAnchorPointForPosition(description.ignoreAnchorPoint);
+    if(hasContentSize)
+    {
+        node->setContentSize(description.contentSize);
+    }
+    node->setPosition(description.position);
+    node->setScaleX(description.scaleX);
+    node->setScaleY(description.scaleY);
+    node->setRotationSkewX(description.rotationX);
+    node->setRotationSkewY(description.rotationY);
+    node->setSkewX(description.skewX);
+    node->setSkewY(description.skewY);
+    node->setVisible(description.visible);
+    node->setTag(description.tag);
+    node->setColor(description.color);
+    node->setOpacity(description.opacity);
+    nodeTags[node] = {description.type, customNode};
+    
+    for(const CCBNodeDescription& child : description.children)
+    {
+        node->addChild(instantiateCCBNode(child), child.zOrder);
+    }
+    return node;
+}
+
+#if COCOS2D_DEBUG > 0
+/* Compare a node read by CCBReader with the node instantiated from its description, and their children.
+ Return the first property which differs, empty if they match. Covers what the reader can set on the FenneX nodes,
+ not only the described fields, so that a property missing from the description is caught on the first load instead of diverging on cache hits */
+static std::string compareCCBNodes(Node* read, Node* instantiated)
+{
+    if(typeid(*read) != typeid(*instantiated)) return "class";
+    if(!read->getPosition().equals(instantiated->getPosition())) return "position";
+    if(!read->getAnchorPoint().equals(instantiated->getAnchorPoint())) return "anchorPoint";
+    if(read->isIgnoreAnchorPointForPosition() != instantiated->isIgnoreAnchorPointForPosition()) return "ignoreAnchorPoint";
+    if(!read->getContentSize().equals(instantiated->getContentSize())) return "contentSize";
+    if(read->getScaleX() != instantiated->getScaleX() || read->getScaleY() != instantiated->getScaleY()) return "scale";
+    if(read->getRotationSkewX() != instantiated->getRotationSkewX() || read->getRotationSkewY() != instantiated->getRotationSkewY()) return "rotation";
+    if(read->getSkewX() != instantiated->getSkewX() || read->getSkewY() != instantiated->getSkewY()) return "skew";
+    if(read->isVisible() != instantiated->isVisible()) return "visible";
+    if(read->getTag() != instantiated->getTag()) return "tag";
+    if(read->getName() != instantiated->getName()) return "node name";
+    if(read->getLocalZOrder() != instantiated->getLocalZOrder() || read->getGlobalZOrder() != instantiated->getGlobalZOrder()) return "zOrder";
+    if(read->getColor() != instantiated->getColor() || read->getOpacity() != instantiated->getOpacity()) return "color";
+    if(read->isCascadeColorEnabled() != instantiated->isCascadeColorEnabled() || read->isCascadeOpacityEnabled() != instantiated->isCascadeOpacityEnabled()) return "cascade";
+    if(read->getUserData() != nullptr || read->getUserObject() != nullptr) return "user data";
+    if(read->getNumberOfRunningActions() != instantiated->getNumberOfRunningActions()) return "actions";
+    CustomBaseNode* readCustom = dynamic_cast<CustomBaseNode*>(read);
+    if(readCustom != nullptr)
+    {
+        CustomBaseNode* instantiatedCustom = dynamic_cast<CustomBaseNode*>(instantiated);
+        if(readCustom->getName() != instantiatedCustom->getName()
+           || readCustom->getEventName() != instantiatedCustom->getEventName()
+           || readCustom->getScene() != instantiatedCustom->getScene()
+           || readCustom->getZindex() != instantiatedCustom->getZindex()
+           || readCustom->getParameters() != instantiatedCustom->getParameters())
+        {
+            return "custom properties";
+        }
+    }
+    Sprite* readSprite = dynamic_cast<Sprite*>(read);
+    if(readSprite != nullptr)
+    {
+        Sprite* instantiatedSprite = (Sprite*)instantiated;
+        if(readSprite->getTexture() != instantiatedSprite->getTexture() || !readSprite->getTextureRect().equals(instantiatedSprite->getTextureRect())) return "sprite frame";
+        if(readSprite->isFlippedX() != instantiatedSprite->isFlippedX() || readSprite->isFlippedY() != instantiatedSprite->isFlippedY()) return "flip";
+        if(!(readSprite->getBlendFunc() == instantiatedSprite->getBlendFunc())) return "blendFunc";
+    }
+    Label* readLabel = dynamic_cast<Label*>(read);
+    if(readLabel != nullptr)
+    {
+        Label* instantiatedLabel = (Label*)instantiated;
+        if(readLabel->getString() != instantiatedLabel->getString()
+           || readLabel->getSystemFontName() != instantiatedLabel->getSystemFontName()
+           || readLabel->getSystemFontSize() != instantiatedLabel->getSystemFontSize()
+           || !readLabel->getDimensions().equals(instantiatedLabel->getDimensions())
+           || readLabel->getHorizontalAlignment() != instantiatedLabel->getHorizontalAlignment()
+           || readLabel->getVerticalAlignment() != instantiatedLabel->getVerticalAlignment())
+        {
+            return "label";
+        }
+    }
+    if(read->getChildrenCount() != instantiated->getChildrenCount()) return "children count";
+    for(int i = 0; i < read->getChildrenCount(); i++)
+    {
+        std::string difference = compareCCBNodes(read->getChildren().at(i), instantiated->getChildren().at(i));
+        if(!difference.empty())
+        {
+            return read->getChildren().at(i)->getName() + "/" + difference;
+        }
+    }
+    return "";
+}
+#endif
+
+static size_t getDescriptionMemory(const CCBNodeDescription& description)
+{
+    size_t memory = sizeof(CCBNodeDescription) + description.name.capacity() + description.eventName.capacity() + description.frame.textureFile.capacity()
+        + description.fontName.capacity() + description.text.capacity() + description.placeHolder.capacity() + description.inputFontName.capacity()
+        + description.parameters.size() * (sizeof(std::string) + sizeof(Value));
+    for(const CCBNodeDescription& child : description.children)
+    {
+        memory += getDescriptionMemory(child);
+    }
+    return memory;
+}
+
+//Read the bytes of a template into a rescaled node graph, and describe it when possible so that the next loads instantiate the description
+static Node* readCCBTemplate(CCBTemplate& ccbTemplate, CCBReader*& ccbReader)
+{
+    ccbReader = new CCBReader(getNodeLoaderLibrary(), nullptr, nullptr, &nodeTagger);
+    Node* myNode = ccbReader->readNodeGraphFromData(ccbTemplate.data, nullptr, getLoadSize());
+#if VERBOSE_LOAD_CCB
+    log("ccb file %s loaded, doing rescaling ...", ccbTemplate.filePath.c_str());
+#endif
+    rescaleNodeGraph(myNode);
+    //Animation sequences and callbacks are bound to the read nodes by the CCBAnimationManager, they can't be replayed on a description
+    CCBAnimationManager* animationManager = ccbReader->getAnimationManager();
+    if(ccbTemplate.describable && animationManager->getSequences().empty()
+       && animationManager->getDocumentCallbackNames().empty() && animationManager->getDocumentOutletNames().empty()
+       && animationManager->getKeyframeCallbacks().empty())
+    {
+        auto description = std::make_shared<CCBNodeDescription>();
+        ccbTemplate.describable = describeCCBNode(myNode, *description);
+#if COCOS2D_DEBUG > 0
+        //Parity check between the read graph and the graph the next loads will instantiate. The tags of the instantiated nodes are overwritten by the read ones
+        if(ccbTemplate.describable)
+        {
+            std::unordered_map<Node*, CCBNodeTag> readTags = nodeTags;
+            std::string difference = compareCCBNodes(myNode, instantiateCCBNode(*description));
+            nodeTags = readTags;
+            if(!difference.empty())
+            {
+                log("Warning : CCB template %s differs from the read file (%s), it will be read on each load", ccbTemplate.filePath.c_str(), difference.c_str());
+                ccbTemplate.describable = false;
+            }
+        }
+#endif
+        if(ccbTemplate.describable)
+        {
+            ccbTemplate.description = description;
+            ccbTemplate.data = nullptr;
+        }
+    }
+    return myNode;
+}
+
+void setCCBLoadingTextTransform(std::function<std::string(const std::string&, const std::string&, const ValueMap&)> _textTransform)
+{
+    textTransform = _textTransform;
+}
+
+Panel* loadCCBFromFileToFenneX(std::string file, std::string inPanel, int zIndex)
+{
+    if(inPanel.empty())
+    {
+        animManagers.clear();
+    }
+    timeval startTime;
+    gettimeofday(&startTime, nullptr);
+    CCBTemplateStats& stats = ccbTemplateStats[file];
+    CCBTemplate& ccbTemplate = getCCBTemplate(file, stats);
+    CCBReader* ccbReader = nullptr;
+    Node* myNode = nullptr;
+    if(ccbTemplate.description != nullptr)
+    {
+        myNode = instantiateCCBNode(*ccbTemplate.description);
+    }
+    else if(ccbTemplate.data != nullptr)
+    {
+        myNode = readCCBTemplate(ccbTemplate, ccbReader);
+    }
     
 #if VERBOSE_PERFORMANCE_TIME
+    timeval middleTime;
+    gettimeofday(&middleTime, nullptr);
+    log("CCB file %s read or instantiated in %f ms", file.c_str(), getTimeDifferenceMS(startTime, middleTime));
+#endif
+    
+    //Objects are sorted once they are all created
+    GraphicLayer* layer = GraphicLayer::sharedLayer();
+    Panel* parent = nullptr;
+    std::vector<RawObject*> objects;
+    {
+        GraphicLayer::BatchScope batch(layer);
+        if(!inPanel.empty())
+        {
+            myNode->setContentSize(Size(0, 0));
+            parent = layer->createPanelWithNode(inPanel, myNode, zIndex);
+        }
+        
+        loadedObjects = &objects;
+        loadNodeToFenneX(file, myNode, parent);
+        loadedObjects = nullptr;
+        nodeTags.clear();
+        //Reorder while the objects are still pending, so that it only changes their sort key
+        for(RawObject* obj : objects)
+        {
+            if(obj->getZOrder() != 0)
+            {
+                layer->reorderChild(obj, obj->getZOrder());
+            }
+        }
+    }
+    linkInputLabels(objects);
+    
+    //Instantiated descriptions don't have any animation sequence, so they don't need an animation manager
+    if(ccbReader != nullptr)
+    {
+        animManagers.push_back(ccbReader->getAnimationManager());
+        ccbReader->release();
+    }
+    
     timeval endTime;
     gettimeofday(&endTime, nullptr);
+    stats.loadTime += getTimeDifferenceMS(startTime, endTime);
+#if VERBOSE_PERFORMANCE_TIME
     log("Node %s loaded to FenneX in %f ms, total with load file : %f ms", file.c_str(), getTimeDifferenceMS(middleTime, endTime), getTimeDifferenceMS(startTime, endTime));
 #endif
     return parent;
 }
 
+void tagCCBNode(Node* node, NodeLoader* loader, CustomBaseNode* customNode)
+{
+    auto type = loaderTypes.find(loader);
+    nodeTags[node] = {type != loaderTypes.end() ? type->second : CCBNodeType::Panel, customNode};
+}
+
+//Use the tag recorded while reading the node if there is one, otherwise check its class
+static CCBNodeType getCCBNodeType(Node* node, CustomBaseNode*& customNode)
+{
+    auto tag = nodeTags.find(node);
+    if(tag != nodeTags.end())
+    {
+        customNode = tag->second.customNode;
+        return tag->second.type;
+    }
+    customNode = dynamic_cast<CustomBaseNode*>(node);
+    if(isKindOfClass(node, Label)) return CCBNodeType::Label;
+    if(isKindOfClass(node, CustomDropDownList)) return CCBNodeType::DropDownList;
+    if(isKindOfClass(node, CustomInput)) return CCBNodeType::Input;
+    if(isKindOfClass(node, ui::Scale9Sprite)) return CCBNodeType::ScaleSprite;
+    if(isKindOfClass(node, Sprite)) return CCBNodeType::Image;
+    if(isKindOfClass(node, ui::EditBox)) return CCBNodeType::Ignored;
+    return CCBNodeType::Panel;
+}
+
 void loadNodeToFenneX(std::string file, Node* baseNode, Panel* parent)
 {
     GraphicLayer* layer = GraphicLayer::sharedLayer();
@@ -287,78 +993,94 @@ void loadNodeToFenneX(std::string file, Node* baseNode, Panel* parent)
 #if VERBOSE_LOAD_CCB
         log("doing child %d from parent %s ...", i, parent != nullptr ? parent->getName() != "" ? parent->getName().c_str() : "Panel" : "base layer");
 #endif
+        CustomBaseNode* customNode = nullptr;
         RawObject* result = nullptr;
-        if(isKindOfClass(node, Label))
+        switch(getCCBNodeType(node, customNode))
         {
-            Label* label = (Label*)node;
+            case CCBNodeType::Label:
+            {
+                Label* label = (Label*)node;
 #if VERBOSE_LOAD_CCB
-            log("label, font : %s", label->getSystemFontName().c_str());
+                log("label, font : %s", label->getSystemFontName().c_str());
 #endif
-            ValueMap& parameters = isKindOfClass(label, CustomBaseNode) ? dynamic_cast<CustomBaseNode*>(label)->getParameters() : emptyParams;
-            
-            if(textTransform)
-            {
-                std::string transformed = textTransform(file, label->getString(), parameters);
-                if(transformed != label->getString())
-                {//Don't replace the string if it's the same, as it may only be a key, not a real label
-                    label->setString(transformed);
+                ValueMap& parameters = customNode != nullptr ? customNode->getParameters() : emptyParams;
+                
+                if(textTransform)
+                {
+                    std::string transformed = textTransform(file, label->getString(), parameters);
+                    if(transformed != label->getString())
+                    {//Don't replace the string if it's the same, as it may only be a key, not a real label
+                        label->setString(transformed);
+                    }
                 }
+                result = layer->createLabelTTFromLabel(label, parent);
+                break;
             }
-            result = layer->createLabelTTFromLabel(label, parent);
-        }
-        else if(isKindOfClass(node, CustomDropDownList))
-        {
+            case CCBNodeType::DropDownList:
+            {
 #if VERBOSE_LOAD_CCB
-            log("DropDownList");
+                log("DropDownList");
 #endif
-            Sprite* sprite = (Sprite*)node;
-            result = layer->createDropDownListFromSprite(sprite, parent);
-        }
-        else if(isKindOfClass(node, CustomInput))
-        {
+                Sprite* sprite = (Sprite*)node;
+                result = layer->createDropDownListFromSprite(sprite, parent);
+                break;
+            }
+            case CCBNodeType::Input:
+            {
 #if VERBOSE_LOAD_CCB
-            log("input label");
+                log("input label");
 #endif
-            ui::Scale9Sprite* sprite = (ui::Scale9Sprite*)node;
-            
-            ValueMap& parameters = isKindOfClass(sprite, CustomBaseNode) ? dynamic_cast<CustomBaseNode*>(sprite)->getParameters() : emptyParams;
-            
-            
-            result = layer->createInputLabelFromScale9Sprite(sprite, parent);
-            
-            if(textTransform)
-            {
-                std::string placeHolder = isKindOfClass(sprite, CustomInput) ? ((CustomInput*) sprite)->getPlaceHolder() : "";
-                std::string transformed = textTransform(file, placeHolder, parameters);
-                if(transformed != placeHolder)
-                {//Don't replace the string if it's the same, as it may only be a key, not a real label
-                    ((InputLabel*) result)->setInitialText(transformed);
+                CustomInput* sprite = (CustomInput*)node;
+                
+                ValueMap& parameters = customNode != nullptr ? customNode->getParameters() : emptyParams;
+                
+                
+                result = layer->createInputLabelFromScale9Sprite(sprite, parent);
+                
+                if(textTransform)
+                {
+                    std::string placeHolder = sprite->getPlaceHolder();
+                    std::string transformed = textTransform(file, placeHolder, parameters);
+                    if(transformed != placeHolder)
+                    {//Don't replace the string if it's the same, as it may only be a key, not a real label
+                        ((InputLabel*) result)->setInitialText(transformed);
+                    }
                 }
+                i--;
+                break;
             }
-            i--;
-        }
-        else if(isKindOfClass(node, ui::Scale9Sprite))
-        {
+            case CCBNodeType::ScaleSprite:
+            {
 #if VERBOSE_LOAD_CCB
-            log("scale sprite");
+                log("scale sprite");
 #endif
-            ui::Scale9Sprite* sprite = (ui::Scale9Sprite*)node;
-            result = layer->createCustomObjectFromNode(sprite, parent);
-        }
-        else if(isKindOfClass(node, Sprite))
-        {
+                ui::Scale9Sprite* sprite = (ui::Scale9Sprite*)node;
+                result = layer->createCustomObjectFromNode(sprite, parent);
+                break;
+            }
+            case CCBNodeType::Image:
+            {
 #if VERBOSE_LOAD_CCB
-            log("image");
+                log("image");
 #endif
-            Sprite* sprite = (Sprite*)node;
-            result = layer->createImageFromSprite(sprite, parent);
-        }
-        else if(!isKindOfClass(node, ui::EditBox))
-        {
+                Sprite* sprite = (Sprite*)node;
+                result = layer->createImageFromSprite(sprite, parent);
+                break;
+            }
+            case CCBNodeType::Panel:
+            {
 #if VERBOSE_LOAD_CCB
-            log("Edit Box");
+                log("Panel");
 #endif
-            result = layer->createPanelFromNode(file, node, parent);
+                result = layer->createPanelFromNode(file, node, parent);
+                break;
+            }
+            case CCBNodeType::Ignored:
+                break;
+        }
+        if(result != nullptr && loadedObjects != nullptr)
+        {
+            loadedObjects->push_back(result);
         }
 #if VERBOSE_LOAD_CCB
         if(result != nullptr)
@@ -387,13 +1109,18 @@ void reorderZindex()
 }
 
 void linkInputLabels()
+{
+    Vector<RawObject*> children = GraphicLayer::sharedLayer()->all();
+    linkInputLabels(std::vector<RawObject*>(children.begin(), children.end()));
+}
+
+void linkInputLabels(const std::vector<RawObject*>& objects)
 {
     GraphicLayer* layer = GraphicLayer::sharedLayer();
-    Vector<RawObject*> children = layer->all();
-    for(RawObject* child : children)
+    for(RawObject* child : objects)
     {
         //Force actualization of content size and fontSize after everything is loaded because the nodeToWorldTransform is only right after
-        if(isKindOfClass(child, InputLabel))
+        if(isObjectOfType<InputLabel>(child))
         {
             InputLabel* input = (InputLabel*)child;
             child->getNode()->setContentSize(child->getNode()->getContentSize());
@@ -402,16 +1129,17 @@ void linkInputLabels()
                 input->setFontSize(input->getOriginalInfos()->getFontSize());
             }
         }
-        if((isKindOfClass(child, DropDownList)) && isValueOfType(child->getEventInfos()["LinkTo"], STRING))
+        else if(isObjectOfType<DropDownList>(child) && isValueOfType(child->getEventInfo("LinkTo"), STRING))
         {
             DropDownList* dropDownList = (DropDownList*)child;
             if(dropDownList->getLinkTo() == nullptr)
             {
-                std::string linkTo = child->getEventInfos()["LinkTo"].asString();
+                std::string linkTo = child->getEventInfo("LinkTo").asString();
                 Panel* parent = layer->getContainingPanel(dropDownList);
-                for(RawObject* obj : parent != nullptr ? parent->getChildren() : layer->all())
+                //Without a parent, use the name index rather than going through the whole layer
+                for(RawObject* obj : parent != nullptr ? parent->getChildren() : layer->all(linkTo))
                 {
-                    if(obj->getName() == linkTo && isKindOfClass(obj, LabelTTF)) dropDownList->setLinkTo((LabelTTF*)obj);
+                    if(obj->getName() == linkTo && isObjectOfType<LabelTTF>(obj)) dropDownList->setLinkTo((LabelTTF*)obj);
                 }
             }
         }
@@ -448,6 +1176,169 @@ bool CCBLoaderIsPhoneLayout()
     return isPhoneLayout;
 }
 
+void CCBLoaderPurgeTemplates(const std::string& file)
+{
+    for(auto it = ccbTemplates.begin(); it != ccbTemplates.end();)
+    {
+        if(file.empty() || it->first.file == file)
+        {
+            it = ccbTemplates.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+size_t CCBLoaderGetTemplatesMemory()
+{
+    size_t memory = 0;
+    for(const auto& it : ccbTemplates)
+    {
+        memory += sizeof(CCBTemplate) + it.first.file.capacity() + it.second.filePath.capacity();
+        if(it.second.data != nullptr)
+        {
+            memory += it.second.data->getSize();
+        }
+        if(it.second.description != nullptr)
+        {
+            memory += getDescriptionMemory(*it.second.description);
+        }
+    }
+    return memory;
+}
+
+const std::map<std::string, CCBTemplateStats>& CCBLoaderGetTemplateStats()
+{
+    return ccbTemplateStats;
+}
+
+void CCBLoaderLogTemplateStats()
+{
+    log("CCB templates: %d cached, using %d bytes", (int)ccbTemplates.size(), (int)CCBLoaderGetTemplatesMemory());
+    for(const auto& it : ccbTemplateStats)
+    {
+        log("    %s: %ld hits, %ld misses, %f ms total, %f ms average", it.first.c_str(), it.second.hits, it.second.misses, it.second.loadTime, it.second.loadTime / (it.second.hits + it.second.misses));
+    }
+}
+
+std::string CCBLoaderResolveFile(const std::string& file)
+{
+    std::string filePath;
+    return resolveCCBFilePath(file, filePath) ? FileUtils::getInstance()->fullPathForFilename(filePath) : "";
+}
+
+bool CCBLoaderHasTemplate(const std::string& file)
+{
+    return ccbTemplates.find(getCCBTemplateKey(file)) != ccbTemplates.end();
+}
+
+void CCBLoaderAddTemplate(const std::string& file, const std::string& filePath, std::shared_ptr<Data> data)
+{
+    CCBTemplate& ccbTemplate = ccbTemplates[getCCBTemplateKey(file)];
+    ccbTemplate.filePath = filePath;
+    ccbTemplate.data = data;
+}
+
+size_t CCBLoaderDescribeTemplate(const std::string& file)
+{
+    auto it = ccbTemplates.find(getCCBTemplateKey(file));
+    if(it == ccbTemplates.end() || it->second.description != nullptr || it->second.data == nullptr || !it->second.describable)
+    {
+        return 0;
+    }
+    CCBReader* ccbReader = nullptr;
+    //The node graph is only read to be described, it is autoreleased at the end of the frame
+    readCCBTemplate(it->second, ccbReader);
+    nodeTags.clear();
+    ccbReader->release();
+    return it->second.description != nullptr ? getDescriptionMemory(*it->second.description) : 0;
+}
+
+//Same encoding as CCBReader::readInt(false): unary bits count, then the bits of the value + 1, least significant bit of each byte first
+static bool readCCBInt(const unsigned char* bytes, ssize_t size, ssize_t& currentByte, int& value)
+{
+    int currentBit = 0;
+    auto getBit = [&](bool& bit) {
+        if(currentByte >= size)
+        {
+            return false;
+        }
+        bit = (bytes[currentByte] & (1 << currentBit)) != 0;
+        if(++currentBit >= 8)
+        {
+            currentBit = 0;
+            currentByte++;
+        }
+        return true;
+    };
+    int numBits = 0;
+    bool bit = false;
+    while(getBit(bit) && !bit)
+    {
+        numBits++;
+    }
+    if(!bit || numBits > 31)
+    {
+        return false;
+    }
+    long long current = 0;
+    for(int a = numBits - 1; a >= 0; a--)
+    {
+        if(!getBit(bit))
+        {
+            return false;
+        }
+        if(bit)
+        {
+            current |= 1LL << a;
+        }
+    }
+    current |= 1LL << numBits;
+    value = (int)(current - 1);
+    //Align on the next byte
+    if(currentBit != 0)
+    {
+        currentByte++;
+    }
+    return true;
+}
+
+std::vector<std::string> CCBLoaderGetStrings(const Data& data)
+{
+    std::vector<std::string> strings;
+    const unsigned char* bytes = data.getBytes();
+    ssize_t size = data.getSize();
+    //Same check as CCBReader: the "ccbi" magic is stored byte swapped
+    if(size < 4 || memcmp(bytes, "ibcc", 4) != 0)
+    {
+        return strings;
+    }
+    ssize_t currentByte = 4;
+    int version = 0;
+    int stringsCount = 0;
+    //Version, then the JS controlled flag on one byte
+    if(!readCCBInt(bytes, size, currentByte, version) || version != CCB_VERSION || ++currentByte > size
+       || !readCCBInt(bytes, size, currentByte, stringsCount))
+    {
+        return strings;
+    }
+    strings.reserve(stringsCount);
+    for(int i = 0; i < stringsCount && currentByte + 2 <= size; i++)
+    {
+        int length = bytes[currentByte] << 8 | bytes[currentByte + 1];
+        currentByte += 2;
+        if(currentByte + length > size)
+        {
+            break;
+        }
+        strings.push_back(std::string((const char*)bytes + currentByte, length));
+        currentByte += length;
+    }
+    return strings;
+}
+
 std::vector<CCBAnimationManager*>& getAnimationManagers()
 {
     return animManagers;
@@ -34,6 +34,7 @@ USING_NS_CC;
 #include "Panel.h"
 
 NS_FENNEX_BEGIN
+class CustomBaseNode;
 
 /*
  Every text loaded (for Labels and InputLabels) will be passed through this function.
@@ -49,6 +50,9 @@ void setCCBLoadingTextTransform(std::function<std::string(const std::string&, co
  Specify a panel if you want the file to be loaded in a panel rather than as GraphicLayer base node (for a popup for example)
  Note : Label in CocosBuilder must be added in the same resolution as DesignResolution (from AppMacros.h)
  
+ Objects are created in a single GraphicLayer batch, then reordered and linked in the same pass: only the loaded objects are visited,
+ so the load time doesn't depend on what is already on the layer. reorderZindex and linkInputLabels are not needed afterward.
+ 
  Refer to loadNodeToFenneX for more info on the mapping
  */
 Panel* loadCCBFromFileToFenneX(std::string file, std::string inPanel = "", int zIndex = 0);
@@ -66,9 +70,30 @@ Panel* loadCCBFromFileToFenneX(std::string file, std::string inPanel = "", int z
  */
 void loadNodeToFenneX(std::string file, Node* baseNode, Panel* parent = nullptr);
 //It is required to do another pass after loadNodeToFenneX to reorder Zindex (especially because of InputLabel which are created and added at the end instead of the right place)
+//Already done by loadCCBFromFileToFenneX, only needed when calling loadNodeToFenneX directly
 void reorderZindex();
 //It is required to do another pass after loadNodeToFenneX to have the input labels linked to their LabelTTF
+//Already done by loadCCBFromFileToFenneX, only needed when calling loadNodeToFenneX directly
 void linkInputLabels();
+//Same, only for the objects passed
+void linkInputLabels(const std::vector<RawObject*>& objects);
+
+//Type of the FenneX object a node from a CCB is loaded as
+enum class CCBNodeType
+{
+    Panel,
+    Label,
+    Input,
+    DropDownList,
+    ScaleSprite,
+    Image,
+    Ignored,
+};
+/* Record the type of a node while it is read, from the loader which created it, so that loadNodeToFenneX doesn't rely on RTTI
+ Called by CustomBaseNode for custom nodes, and by the CCBReader listener for others. customNode is the node as a CustomBaseNode, if it is one
+ Nodes which are not tagged (not coming from loadCCBFromFileToFenneX) are typed by checking their class
+ */
+void tagCCBNode(Node* node, cocosbuilder::NodeLoader* loader, CustomBaseNode* customNode);
 
 void CCBLoaderSetScale(float scale);
 float CCBLoaderGetScale();
@@ -81,6 +106,38 @@ cocos2d::Size CCBLoaderGetLoadSize();
 void CCBLoaderSetPhoneLayout(bool usePhone);
 bool CCBLoaderIsPhoneLayout();
 
+/* Loaded .ccbi files are cached as templates, keyed by file, phone layout, load size and loading scale,
+ so that loading the same file again (list cells for example) doesn't read and resolve it again.
+ After the first load, a template holds a plain data description of the read and rescaled node graph (classes, properties, sprite frames as texture file and rect),
+ which is instantiated by the next loads instead of parsing the file and rescaling it again.
+ Files using other node classes than the FenneX custom nodes and the base cocos ones, or having animation sequences or callbacks, keep their bytes and are read on each load.
+ In debug builds, the first instantiation is compared with the read node graph, and the file keeps being read if they differ.
+ */
+struct CCBTemplateStats
+{
+    long hits;
+    long misses;
+    double loadTime; //Total time spent in loadCCBFromFileToFenneX for this file, in ms
+};
+//Purge the templates of a file (any layout), or all templates if file is empty
+void CCBLoaderPurgeTemplates(const std::string& file = "");
+//Memory used by cached templates, in bytes
+size_t CCBLoaderGetTemplatesMemory();
+//Stats per file passed to loadCCBFromFileToFenneX. They are kept when templates are purged
+const std::map<std::string, CCBTemplateStats>& CCBLoaderGetTemplateStats();
+void CCBLoaderLogTemplateStats();
+
+/* Used to prepare templates ahead of time (see SceneSwitcher::prepareScene): the file is resolved on the cocos thread,
+ read on another thread, then added to the templates for the current loading parameters */
+//Full path of the .ccbi used for file with the current layout, empty if it doesn't exist
+std::string CCBLoaderResolveFile(const std::string& file);
+bool CCBLoaderHasTemplate(const std::string& file);
+void CCBLoaderAddTemplate(const std::string& file, const std::string& filePath, std::shared_ptr<Data> data);
+//Read an added template and build its description, so that loading it only instantiates nodes. Return the description memory, 0 if it wasn't described
+size_t CCBLoaderDescribeTemplate(const std::string& file);
+//Strings of a .ccbi string cache: class and property names, texts, sprite and font files. Empty if the data isn't a valid .ccbi. Thread safe
+std::vector<std::string> CCBLoaderGetStrings(const Data& data);
+
 std::vector<cocosbuilder::CCBAnimationManager*>& getAnimationManagers();
 NS_FENNEX_END
 
@@ -60,6 +60,9 @@ THE SOFTWARE.
 #include "LazyLoader.h"
 #include "Panel.h"
 #include "RawObject.h"
+#include "SpatialGrid.h"
+#include "TextureBudget.h"
+#include "TextureLoader.h"
 
 //Scenes
 #include "SceneSwitcher.h"
@@ -69,6 +72,7 @@ THE SOFTWARE.
 #include "InactivityTimer.h"
 #include "Pausable.h"
 #include "PListPersist.h"
+#include "Profiler.h"
 #include "RandomHelper.h"
 #include "Shorteners.h"
 #include "SynchronousReleaser.h"
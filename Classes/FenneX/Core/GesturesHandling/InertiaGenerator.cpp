@@ -217,8 +217,8 @@ void InertiaGenerator::scrollingEnded(Vec2 offset, Vec2 position, Vector<Touch*>
                 log("inertiaOffset : %f, %f", inertiaOffset.x, inertiaOffset.y);
 #endif
                 inertiaTargets.pushBack(target);
-                inertiaParameters.pushBack(Inertia::create(inertiaOffset, position, !target->getEventInfos()["isVertical"].isNull()
-                                                                                    && target->getEventInfos()["isVertical"].asBool()));
+                inertiaParameters.pushBack(Inertia::create(inertiaOffset, position, !target->getEventInfo(EventInfoKey::IsVertical).isNull()
+                                                                                    && target->getEventInfo(EventInfoKey::IsVertical).asBool()));
             }
             else
             {
@@ -57,11 +57,13 @@ void CustomObject::setNode(Node* node)
 CustomObject::CustomObject():
 delegate(nullptr)
 {
+    typeFlags |= TypeCustomObject;
     
 }
 
 CustomObject::CustomObject(Node* child)
 {
+    typeFlags |= TypeCustomObject;
     delegate = child;
     if(delegate == nullptr)
     {
@@ -72,6 +74,7 @@ CustomObject::CustomObject(Node* child)
 
 CustomObject::CustomObject(Node* child, Vec2 location)
 {
+    typeFlags |= TypeCustomObject;
     delegate = child;
     if(delegate == nullptr)
     {
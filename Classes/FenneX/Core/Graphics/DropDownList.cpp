@@ -40,24 +40,28 @@ void DropDownList::setLinkTo(LabelTTF* var)
 DropDownList::DropDownList()
     :Image()
 {
+    typeFlags |= TypeDropDownList;
     init();
 }
 
 DropDownList::DropDownList(std::string filename, Vec2 location)
     :Image(filename, location)
 {
+    typeFlags |= TypeDropDownList;
     init();
 }
 
 DropDownList::DropDownList(std::string filename, Vec2 location, int capacity)
 :Image(filename, location, capacity)
 {
+    typeFlags |= TypeDropDownList;
     init();
 }
 
 DropDownList::DropDownList(Sprite* sprite)
     :Image(sprite)
 {
+    typeFlags |= TypeDropDownList;
     init();
 }
 
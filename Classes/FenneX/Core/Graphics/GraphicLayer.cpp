@@ -34,6 +34,7 @@ NS_FENNEX_BEGIN
 static GraphicLayer *s_SharedLayer = nullptr;
 
 static std::function<void(RawObject*)> onObjectCreated = nullptr;
+static std::function<void(const Vector<RawObject*>&)> onObjectsCreated = nullptr;
 
 GraphicLayer* GraphicLayer::sharedLayer(void)
 {
@@ -51,6 +52,125 @@ void GraphicLayer::setOnObjectCreated(std::function<void(RawObject*)> callback)
     onObjectCreated = callback;
 }
 
+void GraphicLayer::setOnObjectsCreated(std::function<void(const Vector<RawObject*>&)> callback)
+{
+    onObjectsCreated = callback;
+}
+
+void GraphicLayer::beginBatch()
+{
+    batchDepth++;
+}
+
+void GraphicLayer::commitBatch()
+{
+    CCAssert(batchDepth > 0, "in GraphicLayer commitBatch : no batch to commit, call beginBatch first");
+    batchDepth--;
+    if(batchDepth > 0)
+    {
+        return;
+    }
+    //Parents keys must be computed before their children ones
+    std::vector<std::pair<int, RawObject*>> pendingObjects;
+    pendingObjects.reserve(batchObjects.size());
+    for(RawObject* obj : batchObjects)
+    {
+        int depth = 0;
+        for(Panel* parent = this->getContainingPanel(obj); parent != nullptr; parent = this->getContainingPanel(parent))
+        {
+            depth++;
+        }
+        pendingObjects.push_back(std::make_pair(depth, obj));
+    }
+    std::stable_sort(pendingObjects.begin(), pendingObjects.end(), [](const std::pair<int, RawObject*>& a, const std::pair<int, RawObject*>& b) {
+        return a.first < b.first;
+    });
+    std::vector<RawObject*> sortedObjects;
+    sortedObjects.reserve(pendingObjects.size());
+    for(const std::pair<int, RawObject*>& pending : pendingObjects)
+    {
+        RawObject* obj = pending.second;
+        auto it = batchOrders.find(obj);
+        //Objects destroyed during the batch are not in batchOrders anymore, and duplicates are only keyed once
+        if(it != batchOrders.end())
+        {
+            Panel* parent = this->getContainingPanel(obj);
+            if(parent != nullptr)
+            {
+                obj->orderKey = parent->orderKey;
+            }
+            else
+            {
+                obj->orderKey.clear();
+            }
+            obj->orderKey.push_back(it->second);
+            batchOrders.erase(it);
+            sortedObjects.push_back(obj);
+        }
+    }
+    batchObjects.clear();
+    
+    std::sort(sortedObjects.begin(), sortedObjects.end(), isBehind);
+    //Objects created together usually end up next to each other, so the position after the previous one is a good hint
+    auto hint = storedObjects.end();
+    for(RawObject* obj : sortedObjects)
+    {
+        hint = std::next(storedObjects.insert(hint, obj));
+    }
+    orderedObjectsDirty = orderedObjectsDirty || !sortedObjects.empty();
+    
+    Vector<RawObject*> created;
+    for(RawObject* obj : batchCreated)
+    {
+        if(this->containsObject(obj))
+        {
+            created.pushBack(obj);
+        }
+    }
+    batchCreated.clear();
+    if(onObjectsCreated != nullptr)
+    {
+        onObjectsCreated(created);
+    }
+    else if(onObjectCreated != nullptr)
+    {
+        for(RawObject* obj : created)
+        {
+            onObjectCreated(obj);
+        }
+    }
+}
+
+GraphicLayer::BatchScope::BatchScope(GraphicLayer* layer) :
+layer(layer),
+generation(layer->batchGeneration)
+{
+    layer->beginBatch();
+}
+
+GraphicLayer::BatchScope::~BatchScope()
+{
+    if(layer->batchGeneration == generation)
+    {
+        layer->commitBatch();
+    }
+}
+
+void GraphicLayer::notifyObjectCreated(RawObject* obj)
+{
+    if(batchDepth > 0)
+    {
+        if(obj != nullptr)
+        {
+            batchCreated.pushBack(obj);
+        }
+    }
+    else
+    {
+        IFEXIST(onObjectCreated)(obj);
+    }
+}
+
 void GraphicLayer::init()
 {
     nextAvailableId = 0;
@@ -59,6 +179,10 @@ void GraphicLayer::init()
     layer->retain();
     clock = 0;
     isUpdating = false;
+    nextOrderSequence = 0;
+    orderedObjectsDirty = false;
+    batchDepth = 0;
+    batchGeneration = 0;
 }
 
 GraphicLayer::~GraphicLayer()
@@ -93,7 +217,26 @@ void GraphicLayer::renderOnLayer(Scene* destination)
     {
         layer->removeFromParentAndCleanup(true);
     }
+    for(RawObject* obj : storedObjects)
+    {
+        obj->release();
+    }
+    for(auto& pending : batchOrders)
+    {
+        pending.first->release();
+    }
     storedObjects.clear();
+    batchDepth = 0;
+    batchGeneration++;
+    batchObjects.clear();
+    batchOrders.clear();
+    batchCreated.clear();
+    orderedObjects.clear();
+    orderedObjectsDirty = false;
+    objectsById.clear();
+    objectsByName.clear();
+    spatialIndex.clear();
+    boundsToRefresh.clear();
     destination->addChild(layer);
     layer->setScale(SceneSwitcher::sharedSwitcher()->getScale());
 }
@@ -109,7 +252,7 @@ void GraphicLayer::stop()
     this->stopRenderOnLayer(relatedScene, false);
 }
 
-Vec2 getPos(ValueMap values)
+Vec2 getPos(const ValueMap& values)
 {
     Vec2 pos = Vec2(0, 0);
     if(values.find("X") != values.end() && values.at("X").getType() == Value::Type::FLOAT)
@@ -123,7 +266,7 @@ Vec2 getPos(ValueMap values)
     return pos;
 }
 
-int getZindex(ValueMap values)
+int getZindex(const ValueMap& values)
 {
     if(values.find("Zindex") != values.end() && values.at("Zindex").getType() == Value::Type::INTEGER)
     {
@@ -132,7 +275,7 @@ int getZindex(ValueMap values)
     return 0;
 }
 
-Image* GraphicLayer::createImage(std::string imageFile, ValueMap values)
+Image* GraphicLayer::createImage(const std::string& imageFile, const ValueMap& values)
 {
 #if VERBOSE_LOAD_CCB
     log("Creating Image %s", imageFile.c_str());
@@ -153,11 +296,11 @@ Image* GraphicLayer::createImage(std::string imageFile, ValueMap values)
 #if VERBOSE_LOAD_CCB
     log("Ended creating Image");
 #endif
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
-Image* GraphicLayer::createAnimatedImage(std::string spriteSheetFile, int capacity, ValueMap values)
+Image* GraphicLayer::createAnimatedImage(const std::string& spriteSheetFile, int capacity, const ValueMap& values)
 {
 #if VERBOSE_LOAD_CCB
     log("Creating animated Image %s", spriteSheetFile.c_str());
@@ -178,7 +321,7 @@ Image* GraphicLayer::createAnimatedImage(std::string spriteSheetFile, int capaci
 #if VERBOSE_LOAD_CCB
     log("Ended creating animated Image");
 #endif
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
@@ -187,20 +330,20 @@ Image* GraphicLayer::createImageFromSprite(Sprite* sprite, Panel* parent)
     Image* obj = new Image(sprite);
     if(obj != nullptr)
     {
-        storedObjects.pushBack(obj);
         if(parent != nullptr)
         {
             parent->addChild(obj);
             childsParents[obj->getID()] = parent;
         }
+        this->insertStoredObject(obj, obj->getZOrder());
         obj->release();
     }
     this->loadBaseNodeAttributes(dynamic_cast<CustomBaseNode*>(sprite), obj);
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
-CustomObject* GraphicLayer::createCustomObject(Node* delegate, ValueMap values)
+CustomObject* GraphicLayer::createCustomObject(Node* delegate, const ValueMap& values)
 {
 #if VERBOSE_LOAD_CCB
     log("Creating CustomObject");
@@ -221,7 +364,7 @@ CustomObject* GraphicLayer::createCustomObject(Node* delegate, ValueMap values)
 #if VERBOSE_LOAD_CCB
     log("Ended creating CustomObject");
 #endif
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
@@ -230,20 +373,20 @@ CustomObject* GraphicLayer::createCustomObjectFromNode(Node* node, Panel* parent
     CustomObject* obj = new CustomObject(node);
     if(obj != nullptr)
     {
-        storedObjects.pushBack(obj);
         if(parent != nullptr)
         {
             parent->addChild(obj);
             childsParents[obj->getID()] = parent;
         }
+        this->insertStoredObject(obj, obj->getZOrder());
         obj->release();
     }
     this->loadBaseNodeAttributes(dynamic_cast<CustomBaseNode*>(node), obj);
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
-Size getDimensions(ValueMap values)
+Size getDimensions(const ValueMap& values)
 {
     if(values.find("DimX") != values.end() && values.at("DimX").getType() == Value::Type::FLOAT &&
        values.find("DimY") != values.end() && values.at("DimY").getType() == Value::Type::FLOAT)
@@ -253,7 +396,7 @@ Size getDimensions(ValueMap values)
     return Size(0, 0);
 }
 
-TextHAlignment getAlignment(ValueMap values)
+TextHAlignment getAlignment(const ValueMap& values)
 {
     if(values.find("TextFormat") != values.end() && values.at("TextFormat").getType() == Value::Type::INTEGER)
     {
@@ -262,7 +405,7 @@ TextHAlignment getAlignment(ValueMap values)
     return TextHAlignment::CENTER;
 }
 
-LabelTTF* GraphicLayer::createLabelTTF(std::string label, std::string fontFile, ValueMap values)
+LabelTTF* GraphicLayer::createLabelTTF(const std::string& label, const std::string& fontFile, const ValueMap& values)
 {
 #if VERBOSE_LOAD_CCB
     log("Creating LabelTTF %s", label.c_str());
@@ -283,7 +426,7 @@ LabelTTF* GraphicLayer::createLabelTTF(std::string label, std::string fontFile,
 #if VERBOSE_LOAD_CCB
     log("Ended creating LabelTTF");
 #endif
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
@@ -292,16 +435,16 @@ LabelTTF* GraphicLayer::createLabelTTFromLabel(Label* cocosLabel, Panel* parent)
     LabelTTF* obj = new LabelTTF(cocosLabel);
     if(obj != nullptr)
     {
-        storedObjects.pushBack(obj);
         if(parent != nullptr)
         {
             parent->addChild(obj);
             childsParents[obj->getID()] = parent;
         }
+        this->insertStoredObject(obj, obj->getZOrder());
         obj->release();
     }
     this->loadBaseNodeAttributes(dynamic_cast<CustomBaseNode*>(cocosLabel), obj);
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
@@ -313,9 +456,9 @@ InputLabel* GraphicLayer::createInputLabelFromScale9Sprite(ui::Scale9Sprite* coc
         //TODO : find a way to add the label at the right place in cocos hierarchy
         if(parent != nullptr)
         {
-            storedObjects.pushBack(obj);
             parent->addChild(obj);
             childsParents[obj->getID()] = parent;
+            this->insertStoredObject(obj, obj->getZOrder());
         }
         else
         {
@@ -325,11 +468,11 @@ InputLabel* GraphicLayer::createInputLabelFromScale9Sprite(ui::Scale9Sprite* coc
     }
     this->loadBaseNodeAttributes(dynamic_cast<CustomBaseNode*>(cocosSprite), obj);
     
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
-Panel* GraphicLayer::createPanel(std::string name, ValueMap values)
+Panel* GraphicLayer::createPanel(const std::string& name, const ValueMap& values)
 {
     
 #if VERBOSE_LOAD_CCB
@@ -351,31 +494,31 @@ Panel* GraphicLayer::createPanel(std::string name, ValueMap values)
 #if VERBOSE_LOAD_CCB
     log("Ended creating Panel");
 #endif
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
-Panel* GraphicLayer::createPanelFromNode(std::string file, Node* cocosNode, Panel* parent)
+Panel* GraphicLayer::createPanelFromNode(const std::string& file, Node* cocosNode, Panel* parent)
 {
     Panel* obj = new Panel(cocosNode);
     if(obj != nullptr)
     {
-        storedObjects.pushBack(obj);
         storedPanels.pushBack(obj);
         if(parent != nullptr)
         {
             parent->addChild(obj);
             childsParents[obj->getID()] = parent;
         }
+        this->insertStoredObject(obj, obj->getZOrder());
         obj->release();
     }
     this->loadBaseNodeAttributes(dynamic_cast<CustomBaseNode*>(cocosNode), obj);
     loadNodeToFenneX(file, obj->getNode(), obj);
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
-Panel* GraphicLayer::createPanelWithNode(std::string name, Node* panelNode, int zOrder)
+Panel* GraphicLayer::createPanelWithNode(const std::string& name, Node* panelNode, int zOrder)
 {
     Panel* obj = new Panel(panelNode, name);
     if(obj != nullptr)
@@ -383,7 +526,7 @@ Panel* GraphicLayer::createPanelWithNode(std::string name, Node* panelNode, int
         this->addObject(obj, zOrder);
         obj->release();
     }
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
@@ -392,16 +535,16 @@ DropDownList* GraphicLayer::createDropDownListFromSprite(Sprite* sprite, Panel*
     DropDownList* obj = new DropDownList(sprite);
     if(obj != nullptr)
     {
-        storedObjects.pushBack(obj);
         if(parent != nullptr)
         {
             parent->addChild(obj);
             childsParents[obj->getID()] = parent;
         }
+        this->insertStoredObject(obj, obj->getZOrder());
         obj->release();
     }
     this->loadBaseNodeAttributes(dynamic_cast<CustomBaseNode*>(sprite), obj);
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
@@ -409,12 +552,12 @@ RawObject* GraphicLayer::duplicateObject(RawObject* otherObject)
 {
     RawObject* obj = nullptr;
     //Create the object, set Position + other properties
-    if(isKindOfClass(otherObject, DropDownList))
+    if(isObjectOfType<DropDownList>(otherObject))
     {
         DropDownList* otherList = (DropDownList*)otherObject;
         obj = new DropDownList(otherList->getFile(), otherList->getPosition());
     }
-    else if(isKindOfClass(otherObject, Image))
+    else if(isObjectOfType<Image>(otherObject))
     {
         Image* otherImage = (Image*)otherObject;
         if(otherImage->isAnimation())
@@ -429,7 +572,7 @@ RawObject* GraphicLayer::duplicateObject(RawObject* otherObject)
             obj = new Image(otherImage->getFile(), otherImage->getPosition());
         }
     }
-    else if(isKindOfClass(otherObject, LabelTTF))
+    else if(isObjectOfType<LabelTTF>(otherObject))
     {
         LabelTTF* otherLabel = (LabelTTF*)otherObject;
         //const char* labelString, const char* filename, Vec2 location, Size dimensions, TextHAlignment format
@@ -440,15 +583,15 @@ RawObject* GraphicLayer::duplicateObject(RawObject* otherObject)
         ((LabelTTF*)obj)->setLineSpacing(((LabelTTF*)otherObject)->getLineSpacing());
         ((Label*)obj->getNode())->setSystemFontName(((Label*)otherObject->getNode())->getSystemFontName());
     }
-    else if(isKindOfClass(otherObject, Panel))
+    else if(isObjectOfType<Panel>(otherObject))
     {
         obj = new Panel(otherObject->getName(), otherObject->getPosition());
         obj->getNode()->setContentSize(otherObject->getNode()->getContentSize());
     }
-    else if(isKindOfClass(otherObject, CustomObject) && isKindOfClass(otherObject->getNode(), ui::Scale9Sprite))
+    else if(isObjectOfType<CustomObject>(otherObject) && isKindOfClass(otherObject->getNode(), ui::Scale9Sprite))
     {
         ui::Scale9Sprite* otherNode = (ui::Scale9Sprite*)otherObject->getNode();
-        ui::Scale9Sprite* node = ui::Scale9Sprite::create(otherObject->getEventInfos()["spriteFrame"].asString(), Rect(0, 0, 0, 0), otherNode->getCapInsets());
+        ui::Scale9Sprite* node = ui::Scale9Sprite::create(otherObject->getEventInfo("spriteFrame").asString(), Rect(0, 0, 0, 0), otherNode->getCapInsets());
         node->setPosition(otherNode->getPosition());
         node->setPreferredSize(otherNode->getPreferredSize());
         node->setAnchorPoint(otherNode->getAnchorPoint());
@@ -472,31 +615,38 @@ RawObject* GraphicLayer::duplicateObject(RawObject* otherObject)
     obj->setEventName(otherObject->getEventName());
     obj->setVisible(otherObject->isVisible());
     obj->getNode()->setAnchorPoint(otherObject->getNode()->getAnchorPoint());
-    obj->addEventInfos(otherObject->getEventInfos());
+    obj->shareEventInfos(otherObject);
     obj->setScaleX(otherObject->getScaleX());
     obj->setScaleY(otherObject->getScaleY());
     obj->getNode()->setRotation(otherObject->getNode()->getRotation());
     obj->setOpacity(otherObject->getOpacity());
     
     //Recursively add children for Panel
-    if(isKindOfClass(otherObject, Panel))
+    if(isObjectOfType<Panel>(otherObject))
     {
-        bool needLink = false;
+        //Only the duplicated lists need to be linked, not the whole layer
+        std::vector<RawObject*> dropDownLists;
         for(RawObject* otherChild : ((Panel*)otherObject)->getChildren())
         {
             RawObject* child = duplicateObject(otherChild);
             placeObject(child, (Panel*)obj);
-            if(isKindOfClass(child, DropDownList)) needLink = true;
+            if(isObjectOfType<DropDownList>(child))
+            {
+                dropDownLists.push_back(child);
+            }
+        }
+        if(!dropDownLists.empty())
+        {
+            linkInputLabels(dropDownLists);
         }
-        if(needLink) linkInputLabels();
     }
-    IFEXIST(onObjectCreated)(obj);
+    this->notifyObjectCreated(obj);
     return obj;
 }
 
 RawObject* GraphicLayer::placeObject(RawObject* obj, Panel* panel)
 {
-    if(storedObjects.contains(obj))
+    if(this->containsObject(obj))
     {
         if(this->getContainingPanel(obj) != nullptr)
         {
@@ -508,11 +658,11 @@ RawObject* GraphicLayer::placeObject(RawObject* obj, Panel* panel)
             {
                 layer->removeChild(obj->getNode(), false);
                 panel->addChild(obj);
-                //re-insert child at a specific position as children need to be ordered by zIndex
-                storedObjects.eraseObject(obj);
-                storedObjects.insert(storedObjects.getIndex(panel), obj);
-                //TODO : problem with obj zOrder : it does not correspond to panel zOrder
                 childsParents[obj->getID()] = panel;
+                //children are ordered by zOrder inside their panel
+                this->moveStoredObject(obj, obj->getZOrder());
+                this->invalidateParentsState(obj);
+                this->objectMoved(obj);
             }
 #if VERBOSE_WARNING
             else
@@ -543,6 +693,9 @@ void GraphicLayer::removeObjectFromPanel(RawObject* obj, Panel* panel)
         layer->addChild(obj->getNode());
         CCAssert(childsParents.find(obj->getID()) != childsParents.end(), "Cannot find object inf childsParents");
         childsParents.erase(obj->getID());
+        this->moveStoredObject(obj, obj->getZOrder());
+        this->invalidateParentsState(obj);
+        this->objectMoved(obj);
     }
 #if VERBOSE_WARNING
     else
@@ -563,16 +716,13 @@ void GraphicLayer::removeAllObjectsFromPanel(Panel* panel)
 Panel* GraphicLayer::getContainingPanel(RawObject* obj)
 {
     if(obj == nullptr) return nullptr;
-    if(childsParents.find(obj->getID()) == childsParents.end())
-    {
-        return nullptr;
-    }
-    return childsParents[obj->getID()];
+    auto it = childsParents.find(obj->getID());
+    return it != childsParents.end() ? it->second : nullptr;
 }
 
 void GraphicLayer::destroyObject(RawObject* obj)
 {
-    if(obj != nullptr && storedObjects.contains(obj))
+    if(obj != nullptr && this->containsObject(obj))
     {
         if(isUpdating)
         {
@@ -580,7 +730,7 @@ void GraphicLayer::destroyObject(RawObject* obj)
         }
         else
         {
-            if(isKindOfClass(obj, Panel))
+            if(isObjectOfType<Panel>(obj))
             {
                 //we can't use copy anymore, but clone doesn't work with RawObjects. Manually clone instead
                 Vector<RawObject*> childrenCopy;
@@ -598,7 +748,7 @@ void GraphicLayer::destroyObject(RawObject* obj)
                 layer->removeChild(obj->getNode(), true);
             }
             SynchronousReleaser::sharedReleaser()->addObjectToReleasePool(obj);
-            storedObjects.eraseObject(obj);
+            this->eraseStoredObject(obj);
         }
     }
     else
@@ -606,7 +756,7 @@ void GraphicLayer::destroyObject(RawObject* obj)
 #if VERBOSE_WARNING
         log("Warning : trying to destroy not valid object at adress %p", obj);
 #endif
-        if(obj != nullptr && isKindOfClass(obj, Panel) && storedPanels.contains((Panel*)obj))
+        if(obj != nullptr && isObjectOfType<Panel>(obj) && storedPanels.contains((Panel*)obj))
         {
             storedPanels.eraseObject((Panel*)obj);
         }
@@ -648,80 +798,108 @@ void GraphicLayer::destroyObjectEvent(EventCustom* event)
 
 void GraphicLayer::clear()
 {
-    while (storedObjects.size() > 0)
+    //Iterate over a copy, since destroyObject erases from storedObjects and batchOrders
+    std::vector<RawObject*> objects(storedObjects.begin(), storedObjects.end());
+    for(auto& pending : batchOrders)
+    {
+        objects.push_back(pending.first);
+    }
+    //destroyObject only queues the removal while updating: clearing has to destroy them right away
+    bool wasUpdating = isUpdating;
+    isUpdating = false;
+    for(RawObject* obj : objects)
+    {
+        //Panel children are destroyed with their panel
+        if(this->containsObject(obj))
+        {
+            this->destroyObject(obj);
+        }
+    }
+    isUpdating = wasUpdating;
+    //The pending objects were destroyed: drop the open batches instead of deferring every later add
+    batchDepth = 0;
+    batchGeneration++;
+    for(auto& pending : batchOrders)
     {
-        this->destroyObject(storedObjects.at(0));
+        pending.first->release();
     }
+    batchObjects.clear();
+    batchOrders.clear();
+    batchCreated.clear();
     storedPanels.clear();
     childsParents.clear();
     objectsToRemove.clear();
+    objectsById.clear();
+    objectsByName.clear();
+    orderedObjects.clear();
+    orderedObjectsDirty = false;
+    spatialIndex.clear();
+    boundsToRefresh.clear();
     nextAvailableId = 0;
 }
 
 RawObject* GraphicLayer::first(int id)
 {
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
-    {
-        RawObject* obj = storedObjects.at(i);
-        if(obj->getID() == id)
-        {
-            return obj;
-        }
-    }
-    return nullptr;
+    auto it = objectsById.find(id);
+    return it != objectsById.end() ? it->second : nullptr;
 }
 
-RawObject* GraphicLayer::first(std::string name, bool cache)
+RawObject* GraphicLayer::first(const std::string& name)
 {
-    static SceneName lastScene = SceneSwitcher::sharedSwitcher()->getCurrentSceneName();
-    static std::map<std::string, RawObject*> staticCache;
-    if(lastScene != SceneSwitcher::sharedSwitcher()->getCurrentSceneName())
+    auto it = objectsByName.find(name);
+    if(it == objectsByName.end())
     {
-        staticCache.clear();
-        lastScene = SceneSwitcher::sharedSwitcher()->getCurrentSceneName();
-    }
-    else if(cache && staticCache.find(name) != staticCache.end())
-    {
-        RawObject* cachedObject = staticCache.at(name);
-        if(storedObjects.contains(cachedObject))
-        {
-            return cachedObject;
-        }
+        return nullptr;
     }
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
+    //Several objects can share a name: return the one closest to the front, as a reverse scan of storedObjects would
+    RawObject* result = nullptr;
+    for(RawObject* obj : it->second)
     {
-        RawObject* obj = storedObjects.at(i);
-        if(name.compare(obj->getName()) == 0)
+        if(result == nullptr || isBehind(result, obj))
         {
-            if(cache)
-            {
-                staticCache[name] = obj;
-            }
-            return obj;
+            result = obj;
         }
     }
-    return nullptr;
+    return result;
 }
 
-RawObject* GraphicLayer::first(std::string name, Panel* panel)
+RawObject* GraphicLayer::first(const std::string& name, Panel* panel)
 {
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
+    auto it = objectsByName.find(name);
+    if(it == objectsByName.end())
+    {
+        return nullptr;
+    }
+    RawObject* result = nullptr;
+    for(RawObject* obj : it->second)
     {
-        RawObject* obj = storedObjects.at(i);
-        if(panel->containsObject(obj) && name == obj->getName())
+        if((result == nullptr || isBehind(result, obj)) && this->getContainingPanel(obj) == panel)
         {
-            return obj;
+            result = obj;
         }
     }
-    return nullptr;
+    return result;
 }
 
 RawObject* GraphicLayer::first(Vec2 position)
 {
-    for(long i =  storedObjects.size() - 1; i >= 0 ; i--)
+    std::vector<RawObject*> objects;
+    this->getObjectsAtPosition(position, objects, [this, position](RawObject* obj) {
+        return obj->collision(this->getPositionRelativeToObject(position, obj));
+    });
+    return objects.empty() ? nullptr : objects.front();
+}
+
+RawObject* GraphicLayer::first(Vec2 position, const std::function<bool(RawObject*)>& filter)
+{
+    std::vector<RawObject*> objects;
+    this->getObjectsAtPosition(position, objects, [this, position](RawObject* obj) {
+        return obj->collision(this->getPositionRelativeToObject(position, obj));
+    });
+    //The filter is only called from front to back until it matches, as before
+    for(RawObject* obj : objects)
     {
-        RawObject* obj = storedObjects.at(i);
-        if(obj->collision(this->getPositionRelativeToObject(position, obj)))
+        if(filter(obj))
         {
             return obj;
         }
@@ -729,20 +907,42 @@ RawObject* GraphicLayer::first(Vec2 position)
     return nullptr;
 }
 
+void GraphicLayer::getObjectsInArea(const cocos2d::Rect& area, std::vector<RawObject*>& result)
+{
+    this->refreshSpatialIndex();
+    spatialIndex.query(area, result);
+}
+
 RawObject* GraphicLayer::at(int index)
 {
     CCAssert(index >= 0, "in GraphicLayer objectAtIndex : invalid index, it should be positive");
-    CCAssert(index < storedObjects.size(), "in GraphicLayer objectAtIndex : invalid index, it should be inferior to count");
-    return storedObjects.at(index);
+    CCAssert((size_t)index < storedObjects.size(), "in GraphicLayer objectAtIndex : invalid index, it should be inferior to count");
+    return this->getOrderedObjects()[index];
 }
 
-Vector<RawObject*> GraphicLayer::all(std::string name)
+Vector<RawObject*> GraphicLayer::all()
 {
     Vector<RawObject*> result;
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
+    result.reserve(storedObjects.size());
+    for(RawObject* obj : storedObjects)
     {
-        RawObject* obj = storedObjects.at(i);
-        if(name == obj->getName())
+        result.pushBack(obj);
+    }
+    return result;
+}
+
+Vector<RawObject*> GraphicLayer::all(const std::string& name)
+{
+    Vector<RawObject*> result;
+    auto it = objectsByName.find(name);
+    if(it != objectsByName.end())
+    {
+        std::vector<RawObject*> candidates = it->second;
+        //Keep the same order as a reverse scan of storedObjects
+        std::sort(candidates.begin(), candidates.end(), [](RawObject* a, RawObject* b) {
+            return isBehind(b, a);
+        });
+        for(RawObject* obj : candidates)
         {
             result.pushBack(obj);
         }
@@ -750,13 +950,12 @@ Vector<RawObject*> GraphicLayer::all(std::string name)
     return result;
 }
 
-Vector<RawObject*> GraphicLayer::all(std::string name, Panel* panel)
+Vector<RawObject*> GraphicLayer::all(const std::string& name, Panel* panel)
 {
     Vector<RawObject*> result;
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
+    for(RawObject* obj : this->all(name))
     {
-        RawObject* obj = storedObjects.at(i);
-        if(panel->containsObject(obj) && name == obj->getName())
+        if(this->getContainingPanel(obj) == panel)
         {
             result.pushBack(obj);
         }
@@ -766,23 +965,24 @@ Vector<RawObject*> GraphicLayer::all(std::string name, Panel* panel)
 
 Vector<RawObject*> GraphicLayer::all(Vec2 position)
 {
+    std::vector<RawObject*> objects;
+    this->getObjectsAtPosition(position, objects, [this, position](RawObject* obj) {
+        return obj->collision(this->getPositionRelativeToObject(position, obj));
+    });
     Vector<RawObject*> result;
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
+    result.reserve(objects.size());
+    for(RawObject* obj : objects)
     {
-        RawObject* obj = storedObjects.at(i);
-        if(obj->collision(this->getPositionRelativeToObject(position, obj)))
-        {
-            result.pushBack(obj);
-        }
+        result.pushBack(obj);
     }
     return result;
 }
 
 RawObject* GraphicLayer::first(const std::function<bool(RawObject*)>& filter)
 {
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
+    for(auto it = storedObjects.rbegin(); it != storedObjects.rend(); ++it)
     {
-        RawObject* obj = storedObjects.at(i);
+        RawObject* obj = *it;
         if(filter(obj))
         {
             return obj;
@@ -807,9 +1007,9 @@ Panel* GraphicLayer::firstPanel(const std::function<bool(Panel*)>& filter)
 Vector<RawObject*> GraphicLayer::all(const std::function<bool(RawObject*)>& filter)
 {
     Vector<RawObject*> result;
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
+    for(auto it = storedObjects.rbegin(); it != storedObjects.rend(); ++it)
     {
-        RawObject* obj = storedObjects.at(i);
+        RawObject* obj = *it;
         if(filter(obj))
         {
             result.pushBack(obj);
@@ -843,6 +1043,11 @@ bool GraphicLayer::isOnScreen(RawObject* obj, Size size)
 }
 
 bool GraphicLayer::isCloseToScreen(RawObject* obj, Size size, float distance)
+{
+    return this->getDistanceToScreen(obj, size) < distance;
+}
+
+float GraphicLayer::getDistanceToScreen(RawObject* obj, Size size)
 {
     Vec2 position = this->getRealPosition(obj);
     if(size.width == 0 && size.height == 0)
@@ -851,47 +1056,54 @@ bool GraphicLayer::isCloseToScreen(RawObject* obj, Size size, float distance)
     }
     Vec2 anchorPoint = obj->getNode()->getAnchorPoint();
     Size bounds = Director::getInstance()->getOpenGLView()->getFrameSize();
-    if(bounds.width + distance > position.x - size.width * anchorPoint.x
-       && 0 - distance < position.x + size.width * (1-anchorPoint.x)
-       && bounds.height + distance > position.y - size.height * anchorPoint.y
-       && 0 - distance < position.y + size.height * (1-anchorPoint.y))
-    {
-        return true;
-    }
-    return false;
+    float left = position.x - size.width * anchorPoint.x;
+    float right = position.x + size.width * (1-anchorPoint.x);
+    float bottom = position.y - size.height * anchorPoint.y;
+    float top = position.y + size.height * (1-anchorPoint.y);
+    return MAX(MAX(left - bounds.width, -right), MAX(bottom - bounds.height, -top));
 }
 
 bool GraphicLayer::isInFront(RawObject* obj1, RawObject* obj2)
 {
-    return storedObjects.getIndex(obj1) < storedObjects.getIndex(obj2);
+    bool isStored1 = this->containsObject(obj1);
+    bool isStored2 = this->containsObject(obj2);
+    if(!isStored1 || !isStored2)
+    {
+        //Objects which are not stored come first, as they used to have index -1
+        return !isStored1 && isStored2;
+    }
+    return isBehind(obj1, obj2);
 }
 
 bool GraphicLayer::containsObject(RawObject* obj)
 {
-    return storedObjects.contains(obj);
+    return obj != nullptr && this->first(obj->getID()) == obj;
 }
 
-Vector<Panel*> GraphicLayer::allPanels(std::string name)
+Vector<Panel*> GraphicLayer::allPanels(const std::string& name)
 {
     Vector<Panel*> result;
-    for(long i =  storedPanels.size() - 1; i >= 0; i--)
+    auto it = objectsByName.find(name);
+    if(it != objectsByName.end())
     {
-        Panel* obj = storedPanels.at(i);
-        if(name == obj->getName() && storedObjects.contains(obj))
+        //Panels are returned from the most recently added, like a reverse scan of storedPanels
+        for(auto objIt = it->second.rbegin(); objIt != it->second.rend(); ++objIt)
         {
-            result.pushBack(obj);
+            if(isObjectOfType<Panel>(*objIt))
+            {
+                result.pushBack((Panel*)*objIt);
+            }
         }
     }
     return result;
 }
 
-Vector<Panel*> GraphicLayer::allPanels(std::string name, Panel* panel)
+Vector<Panel*> GraphicLayer::allPanels(const std::string& name, Panel* panel)
 {
     Vector<Panel*> result;
-    for(long i =  storedPanels.size() - 1; i >= 0; i--)
+    for(Panel* obj : this->allPanels(name))
     {
-        Panel* obj = storedPanels.at(i);
-        if(panel->containsObject(obj) && name == obj->getName())
+        if(this->getContainingPanel(obj) == panel)
         {
             result.pushBack(obj);
         }
@@ -913,47 +1125,33 @@ Vector<Panel*> GraphicLayer::allPanels(const std::function<bool(Panel*)>& filter
     return result;
 }
 
-Panel* GraphicLayer::firstPanel(std::string name, bool cache)
+Panel* GraphicLayer::firstPanel(const std::string& name)
 {
-    static SceneName lastScene = SceneSwitcher::sharedSwitcher()->getCurrentSceneName();
-    static std::map<std::string, Panel*> staticCache;
-    if(lastScene != SceneSwitcher::sharedSwitcher()->getCurrentSceneName())
-    {
-        staticCache.clear();
-        lastScene = SceneSwitcher::sharedSwitcher()->getCurrentSceneName();
-    }
-    else if(cache && staticCache.find(name) != staticCache.end())
+    auto it = objectsByName.find(name);
+    if(it != objectsByName.end())
     {
-        Panel* cachedObject = staticCache.at(name);
-        if(storedPanels.contains(cachedObject))
+        for(auto objIt = it->second.rbegin(); objIt != it->second.rend(); ++objIt)
         {
-            return cachedObject;
-        }
-    }
-    for(long i = storedPanels.size() - 1; i >= 0; i--)
-    {
-        Panel* obj = storedPanels.at(i);
-        if(name == obj->getName() && storedObjects.contains(obj))
-        {
-            if(cache)
+            if(isObjectOfType<Panel>(*objIt))
             {
-                staticCache[name] = obj;
+                return (Panel*)*objIt;
             }
-            return obj;
         }
     }
     return nullptr;
 }
 
-
-Panel* GraphicLayer::firstPanel(std::string name, Panel* panel)
+Panel* GraphicLayer::firstPanel(const std::string& name, Panel* panel)
 {
-    for(long i =  storedPanels.size() - 1; i >= 0; i--)
+    auto it = objectsByName.find(name);
+    if(it != objectsByName.end())
     {
-        Panel* obj = storedPanels.at(i);
-        if(panel->containsObject(obj) && name == obj->getName() && storedObjects.contains(obj))
+        for(auto objIt = it->second.rbegin(); objIt != it->second.rend(); ++objIt)
         {
-            return obj;
+            if(isObjectOfType<Panel>(*objIt) && this->getContainingPanel(*objIt) == panel)
+            {
+                return (Panel*)*objIt;
+            }
         }
     }
     return nullptr;
@@ -961,37 +1159,20 @@ Panel* GraphicLayer::firstPanel(std::string name, Panel* panel)
 
 Vec2 GraphicLayer::getPositionRelativeToObject(Vec2 point, RawObject* obj)
 {
-    Vec2 realPosition = point;
-    Panel* parent = this->getContainingPanel(obj);
-    //construct an array of parents to traverse them in reverse order
-    Vector<Panel*> parents;
-    while(parent != nullptr)
-    {
-        parents.pushBack(parent);
-        parent = this->getContainingPanel(parent);
-    }
     //In addition to panels, base Layer position and scale must be taken in account
-    realPosition.x = (realPosition.x) / layer->getScaleX() - layer->getPosition().x;
-    realPosition.y = (realPosition.y) / layer->getScaleY() - layer->getPosition().y;
-    for(long i = parents.size() - 1; i >= 0; i--)
-    {
-        parent = parents.at(i);
-        realPosition.x = (realPosition.x - parent->getPosition().x) / parent->getScaleX() + parent->getNode()->getAnchorPoint().x * parent->getSize().width;
-        realPosition.y = (realPosition.y - parent->getPosition().y) / parent->getScaleY() + parent->getNode()->getAnchorPoint().y * parent->getSize().height;
-    }
+    Vec2 realPosition = Vec2(point.x / layer->getScaleX() - layer->getPosition().x,
+                             point.y / layer->getScaleY() - layer->getPosition().y);
+    const RawObject::ParentsState& state = this->getParentsState(obj);
+    realPosition.x = (realPosition.x - state.anchoredOffset.x) / state.scale.x;
+    realPosition.y = (realPosition.y - state.anchoredOffset.y) / state.scale.y;
     return realPosition;
 }
 
 Vec2 GraphicLayer::getRealPosition(RawObject* obj)
 {
-    Vec2 realPosition = obj->getPosition();
-    RawObject* parent = this->getContainingPanel(obj);
-    while(parent != nullptr)
-    {
-        realPosition.x = realPosition.x * parent->getScaleX() + parent->getPosition().x;
-        realPosition.y = realPosition.y * parent->getScaleY() + parent->getPosition().y;
-        parent = this->getContainingPanel(parent);
-    }
+    const RawObject::ParentsState& state = this->getParentsState(obj);
+    Vec2 realPosition = Vec2(obj->getPosition().x * state.scale.x + state.positionOffset.x,
+                             obj->getPosition().y * state.scale.y + state.positionOffset.y);
     //In addition to panels, base Layer position and scale must be taken in account
     realPosition.x = realPosition.x * layer->getScaleX() + layer->getPosition().x;
     realPosition.y = realPosition.y * layer->getScaleY() + layer->getPosition().y;
@@ -1002,13 +1183,9 @@ Vec2 GraphicLayer::getCenterRealPosition(RawObject* obj)
 {
     Vec2 realPosition = Vec2(obj->getPosition().x + obj->getSize().width * (0.5 - obj->getNode()->getAnchorPoint().x)  * obj->getScaleX(),
                                obj->getPosition().y + obj->getSize().height * (0.5 - obj->getNode()->getAnchorPoint().y)  * obj->getScaleY());
-    RawObject* parent = this->getContainingPanel(obj);
-    while(parent != nullptr)
-    {
-        realPosition.x = (realPosition.x - parent->getNode()->getAnchorPoint().x * parent->getSize().width) * parent->getScaleX() + parent->getPosition().x;
-        realPosition.y = (realPosition.y - parent->getNode()->getAnchorPoint().y * parent->getSize().height) * parent->getScaleY() + parent->getPosition().y;
-        parent = this->getContainingPanel(parent);
-    }
+    const RawObject::ParentsState& state = this->getParentsState(obj);
+    realPosition.x = realPosition.x * state.scale.x + state.anchoredOffset.x;
+    realPosition.y = realPosition.y * state.scale.y + state.anchoredOffset.y;
     //In addition to panels, base Layer position and scale must be taken in account
     realPosition.x = (realPosition.x) * layer->getScaleX() + layer->getPosition().x;
     realPosition.y = (realPosition.y) * layer->getScaleY() + layer->getPosition().y;
@@ -1017,116 +1194,65 @@ Vec2 GraphicLayer::getCenterRealPosition(RawObject* obj)
 
 bool GraphicLayer::isInClippingNode(FenneX::RawObject *obj, cocos2d::Vec2 pos)
 {
-    Panel* parent = GraphicLayer::sharedLayer()->getContainingPanel(obj);
+    Panel* parent = this->getParentsState(obj).cropParent;
     while(parent != nullptr)
     {
-        if (parent->isACropNode() && !GraphicLayer::sharedLayer()->collision(pos, parent))
+        //Use the same rectangle as the scissor when the crop is axis-aligned, checking each crop parent is the same as intersecting them
+        Rect cropRect;
+        if(((ClippingNode*)parent->getNode())->getWorldClippingRect(cropRect) ? !cropRect.containsPoint(pos) : !this->collision(pos, parent))
         {
             return false;
         }
-        parent = GraphicLayer::sharedLayer()->getContainingPanel(parent);
+        parent = this->getParentsState(parent).cropParent;
     }
     return true;
 }
 
 bool GraphicLayer::isWorldVisible(RawObject* obj)
 {
-    if(!obj->isVisible())
-    {
-        return false;
-    }
-    RawObject* parent = GraphicLayer::sharedLayer()->getContainingPanel(obj);
-    while(parent != nullptr)
-    {
-        if(parent->getNode() == nullptr || !parent->isVisible())
-        {
-            return false;
-        }
-        parent = GraphicLayer::sharedLayer()->getContainingPanel(parent);
-    }
-    return true;
+    return obj->isVisible() && this->getParentsState(obj).visible;
 }
 
 float GraphicLayer::getRealScale(RawObject* obj)
 {
-    float realScale = obj->getScale();
-    RawObject* parent = this->getContainingPanel(obj);
-    while(parent != nullptr)
-    {
-        realScale *= parent->getScale();
-        parent = this->getContainingPanel(parent);
-    }
     //In addition to panels, base Layer scale must be taken in account
-    realScale *= layer->getScale();
-    return realScale;
+    return obj->getScale() * this->getParentsState(obj).maxScale * layer->getScale();
 }
 
 float GraphicLayer::getRealScaleX(RawObject* obj)
 {
-    float realScale = obj->getScaleX();
-    RawObject* parent = this->getContainingPanel(obj);
-    while(parent != nullptr)
-    {
-        realScale *= parent->getScaleX();
-        parent = this->getContainingPanel(parent);
-    }
     //In addition to panels, base Layer scale must be taken in account
-    realScale *= layer->getScaleX();
-    return realScale;
+    return obj->getScaleX() * this->getParentsState(obj).scale.x * layer->getScaleX();
 }
 
 float GraphicLayer::getRealScaleY(RawObject* obj)
 {
-    float realScale = obj->getScaleY();
-    RawObject* parent = this->getContainingPanel(obj);
-    while(parent != nullptr)
-    {
-        realScale *= parent->getScaleY();
-        parent = this->getContainingPanel(parent);
-    }
     //In addition to panels, base Layer scale must be taken into account
-    realScale *= layer->getScaleY();
-    return realScale;
+    return obj->getScaleY() * this->getParentsState(obj).scale.y * layer->getScaleY();
 }
 
 bool GraphicLayer::touchAtPosition(Vec2 position, bool event)
 {
 #if VERBOSE_GENERAL_INFO
     log("Before trying touchAtPosition, obj order :");
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
+    for(auto it = storedObjects.rbegin(); it != storedObjects.rend(); ++it)
     {
-        RawObject* obj = storedObjects.at(i);;
+        RawObject* obj = *it;
         log("obj name: %s", obj->getName().c_str());
     }
 #endif
-    for(long i =  storedObjects.size() - 1; i >= 0; i--)
-    {
-        if(!isKindOfClass(storedObjects.at(i), RawObject))
-        {
-            log("Problem with object at index %ld, not a valid RawObject", i);
-        }
-        RawObject* obj = storedObjects.at(i);
+    std::vector<RawObject*> objects;
+    this->getObjectsAtPosition(position, objects, [this, position](RawObject* obj) {
         Node* node = obj->getNode();
         // isInClippingNode(obj, position) was added to make objects non-clickable when they are contained in a clippingNode and are moved out of its boundaries (this is mainly for scrolling)
-        if(node != nullptr && node->isVisible() && obj->collision(this->getPositionRelativeToObject(position, obj)) && isInClippingNode(obj, position))
+        return node != nullptr && node->isVisible() && obj->collision(this->getPositionRelativeToObject(position, obj)) && isInClippingNode(obj, position)
+        && this->getParentsState(obj).visible;
+    });
+    for(RawObject* obj : objects)
+    {
+        if(this->touchObject(obj, event, position))
         {
-            bool parentVisible = true;
-            RawObject* parent = this->getContainingPanel(obj);
-            while(parent != nullptr && parentVisible)
-            {
-                if(parent->getNode() == nullptr || !parent->isVisible())
-                {
-                    parentVisible = false;
-                }
-                parent = this->getContainingPanel(parent);
-            }
-            if(parentVisible)
-            {
-                if(this->touchObject(obj, event, position))
-                {
-                    return true;
-                }
-            }
+            return true;
         }
     }
     return false;
@@ -1139,24 +1265,28 @@ bool GraphicLayer::touchObject(RawObject* obj, bool event, Vec2 position)
     {
         if(event)
         {
-            ValueMap infos = obj->getEventInfos();
-            infos["TouchPositionX"] = Value(position.x);
-            infos["TouchPositionY"] = Value(position.y);
-            Value val = Value(infos);
-            Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(obj->getEventName(), &val);
+            //obj is used after the dispatch, keep it alive even if a listener removes it. The payload is held until the end of the dispatch
+            obj->retain();
+            std::shared_ptr<const Value> infos = obj->getTouchEventInfos(position);
+            //Listeners receive a void*, they must not modify the payload (see getTouchEventInfos)
+            Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(obj->getEventName(), const_cast<Value*>(infos.get()));
             //In VideoView, buttons are only tracked if the video meet the minimum duration
-            if(isValueOfType(obj->getEventInfos()["TrackingName"], STRING))
+            const Value& trackingNameValue = obj->getEventInfo("TrackingName");
+            if(isValueOfType(trackingNameValue, STRING))
             {
-                std::string trackingName = obj->getEventInfos()["TrackingName"].asString();
+                std::string trackingName = trackingNameValue.asString();
                 std::string trackingInfo = "";
-                if(isValueOfType(obj->getEventInfos()["TrackingInfo"], STRING))
+                const Value& trackingInfoKey = obj->getEventInfo("TrackingInfo");
+                if(isValueOfType(trackingInfoKey, STRING))
                 {
-                    trackingInfo = obj->getEventInfos()["TrackingInfo"].asString();
-                    trackingInfo = isValueOfType(obj->getEventInfos()[trackingInfo], STRING) ? obj->getEventInfos()[trackingInfo].asString() : "";
+                    const Value& trackingInfoValue = obj->getEventInfo(trackingInfoKey.asString());
+                    trackingInfo = isValueOfType(trackingInfoValue, STRING) ? trackingInfoValue.asString() : "";
                 }
-                std::string trackingLabel = isValueOfType(obj->getEventInfos()["TrackingLabel"], STRING) ? obj->getEventInfos()["TrackingLabel"].asString() : "";
+                const Value& trackingLabelValue = obj->getEventInfo("TrackingLabel");
+                std::string trackingLabel = isValueOfType(trackingLabelValue, STRING) ? trackingLabelValue.asString() : "";
                 AnalyticsWrapper::logEvent(trackingName, !trackingInfo.empty() ? trackingInfo : !trackingLabel.empty() ? trackingLabel : "");
             }
+            obj->release();
         }
         return true;
     }
@@ -1168,7 +1298,6 @@ void GraphicLayer::reorderChild(RawObject* child, int zOrder)
     if(this->containsObject(child) && child->getNode() != nullptr)
     {
         Panel* parent = this->getContainingPanel(child);
-        child->retain();
         if(parent == nullptr)
         {
             layer->reorderChild(child->getNode(), zOrder);
@@ -1177,40 +1306,8 @@ void GraphicLayer::reorderChild(RawObject* child, int zOrder)
         {
             parent->reorderChild(child, zOrder);
         }
-        storedObjects.eraseObject(child);
-        this->addObject(child, zOrder);
-        child->release();
-        if(isKindOfClass(child, Panel))
-        {
-            this->reorderChildrenOfPanel((Panel*)child);
-        }
-    }
-}
-
-void GraphicLayer::reorderChildrenOfPanel(Panel* panel)
-{
-    Vector<RawObject*> alreadyReordered;
-    for(long i = 0; i < storedObjects.size(); i++)
-    {
-        RawObject* obj = storedObjects.at(i);
-        if(this->getContainingPanel(obj) == panel && !alreadyReordered.contains(obj))
-        {
-            //re-insert child at a specific position as children need to be ordered by zIndex
-            //DON'T use [self reorderChild:beforeChild] as there is a special behavior for childs inside panel (here, only the order in storedObjects should be changed)
-            storedObjects.eraseObject(obj);
-            storedObjects.insert(storedObjects.getIndex(panel), obj);
-            alreadyReordered.pushBack(obj);
-            //redo this index as the object is not the same.
-            i--;
-        }
-    }
-    for(long i = 0; i < storedPanels.size(); i++)
-    {
-        Panel* subPanel = storedPanels.at(i);
-        if(this->getContainingPanel(subPanel) == panel)
-        {
-            this->reorderChildrenOfPanel(subPanel);
-        }
+        //Panel children are moved along
+        this->moveStoredObject(child, zOrder);
     }
 }
 
@@ -1226,23 +1323,12 @@ void GraphicLayer::addObject(RawObject* obj, int z)
         }
         else
         {
-            if(isKindOfClass(obj, Panel) && !storedPanels.contains((Panel*)obj))
+            if(isObjectOfType<Panel>(obj) && !storedPanels.contains((Panel*)obj))
             {
                 storedPanels.pushBack((Panel*)obj);
             }
-            //insert objects at a specific position as they need to be ordered by zOrder
-            unsigned int index = 0;
-            //search for the right position : use z instead of obj.zOrder, because obj.zOrder is not set yet.
-            //TODO : improve this mess : return an array of z and compare them in order ...
-            while(index < storedObjects.size() &&
-                  (( this->getContainingPanel(storedObjects.at(index)) != nullptr
-                    && this->getContainingPanel(storedObjects.at(index))->getZOrder() <= z)
-                   || (this->getContainingPanel(storedObjects.at(index)) == nullptr
-                       && storedObjects.at(index)->getZOrder() <= z)))
-            {
-                index++;
-            }
-            storedObjects.insert(index, obj);
+            //use z instead of obj.zOrder, because obj.zOrder is not set yet if the Node already had a parent
+            this->insertStoredObject(obj, z);
             if(obj->getNode() != nullptr && obj->getNode()->getParent() == nullptr)
             {
                 layer->addChild(obj->getNode(), z);
@@ -1263,7 +1349,7 @@ void GraphicLayer::addObject(RawObject* obj, int z)
 #endif
 }
 
-void GraphicLayer::setObjectFields(RawObject* obj, ValueMap values)
+void GraphicLayer::setObjectFields(RawObject* obj, const ValueMap& values)
 {
     if(values.find("Name") != values.end() && values.at("Name").getType() == Value::Type::STRING)
     {
@@ -1290,7 +1376,7 @@ void GraphicLayer::setObjectFields(RawObject* obj, ValueMap values)
         }
 #endif
         RawObject* target = first(values.at("Panel").asInt());
-        CCAssert(isKindOfClass(target, Panel), "Trying to place on object on another object which is not a Panel");
+        CCAssert(isObjectOfType<Panel>(target), "Trying to place on object on another object which is not a Panel");
         this->placeObject(obj, (Panel*)target);
     }
     if(values.find("Visible") != values.end() && values.at("Visible").getType() == Value::Type::BOOLEAN)
@@ -1308,11 +1394,23 @@ void GraphicLayer::setObjectFields(RawObject* obj, ValueMap values)
 void GraphicLayer::update(float deltaTime)
 {
     isUpdating = true;
-    for(RawObject* obj : storedObjects)
+    //Iterate on a copy, as updates may reorder objects. The buffer keeps its capacity, so this doesn't allocate once it is large enough
+    updatedObjects = this->getOrderedObjects();
+    for(RawObject* obj : updatedObjects)
     {
-        if(isKindOfClass(obj, RawObject))
+        //The layer was cleared by an object update: the remaining objects are destroyed
+        if(storedObjects.empty())
+        {
+            break;
+        }
+        if(obj != nullptr)
         {
             obj->update(deltaTime);
+            //Catch changes done directly on the Node or by actions
+            if(this->updateLocalState(obj))
+            {
+                this->objectMoved(obj);
+            }
         }
         else
         {
@@ -1320,12 +1418,16 @@ void GraphicLayer::update(float deltaTime)
         }
     }
     isUpdating = false;
-    for(long i = 0; i < objectsToAdd.size(); i++)
     {
-        this->addObject(objectsToAdd.at(i), objectsToAddZindex[i]);
-        if(objectsToAddPanel[i] != nullptr)
+        //Objects added during update are sorted in storedObjects at once
+        BatchScope batch(this);
+        for(long i = 0; i < objectsToAdd.size(); i++)
         {
-            this->placeObject(objectsToAdd.at(i), objectsToAddPanel[i]);
+            this->addObject(objectsToAdd.at(i), objectsToAddZindex[i]);
+            if(objectsToAddPanel[i] != nullptr)
+            {
+                this->placeObject(objectsToAdd.at(i), objectsToAddPanel[i]);
+            }
         }
     }
     objectsToAdd.clear();
@@ -1346,7 +1448,7 @@ void GraphicLayer::refreshRenderTextures(Ref* obj)
 {
     for(RawObject* obj : storedObjects)
     {
-        if(isKindOfClass(obj, CustomObject) && isKindOfClass(((CustomObject*)obj)->getNode(), RenderTexture))
+        if(isObjectOfType<CustomObject>(obj) && isKindOfClass(((CustomObject*)obj)->getNode(), RenderTexture))
         {
             CustomObject* custObj = ((CustomObject*)obj);
             RenderTexture* renderText = (RenderTexture*)custObj->getNode();
@@ -1396,7 +1498,7 @@ void GraphicLayer::loadBaseNodeAttributes(CustomBaseNode* node, RawObject* obj)
 #if VERBOSE_LOAD_CCB
             log("setting scene : %d", node->getScene());
 #endif
-            obj->setEventInfo("Scene", Value(node->getScene()));
+            obj->setEventInfo(EventInfoKey::Scene, Value(node->getScene()));
         }
         if(node->getZindex() != 0)
         {
@@ -1412,4 +1514,382 @@ int GraphicLayer::getNextId()
     nextAvailableId++;
     return nextAvailableId - 1;
 }
+
+void GraphicLayer::updateNameIndex(RawObject* obj, const std::string& previousName)
+{
+    //Objects which are not stored yet will be indexed under their current name when added
+    if(!this->containsObject(obj))
+    {
+        return;
+    }
+    auto it = objectsByName.find(previousName);
+    if(it != objectsByName.end())
+    {
+        std::vector<RawObject*>& bucket = it->second;
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), obj), bucket.end());
+        if(bucket.empty())
+        {
+            objectsByName.erase(it);
+        }
+    }
+    objectsByName[obj->getName()].push_back(obj);
+}
+
+void GraphicLayer::insertStoredObject(RawObject* obj, int zOrder)
+{
+    if(this->containsObject(obj))
+    {
+        return;
+    }
+    obj->retain();
+    if(batchDepth > 0)
+    {
+        batchObjects.push_back(obj);
+        batchOrders[obj] = std::make_pair(zOrder, nextOrderSequence++);
+    }
+    else
+    {
+        this->setOrderKey(obj, zOrder);
+        storedObjects.insert(obj);
+        orderedObjectsDirty = true;
+    }
+    objectsById[obj->getID()] = obj;
+    objectsByName[obj->getName()].push_back(obj);
+    boundsToRefresh.insert(obj);
+}
+
+void GraphicLayer::eraseStoredObject(RawObject* obj)
+{
+    bool wasStored = storedObjects.erase(obj) > 0 || batchOrders.erase(obj) > 0;
+    orderedObjectsDirty = true;
+    spatialIndex.remove(obj);
+    boundsToRefresh.erase(obj);
+    auto idIt = objectsById.find(obj->getID());
+    if(idIt != objectsById.end() && idIt->second == obj)
+    {
+        objectsById.erase(idIt);
+    }
+    auto nameIt = objectsByName.find(obj->getName());
+    if(nameIt != objectsByName.end())
+    {
+        std::vector<RawObject*>& bucket = nameIt->second;
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), obj), bucket.end());
+        if(bucket.empty())
+        {
+            objectsByName.erase(nameIt);
+        }
+    }
+    if(wasStored)
+    {
+        obj->release();
+    }
+}
+
+void GraphicLayer::moveStoredObject(RawObject* obj, int zOrder)
+{
+    auto pending = batchOrders.find(obj);
+    if(pending != batchOrders.end())
+    {
+        //Its key will be computed by commitBatch
+        pending->second = std::make_pair(zOrder, nextOrderSequence++);
+        return;
+    }
+    if(storedObjects.erase(obj) == 0)
+    {
+        return;
+    }
+    //Children keys are copies of their panel key: take each one out of the set before rebuilding it
+    std::vector<RawObject*> subtree;
+    subtree.push_back(obj);
+    for(size_t i = 0; i < subtree.size(); i++)
+    {
+        if(isObjectOfType<Panel>(subtree[i]))
+        {
+            for(RawObject* child : ((Panel*)subtree[i])->getChildren())
+            {
+                if(storedObjects.erase(child) > 0)
+                {
+                    subtree.push_back(child);
+                }
+            }
+        }
+    }
+    Panel* parent = this->getContainingPanel(obj);
+    if(parent != nullptr && batchOrders.find(parent) != batchOrders.end())
+    {
+        //Placed in a panel which is not sorted yet: the whole subtree will be sorted with it
+        batchOrders[obj] = std::make_pair(zOrder, nextOrderSequence++);
+        batchObjects.push_back(obj);
+        for(size_t i = 1; i < subtree.size(); i++)
+        {
+            batchOrders[subtree[i]] = subtree[i]->orderKey.back();
+            batchObjects.push_back(subtree[i]);
+        }
+        return;
+    }
+    this->setOrderKey(obj, zOrder);
+    //Parents are always before their children in subtree
+    for(size_t i = 1; i < subtree.size(); i++)
+    {
+        RawObject* child = subtree[i];
+        std::pair<int, long> ownOrder = child->orderKey.back();
+        child->orderKey = this->getContainingPanel(child)->orderKey;
+        child->orderKey.push_back(ownOrder);
+    }
+    storedObjects.insert(subtree.begin(), subtree.end());
+    orderedObjectsDirty = true;
+}
+
+void GraphicLayer::setOrderKey(RawObject* obj, int zOrder)
+{
+    Panel* parent = this->getContainingPanel(obj);
+    if(parent != nullptr)
+    {
+        obj->orderKey = parent->orderKey;
+    }
+    else
+    {
+        obj->orderKey.clear();
+    }
+    obj->orderKey.push_back(std::make_pair(zOrder, nextOrderSequence++));
+}
+
+const std::vector<RawObject*>& GraphicLayer::getOrderedObjects()
+{
+    if(orderedObjectsDirty)
+    {
+        orderedObjects.assign(storedObjects.begin(), storedObjects.end());
+        orderedObjectsDirty = false;
+    }
+    return orderedObjects;
+}
+
+bool GraphicLayer::isBehind(const RawObject* obj1, const RawObject* obj2)
+{
+    const std::vector<std::pair<int, long>>& key1 = obj1->orderKey;
+    const std::vector<std::pair<int, long>>& key2 = obj2->orderKey;
+    long commonSize = MIN(key1.size(), key2.size());
+    for(long i = 0; i < commonSize; i++)
+    {
+        if(key1[i] != key2[i])
+        {
+            return key1[i] < key2[i];
+        }
+    }
+    //One is a descendant of the other: panel children are before their panel
+    return key1.size() > key2.size();
+}
+
+void GraphicLayer::objectMoved(RawObject* obj)
+{
+    //Only track stored objects: the others will be refreshed when added
+    if(this->containsObject(obj))
+    {
+        boundsToRefresh.insert(obj);
+        if(isObjectOfType<Panel>(obj))
+        {
+            for(RawObject* child : ((Panel*)obj)->getChildren())
+            {
+                this->invalidateParentsState(child);
+            }
+        }
+    }
+}
+
+bool GraphicLayer::updateLocalState(RawObject* obj)
+{
+    Node* node = obj->getNode();
+    if(node == nullptr)
+    {
+        return false;
+    }
+    RawObject::LocalState& state = obj->localState;
+    //Setters on the Node change its version: only compare the properties when it changed, or when the object has a new Node
+    if(state.node == node && state.version == node->getTransformVersion())
+    {
+        return false;
+    }
+    state.node = node;
+    state.version = node->getTransformVersion();
+    if(state.position == node->getPosition()
+       && state.scale.x == node->getScaleX()
+       && state.scale.y == node->getScaleY()
+       && state.anchorPoint == node->getAnchorPoint()
+       && state.size.equals(node->getContentSize())
+       && state.visible == node->isVisible())
+    {
+        return false;
+    }
+    state.position = node->getPosition();
+    state.scale = Vec2(node->getScaleX(), node->getScaleY());
+    state.anchorPoint = node->getAnchorPoint();
+    state.size = node->getContentSize();
+    state.visible = node->isVisible();
+    return true;
+}
+
+const RawObject::ParentsState& GraphicLayer::getParentsState(RawObject* obj)
+{
+    //Catch changes done directly on the parents Nodes since the last update, so that the cached state is never read stale
+    for(Panel* parent = this->getContainingPanel(obj); parent != nullptr; parent = this->getContainingPanel(parent))
+    {
+        if(this->updateLocalState(parent))
+        {
+            this->objectMoved(parent);
+        }
+    }
+    return this->computeParentsState(obj);
+}
+
+const RawObject::ParentsState& GraphicLayer::computeParentsState(RawObject* obj)
+{
+    RawObject::ParentsState& state = obj->parentsState;
+    if(state.valid)
+    {
+        return state;
+    }
+    Panel* parent = this->getContainingPanel(obj);
+    if(parent == nullptr)
+    {
+        state.scale = Vec2(1, 1);
+        state.maxScale = 1;
+        state.positionOffset = Vec2::ZERO;
+        state.anchoredOffset = Vec2::ZERO;
+        state.visible = true;
+        state.cropParent = nullptr;
+    }
+    else
+    {
+        const RawObject::ParentsState& parentState = this->computeParentsState(parent);
+        const Vec2& parentPosition = parent->getPosition();
+        const Vec2& anchorPoint = parent->getNode()->getAnchorPoint();
+        const cocos2d::Size& parentSize = parent->getSize();
+        float scaleX = parent->getScaleX();
+        float scaleY = parent->getScaleY();
+        state.positionOffset = Vec2(parentPosition.x * parentState.scale.x + parentState.positionOffset.x,
+                                    parentPosition.y * parentState.scale.y + parentState.positionOffset.y);
+        state.anchoredOffset = Vec2((parentPosition.x - anchorPoint.x * parentSize.width * scaleX) * parentState.scale.x + parentState.anchoredOffset.x,
+                                    (parentPosition.y - anchorPoint.y * parentSize.height * scaleY) * parentState.scale.y + parentState.anchoredOffset.y);
+        state.scale = Vec2(parentState.scale.x * scaleX, parentState.scale.y * scaleY);
+        state.maxScale = parentState.maxScale * parent->getScale();
+        state.visible = parentState.visible && parent->getNode() != nullptr && parent->isVisible();
+        state.cropParent = parent->isACropNode() ? parent : parentState.cropParent;
+    }
+    state.valid = true;
+    return state;
+}
+
+void GraphicLayer::invalidateParentsState(RawObject* obj)
+{
+    //Descendants of an invalid object are already invalid
+    if(!obj->parentsState.valid)
+    {
+        return;
+    }
+    obj->parentsState.valid = false;
+    if(isObjectOfType<Panel>(obj))
+    {
+        for(RawObject* child : ((Panel*)obj)->getChildren())
+        {
+            this->invalidateParentsState(child);
+        }
+    }
+}
+
+void GraphicLayer::refreshSpatialIndex()
+{
+    Vec2 layerScale = Vec2(layer->getScaleX(), layer->getScaleY());
+    if(!(layer->getPosition() == indexedLayerPosition && layerScale == indexedLayerScale))
+    {
+        //Every world box depends on the base layer: refresh everything from top level objects
+        indexedLayerPosition = layer->getPosition();
+        indexedLayerScale = layerScale;
+        for(RawObject* obj : storedObjects)
+        {
+            if(this->getContainingPanel(obj) == nullptr)
+            {
+                this->refreshBounds(obj);
+            }
+        }
+        boundsToRefresh.clear();
+        return;
+    }
+    while(!boundsToRefresh.empty())
+    {
+        //refreshBounds may catch parents changes (see getParentsState), which adds objects to refresh
+        std::unordered_set<RawObject*> objects;
+        objects.swap(boundsToRefresh);
+        for(RawObject* obj : objects)
+        {
+            this->refreshBounds(obj);
+        }
+    }
+}
+
+void GraphicLayer::refreshBounds(RawObject* obj)
+{
+    Node* node = obj->getNode();
+    if(node == nullptr || !this->containsObject(obj))
+    {
+        spatialIndex.remove(obj);
+        return;
+    }
+    const Vec2& position = node->getPosition();
+    const Vec2& anchorPoint = node->getAnchorPoint();
+    const cocos2d::Size& size = node->getContentSize();
+    
+    //Same cases as Panel::collision, which is always true for those, and objects whose collision goes beyond their size
+    bool unbounded = obj->hasCollisionBeyondSize();
+    if(!unbounded && isObjectOfType<Panel>(obj))
+    {
+        Value infiniteScrolling = obj->getEventInfo("InfiniteScrolling");
+        unbounded = (size.width == 0 && size.height == 0)
+        || (isValueOfType(infiniteScrolling, BOOLEAN) && infiniteScrolling.asBool());
+    }
+    if(unbounded)
+    {
+        spatialIndex.insertUnbounded(obj);
+    }
+    else
+    {
+        //Same bounds as RawObject::collision in parent space, then inverse of getPositionRelativeToObject
+        const RawObject::ParentsState& state = this->getParentsState(obj);
+        float minX = position.x - size.width * anchorPoint.x * node->getScaleX();
+        float maxX = position.x + size.width * (1 - anchorPoint.x) * node->getScaleX();
+        float minY = position.y - size.height * anchorPoint.y * node->getScaleY();
+        float maxY = position.y + size.height * (1 - anchorPoint.y) * node->getScaleY();
+        float scaleX = state.scale.x * indexedLayerScale.x;
+        float scaleY = state.scale.y * indexedLayerScale.y;
+        float offsetX = (state.anchoredOffset.x + indexedLayerPosition.x) * indexedLayerScale.x;
+        float offsetY = (state.anchoredOffset.y + indexedLayerPosition.y) * indexedLayerScale.y;
+        float worldMinX = MIN(minX * scaleX, maxX * scaleX) + offsetX;
+        float worldMaxX = MAX(minX * scaleX, maxX * scaleX) + offsetX;
+        float worldMinY = MIN(minY * scaleY, maxY * scaleY) + offsetY;
+        float worldMaxY = MAX(minY * scaleY, maxY * scaleY) + offsetY;
+        //Small margin to absorb rounding differences with the exact collision test
+        spatialIndex.insert(obj, Rect(worldMinX - 1, worldMinY - 1, worldMaxX - worldMinX + 2, worldMaxY - worldMinY + 2));
+    }
+    
+    if(isObjectOfType<Panel>(obj))
+    {
+        for(RawObject* child : ((Panel*)obj)->getChildren())
+        {
+            this->refreshBounds(child);
+        }
+    }
+}
+
+void GraphicLayer::getObjectsAtPosition(Vec2 position, std::vector<RawObject*>& result, const std::function<bool(RawObject*)>& test)
+{
+    this->refreshSpatialIndex();
+    spatialIndex.query(position, result);
+    result.erase(std::remove_if(result.begin(), result.end(), [&test](RawObject* obj) {
+        return !test(obj);
+    }), result.end());
+    //Front to back, as a reverse scan of storedObjects would
+    std::sort(result.begin(), result.end(), [](RawObject* a, RawObject* b) {
+        return isBehind(b, a);
+    });
+}
+
 NS_FENNEX_END
@@ -27,6 +27,8 @@ THE SOFTWARE.
 
 #include "cocos2d.h"
 USING_NS_CC;
+#include <unordered_set>
+#include <set>
 #include "Pausable.h"
 #include "Scene.h"
 #include "RawObject.h"
@@ -37,6 +39,7 @@ USING_NS_CC;
 #include "InputLabel.h"
 #include "DropDownList.h"
 #include "CustomBaseNode.h"
+#include "SpatialGrid.h"
 #include "FenneXMacros.h"
 
 NS_FENNEX_BEGIN
@@ -52,6 +55,29 @@ public:
     
     // Optional callback to be informed of all objects created and apply bulk modification
     static void setOnObjectCreated(std::function<void(RawObject*)> callback);
+    // Optional callback called once per batch with all the objects created, instead of onObjectCreated for each of them
+    static void setOnObjectsCreated(std::function<void(const Vector<RawObject*>&)> callback);
+    
+    /* Batch creation, to use when creating a lot of objects at once (a whole scene for example)
+     Objects created between beginBatch and commitBatch are immediately created and indexed by ID and name,
+     but they are only ordered in stored objects on commit, with a single sort. Creation callbacks are also called on commit.
+     Until then, they are not returned by all() and filter queries, and order dependent queries (isInFront, position) can be wrong for them
+     Batches can be nested: only the outermost commitBatch applies them
+     Prefer BatchScope, so that an exception can't leave the batch open. clear and renderOnLayer drop any open batch
+     */
+    void beginBatch();
+    void commitBatch();
+    
+    //Begin a batch, committed when going out of scope unless the layer was cleared in between
+    class BatchScope
+    {
+    public:
+        BatchScope(GraphicLayer* layer);
+        ~BatchScope();
+    private:
+        GraphicLayer* layer;
+        long generation;
+    };
     
     /*
      Optional values for all objects :
@@ -67,11 +93,11 @@ public:
      - Opacity (int) default 255 (should range between 0-255)
      */
     
-    Image* createImage(std::string imageFile, ValueMap values);
-    Image* createAnimatedImage(std::string spriteSheetFile, int capacity, ValueMap values);
+    Image* createImage(const std::string& imageFile, const ValueMap& values);
+    Image* createAnimatedImage(const std::string& spriteSheetFile, int capacity, const ValueMap& values);
     Image* createImageFromSprite(Sprite* sprite, Panel* parent);
     
-    CustomObject* createCustomObject(Node* delegate, ValueMap values);
+    CustomObject* createCustomObject(Node* delegate, const ValueMap& values);
     CustomObject* createCustomObjectFromNode(Node* node, Panel* parent);
     
     /* FontFile must be formatted as FontnameSizeColor (example : Verdana30Black, recognized colors are : Black, White, Gray)
@@ -80,17 +106,17 @@ public:
      - TextFormat (int as enum TextFormat), requires DimX and DimY, default  AlignCenter
      Do not use scale if you use dimensions, or it won't work properly
      */
-    LabelTTF* createLabelTTF(std::string label, std::string fontFile, ValueMap values);
+    LabelTTF* createLabelTTF(const std::string& label, const std::string& fontFile, const ValueMap& values);
     LabelTTF* createLabelTTFromLabel(Label* cocosLabel, Panel* parent);
     
     /* There is no createInputLabel with values, because it is not yet used. Feel free to create it if you need it 
      */
     InputLabel* createInputLabelFromScale9Sprite(ui::Scale9Sprite* cocosSprite, Panel* parent);
     
-    Panel* createPanel(std::string name, ValueMap values);
-    Panel* createPanelFromNode(std::string file, Node* cocosNode, Panel* parent);
+    Panel* createPanel(const std::string& name, const ValueMap& values);
+    Panel* createPanelFromNode(const std::string& file, Node* cocosNode, Panel* parent);
     //Special case : when you want the panel to be the host for a .ccbi file, the Node is already created
-    Panel* createPanelWithNode(std::string name, Node* panelNode, int zOrder = 0);
+    Panel* createPanelWithNode(const std::string& name, Node* panelNode, int zOrder = 0);
     
     
     /* There is no createDropDownList with values, because it is not yet used. Feel free to create it if you need it
@@ -132,44 +158,47 @@ public:
     /**********************************************************************************
      Methods to retrieve objects
      *********************************************************************************/
-    //Get by object index in stored objects
+    //Get by object index in stored objects, from back to front
     RawObject* at(int index);
     
     //Different ways of querying objects
     //The first object found is always returned to avoid managing arrays, or nil if no result
     
-    //Get by object ID
+    //Get by object ID. ID and name queries use indexes maintained by the layer, so they don't scan storedObjects
     RawObject* first(int id);
     RawObject* first(const std::function<bool(RawObject*)>& filter);
-    //Cache is a way to tell GraphicLayer to cache this particular object for the current scene, so that subsequent call will be very fast
-    //Be careful not to use the cache in a scene constructor as the SceneSwitcher don't point yet to the new scene, and thus the cache will return objects from previous scene
-    RawObject* first(std::string name, bool cache = false);
-    RawObject* first(std::string name, Panel* panel);
+    RawObject* first(const std::string& name);
+    RawObject* first(const std::string& name, Panel* panel);
+    //Position queries only hit-test objects whose world bounding box contains the position (see SpatialGrid)
+    //Objects whose collision goes beyond their content size (see RawObject::hasCollisionBeyondSize) are tested at any position
     RawObject* first(Vec2 position);
+    //First object at position, from front to back, for which filter returns true
+    RawObject* first(Vec2 position, const std::function<bool(RawObject*)>& filter);
+    //Objects whose world bounding box may intersect area (in world coordinates), in no particular order. Objects without bounds are always returned
+    //Meant for visibility checks: it doesn't test the exact collision
+    void getObjectsInArea(const cocos2d::Rect& area, std::vector<RawObject*>& result);
     
     //Return all objects matching query
-    Vector<RawObject*> all()
-    {
-        return storedObjects;
-    }
-    Vector<RawObject*> all(std::string name);
-    Vector<RawObject*> all(std::string name, Panel* panel);
+    Vector<RawObject*> all();
+    Vector<RawObject*> all(const std::string& name);
+    Vector<RawObject*> all(const std::string& name, Panel* panel);
     Vector<RawObject*> all(Vec2 position);
     Vector<RawObject*> all(const std::function<bool(RawObject*)>& filter);
     
     //Method for querying panels. Faster because there are generally way less panels
     Panel* firstPanel(const std::function<bool(Panel*)>& filter);
-    //Be careful not to use the cache in a scene constructor as the SceneSwitcher don't point yet to the new scene, and thus the cache will return objects from previous scene
-    Panel* firstPanel(std::string name, bool cache = false);
-    Panel* firstPanel(std::string name, Panel* panel);
+    Panel* firstPanel(const std::string& name);
+    Panel* firstPanel(const std::string& name, Panel* panel);
     
-    Vector<Panel*> allPanels(std::string name);
-    Vector<Panel*> allPanels(std::string name, Panel* panel);
+    Vector<Panel*> allPanels(const std::string& name);
+    Vector<Panel*> allPanels(const std::string& name, Panel* panel);
     Vector<Panel*> allPanels(const std::function<bool(Panel*)>& filter);
     
     /**********************************************************************************
      Methods to get position/scale relative to world instead of local
      *********************************************************************************/
+    //Parents transform and visibility are cached on each object, and invalidated when a parent changes through RawObject setters or placeObject
+    //Changes done directly on a parent Node (actions, ...) are detected when reading the cache, by checking the parents Nodes transform version
     
     Vec2 getPositionRelativeToObject(Vec2 point, RawObject* obj);
     Vec2 getRealPosition(RawObject* obj);
@@ -199,6 +228,8 @@ public:
     bool isOnScreen(RawObject* obj, cocos2d::Size size = cocos2d::Size(0, 0));
     
     bool isCloseToScreen(RawObject* obj, cocos2d::Size size = cocos2d::Size(0, 0), float distance = 0);
+    //Distance between the object bounds and the screen, negative when the object is on screen. Same bounds as isCloseToScreen
+    float getDistanceToScreen(RawObject* obj, cocos2d::Size size = cocos2d::Size(0, 0));
     
     //Return true if obj1 is in front of obj2
     bool isInFront(RawObject* obj1, RawObject* obj2);
@@ -228,6 +259,13 @@ public:
     //Return an available ID and increment the counter for next one
     int getNextId();
     
+    //Called by RawObject::setName to move the object to its new name bucket
+    void updateNameIndex(RawObject* obj, const std::string& previousName);
+    
+    //Called when an object position, scale, visibility or panel changed, so that its bounds and its children cached world state are refreshed
+    //Changes done directly on the Node are detected during update
+    void objectMoved(RawObject* obj);
+    
     //Used when loading an entire scene from CCB
     void useBaseLayer(Layer* otherLayer);
     
@@ -261,20 +299,82 @@ private:
     
     //Actually add the object to the Layer
     void addObject(RawObject* obj, int z = 0);
-    void setObjectFields(RawObject* obj, ValueMap values);
+    void setObjectFields(RawObject* obj, const ValueMap& values);
     
-    //Used to internally reorder storedObjects after updating an object z-order
-    void reorderChildrenOfPanel(Panel* panel);
+    //Call onObjectCreated, or keep the object until commitBatch
+    void notifyObjectCreated(RawObject* obj);
     
     //Helper method to load ccb infos into an object
     void loadBaseNodeAttributes(CustomBaseNode* node, RawObject* obj);
     
-    //Array containing all objects. They are sort according their zOrder (ascending)
-    Vector<RawObject*> storedObjects;
+    //Insert/erase in storedObjects while keeping the ID and name indexes up to date
+    //The object is placed at zOrder in its containing panel (or the base layer), in front of the objects with the same zOrder
+    //Panel children are ordered by zOrder, like cocos draws them, then by placement. placeObject used to ignore zOrder and keep the placement order
+    //During a batch, it is only indexed, and placed in storedObjects by commitBatch
+    void insertStoredObject(RawObject* obj, int zOrder);
+    void eraseStoredObject(RawObject* obj);
+    //Move a stored object to zOrder in its current containing panel. Its panel children are moved along
+    void moveStoredObject(RawObject* obj, int zOrder);
+    //Compute obj order key from its containing panel one, with a new insertion sequence
+    void setOrderKey(RawObject* obj, int zOrder);
+    //Flat copy of storedObjects, rebuilt after it changed
+    const std::vector<RawObject*>& getOrderedObjects();
+    
+    //Strict order of storedObjects, from back to front (see RawObject::orderKey)
+    static bool isBehind(const RawObject* obj1, const RawObject* obj2);
+    struct StoredObjectsOrder
+    {
+        bool operator()(const RawObject* obj1, const RawObject* obj2) const
+        {
+            return GraphicLayer::isBehind(obj1, obj2);
+        }
+    };
+    
+    //Compare the Node properties with the ones recorded in RawObject::localState, and record them if they changed
+    //Only Nodes whose transform version changed since the last call are compared, so unchanged objects cost a single check
+    bool updateLocalState(RawObject* obj);
+    
+    //Return the cached state of obj parents, computing it from its parent state if needed
+    //The parents Nodes are checked first (see updateLocalState), so changes done directly on them are taken into account right away
+    const RawObject::ParentsState& getParentsState(RawObject* obj);
+    //Same without checking the parents Nodes
+    const RawObject::ParentsState& computeParentsState(RawObject* obj);
+    void invalidateParentsState(RawObject* obj);
+    
+    //Recompute world bounding boxes of objects which moved since last query
+    void refreshSpatialIndex();
+    //Panel children are refreshed recursively
+    void refreshBounds(RawObject* obj);
+    //Objects at position for which test returns true, sorted from front to back. The spatial index candidates are tested first, so only the objects found are sorted
+    void getObjectsAtPosition(Vec2 position, std::vector<RawObject*>& result, const std::function<bool(RawObject*)>& test);
+    
+    //All objects, retained, from back to front. An object order key must not change while it is in the set: use moveStoredObject
+    std::set<RawObject*, StoredObjectsOrder> storedObjects;
+    long nextOrderSequence;
+    std::vector<RawObject*> orderedObjects;
+    bool orderedObjectsDirty;
+    //Objects iterated by update, which may reorder storedObjects. Kept to reuse its storage
+    std::vector<RawObject*> updatedObjects;
+    //Objects waiting for commitBatch, retained, with their own (zOrder, insertion sequence). batchObjects may contain duplicates or destroyed objects
+    int batchDepth;
+    //Incremented each time the batch state is dropped, so that an open BatchScope doesn't commit after it
+    long batchGeneration;
+    std::vector<RawObject*> batchObjects;
+    std::unordered_map<RawObject*, std::pair<int, long>> batchOrders;
+    Vector<RawObject*> batchCreated;
+    //Indexes on storedObjects. Objects being added/removed are only indexed once actually added, and until actually removed
+    std::unordered_map<int, RawObject*> objectsById;
+    std::unordered_map<std::string, std::vector<RawObject*>> objectsByName;//values are in indexing order
+    
+    //World-space bounding boxes of stored objects, for position queries
+    SpatialGrid spatialIndex;
+    std::unordered_set<RawObject*> boundsToRefresh;
+    Vec2 indexedLayerPosition;
+    Vec2 indexedLayerScale;
     //Array containing panels, for easier retrieval when using Panel specific methods
     Vector<Panel*> storedPanels;
     //Allow to easily find the parent of any object
-    std::map<int, Panel*> childsParents;//keys are objects ID, values are Panel
+    std::unordered_map<int, Panel*> childsParents;//keys are objects ID, values are Panel
     
     //Lock add/remove during updating, and instead use the following vectors, which will be used to add/remove at the end of updating
     bool isUpdating;
@@ -26,11 +26,84 @@ THE SOFTWARE.
 #include "Shorteners.h"
 #include "AppMacros.h"
 #include "StringUtility.h"
-#include <sstream>
-#include <iomanip>
 #include "GraphicLayer.h"
+#include "TextureLoader.h"
+#include "TextureBudget.h"
 
 NS_FENNEX_BEGIN
+static bool useSpriteBatchNode = true;
+
+//Frames of each sheet, by file and capacity. Images keep a reference, so purging the cache doesn't affect existing images
+static std::map<std::pair<std::string, int>, std::shared_ptr<const Vector<SpriteFrame*>>> sheetFramesCache;
+
+//The name is part of the key because the frames user info carries it
+struct AnimationKey
+{
+    std::string file;
+    std::string name;
+    long framesCount;
+    float delay;
+    bool invert;
+    
+    bool operator<(const AnimationKey& other) const
+    {
+        return std::tie(file, name, framesCount, delay, invert) < std::tie(other.file, other.name, other.framesCount, other.delay, other.invert);
+    }
+};
+//Retained. Animate actions retain their Animation, so purging the cache doesn't affect running animations
+static std::map<AnimationKey, Animation*> animationsCache;
+//Tag of the RepeatForever started by runFullAnimation, to know if it was stopped from outside
+static const int FullAnimationTag = 0x46414E4D;
+
+//Load the sheet plist once, and resolve the frames named file_01.png, file_02.png ... up to capacity
+static std::shared_ptr<const Vector<SpriteFrame*>> getSheetFrames(const std::string& file, int capacity)
+{
+    auto key = std::make_pair(file, capacity);
+    auto cached = sheetFramesCache.find(key);
+    if(cached != sheetFramesCache.end())
+    {
+        return cached->second;
+    }
+    std::string fileNoExtension = file.substr(0, file.length() - 4);
+    SpriteFrameCache::getInstance()->addSpriteFramesWithFile(fileNoExtension + ".plist");
+    
+    auto frames = std::make_shared<Vector<SpriteFrame*>>();
+    frames->reserve(capacity);
+    char suffix[16];
+    for(int i = 1; i <= capacity; i++)
+    {
+        snprintf(suffix, sizeof(suffix), "_%02d.png", i);
+        SpriteFrame* frame = SpriteFrameCache::getInstance()->getSpriteFrameByName(fileNoExtension + suffix);
+        if(frame != nullptr)
+        {
+            frames->pushBack(frame);
+        }
+#if VERBOSE_WARNING
+        else
+        {
+            log("Warning : missing frame %s%s in sprite sheet", fileNoExtension.c_str(), suffix);
+        }
+#endif
+    }
+    sheetFramesCache[key] = frames;
+    return frames;
+}
+
+void Image::purgeAnimationCache()
+{
+    sheetFramesCache.clear();
+    for(const auto& animation : animationsCache)
+    {
+        animation.second->release();
+    }
+    animationsCache.clear();
+}
+
+void Image::setUseSpriteBatchNode(bool use)
+{
+    useSpriteBatchNode = use;
+}
+
 Rect Image::getBoundingBox()
 {
     return Rect(this->getNode()->getPositionX(), this->getNode()->getPositionY(), this->getNode()->getContentSize().width, this->getNode()->getContentSize().height);
@@ -47,22 +120,25 @@ Node* Image::getNode()
 }
 
 Image::Image():
-spriteSheet(nullptr),
+file(""),
 delegate(nullptr),
 runningAnimation(nullptr),
-file(""),
+spriteSheet(nullptr),
 loadingFile(""),
-isLoadingTexture(false)
+loadingHandle(0),
+textureUnloaded(false)
 {
-    
+    typeFlags |= TypeImage;
 }
 Image::Image(std::string filename, Vec2 location):
-spriteSheet(nullptr),
-runningAnimation(nullptr),
 file(filename),
+runningAnimation(nullptr),
+spriteSheet(nullptr),
 loadingFile(""),
-isLoadingTexture(false)
+loadingHandle(0),
+textureUnloaded(false)
 {
+    typeFlags |= TypeImage;
     name = filename;
     if(stringEndsWith(file, ".png") || stringEndsWith(file, ".jpg") || stringEndsWith(file, ".jpeg"))
     {
@@ -95,45 +171,43 @@ isLoadingTexture(false)
 }
 Image::Image(std::string filename, Vec2 location, int capacity):
 file(filename),
+runningAnimation(nullptr),
+spriteSheet(nullptr),
 loadingFile(""),
-isLoadingTexture(false)
+loadingHandle(0),
+textureUnloaded(false)
 {
+    typeFlags |= TypeImage;
     name = filename;
     if(!stringEndsWith(file, ".png"))
     { //Legacy compatibility
         file.append(".png");
     }
-    spriteSheet = SpriteBatchNode::create(file, capacity);
-    std::string plistFile = file;
-    plistFile.erase(plistFile.length() - 4, 4).append(".plist");
-    spriteSheet->retain();
-    SpriteFrameCache::getInstance()->addSpriteFramesWithFile(plistFile);
-    
-    spritesName.reserve(capacity);
-    std::string fileNoExtension = file;
-    fileNoExtension.erase(fileNoExtension.length() - 4, 4);
-    for(int i = 1; i <= capacity; i++)
+    if(useSpriteBatchNode)
     {
-        std::ostringstream spriteFileName;
-        spriteFileName << fileNoExtension << '_' << std::setw(2) << std::setfill('0') << i << ".png";
-        spritesName.push_back(spriteFileName.str());
+        spriteSheet = SpriteBatchNode::create(file, capacity);
+        spriteSheet->retain();
     }
+    spriteFrames = getSheetFrames(file, capacity);
+    typeFlags |= TypeAnimation;
     delegate = Sprite::create();
     delegate->retain();
-    SpriteFrame* firstFrame = SpriteFrameCache::getInstance()->getSpriteFrameByName(spritesName.at(0));
-    delegate->setSpriteFrame(firstFrame);
+    if(!spriteFrames->empty())
+    {
+        delegate->setSpriteFrame(spriteFrames->at(0));
+    }
     this->setPosition(location);
-    spriteSheet->addChild(delegate);
-    runningAnimation = nullptr;
+    IFEXIST(spriteSheet)->addChild(delegate);
 }
 
 Image::Image(Sprite* node):
-spritesName(0),
-spriteSheet(nullptr),
 runningAnimation(nullptr),
+spriteSheet(nullptr),
 loadingFile(""),
-isLoadingTexture(false)
+loadingHandle(0),
+textureUnloaded(false)
 {
+    typeFlags |= TypeImage;
     file = Director::getInstance()->getTextureCache()->getKeyForTexture(node->getTexture());
     long slashPos = file.rfind('/');
     if(slashPos != std::string::npos)
@@ -147,102 +221,114 @@ isLoadingTexture(false)
 
 Image::~Image()
 {
-    if(spriteSheet != nullptr)
+    if(loadingHandle != 0)
     {
-        spriteSheet->release();
-        spritesName.clear();
+        TextureLoader::sharedLoader()->cancel(loadingHandle);
     }
+    IFEXIST(spriteSheet)->release();
+    IFEXIST(runningAnimation)->release();
     delegate->release();
 #if VERBOSE_DEALLOC
     log("Dealloc image %s", name.c_str());
 #endif
 }
 
-void Image::runFullAnimation(float delay, bool invert)
+Animation* Image::getAnimation(float delay, bool invert)
 {
-    CCAssert(spriteSheet != nullptr, "Image runFullAnimation called on an object without spritesheet");
+    AnimationKey key = {file, name, (long)spriteFrames->size(), delay, invert};
+    auto cached = animationsCache.find(key);
+    if(cached != animationsCache.end())
+    {
+        return cached->second;
+    }
     Vector<AnimationFrame*> animationFrames;
-    for(int i = 0; i < spritesName.size(); i++)
+    animationFrames.reserve(spriteFrames->size());
+    for(int i = 0; i < spriteFrames->size(); i++)
     {
-        SpriteFrame* spriteFrame = SpriteFrameCache::getInstance()->getSpriteFrameByName(spritesName.at(invert ? spritesName.size() - i - 1 : i));
+        SpriteFrame* spriteFrame = spriteFrames->at(invert ? spriteFrames->size() - i - 1 : i);
         
+        //The animation is shared by the images with the same name: the event target (see getAnimationTarget) tells which image displayed the frame
         ValueMap infos;
-        infos["Name"] = Value(getName());
+        infos["Name"] = Value(name);
+        infos["Sheet"] = Value(file);
         infos["Index"] = Value(i);
         AnimationFrame* frame = AnimationFrame::create(spriteFrame, 1, infos);
         animationFrames.pushBack(frame);
     }
-    Action* action = RepeatForever::create(Animate::create(Animation::create(animationFrames, delay)));
-    if(runningAnimation != action)
+    Animation* animation = Animation::create(animationFrames, delay);
+    animation->retain();
+    animationsCache[key] = animation;
+    return animation;
+}
+
+void Image::runFullAnimation(float delay, bool invert)
+{
+    CCAssert(isAnimation(), "Image runFullAnimation called on an object without spritesheet");
+    Animation* animation = this->getAnimation(delay, invert);
+    //Don't restart the same animation if it is still running. The ActionManager doesn't reset the target of an action removed
+    //with stopAction or stopAllActions, so check that the action is still run by the delegate
+    if(runningAnimation != nullptr && delegate->getActionByTag(FullAnimationTag) == runningAnimation
+       && ((Animate*)((RepeatForever*)runningAnimation)->getInnerAction())->getAnimation() == animation)
+    {
+        return;
+    }
+    if(runningAnimation != nullptr)
     {
-        if(runningAnimation != nullptr)
-        {
-            delegate->stopAction(runningAnimation);
-        }
-        delegate->runAction(action);
-        runningAnimation = action;
+        delegate->stopAction(runningAnimation);
+        runningAnimation->release();
     }
+    runningAnimation = RepeatForever::create(Animate::create(animation));
+    runningAnimation->setTag(FullAnimationTag);
+    runningAnimation->retain();
+    delegate->runAction(runningAnimation);
 }
 
 Animate* Image::getFullAnimation(float delay, bool invert)
 {
-    CCAssert(spriteSheet != nullptr, "Image getFullAnimation called on an object without spritesheet");
-    Vector<AnimationFrame*> animationFrames;
-    for(int i = 0; i < spritesName.size(); i++)
+    CCAssert(isAnimation(), "Image getFullAnimation called on an object without spritesheet");
+    //The cached animation is shared by other images: give a copy that the caller can modify
+    Animation* animation = this->getAnimation(delay, invert);
+    Vector<AnimationFrame*> frames;
+    frames.reserve(animation->getFrames().size());
+    for(AnimationFrame* frame : animation->getFrames())
     {
-        SpriteFrame* spriteFrame = SpriteFrameCache::getInstance()->getSpriteFrameByName(spritesName.at(invert ? spritesName.size() - i - 1 : i));
-        
-        ValueMap infos;
-        infos["Name"] = Value(getName());
-        infos["Index"] = Value(i);
-        AnimationFrame* frame = AnimationFrame::create(spriteFrame, 1, infos);
-        animationFrames.pushBack(frame);
+        frames.pushBack(frame->clone());
     }
-    return Animate::create(Animation::create(animationFrames, delay));
+    return Animate::create(Animation::create(frames, animation->getDelayPerUnit(), animation->getLoops()));
 }
 
 Node* Image::getAnimationTarget()
 {
-    CCAssert(spriteSheet != nullptr, "Image getAnimationTarget called on an object without spritesheet");
+    CCAssert(isAnimation(), "Image getAnimationTarget called on an object without spritesheet");
     return delegate;
 }
 
 void Image::update(float deltaTime)
 {
-    if(!isLoadingTexture && !loadingFile.empty())
+    if(loadingHandle == 0 && !loadingFile.empty())
     {
-        isLoadingTexture = true;
-        int currentId = identifier;
-        Director::getInstance()->getTextureCache()->addImageAsync(loadingFile, [this, currentId](Texture2D* tex) {
-            //Before trying to load the texture, ensure the Image is still active and valid
-            if(GraphicLayer::sharedLayer()->first(currentId) == this) {
-                this->textureLoaded(tex);
-            }
-        });
+        //The request is cancelled if the Image is destroyed. If the texture is already loaded, the callback is called right away and 0 is returned
+        loadingHandle = TextureLoader::sharedLoader()->loadTexture(loadingFile, [this](Texture2D* tex) {
+            loadingHandle = 0;
+            this->textureLoaded(tex);
+        }, loadingPriority);
     }
 }
 
 void Image::loadAnimation(const char* filename, int capacity, bool useLastFrame)
 {
     file = filename;
-    spriteSheet = SpriteBatchNode::create(file, capacity);
-    spriteSheet->retain();
-    std::string plistFile = file;
-    plistFile.erase(plistFile.length() - 4, 4).append(".plist");
-    SpriteFrameCache::getInstance()->addSpriteFramesWithFile(plistFile);
-    
-    spritesName.reserve(capacity);
-    std::string fileNoExtension = file;
-    fileNoExtension.erase(fileNoExtension.length() - 4, 4);
-    for(int i = 1; i <= capacity; i++)
+    spriteFrames = getSheetFrames(file, capacity);
+    typeFlags |= TypeAnimation;
+    SpriteFrame* firstFrame = spriteFrames->at(!useLastFrame ? 0 : spriteFrames->size() - 1);
+    //If this is a previous animation, stop it first
+    if(runningAnimation != nullptr)
     {
-        std::ostringstream spriteFileName;
-        spriteFileName << fileNoExtension << '_' << std::setw(2) << std::setfill('0') << i << ".png";
-        spritesName.push_back(spriteFileName.str());
+        delegate->stopAction(runningAnimation);
+        runningAnimation->release();
+        runningAnimation = nullptr;
     }
-    SpriteFrame* firstFrame = SpriteFrameCache::getInstance()->getSpriteFrameByName(spritesName.at(!useLastFrame ? 0 : spritesName.size() - 1));
     Node* parent = delegate->getParent();
-    //If this is a previous animation, stop it first
     if(isKindOfClass(parent, SpriteBatchNode))
     {
         Node* realParent = parent->getParent();
@@ -251,23 +337,37 @@ void Image::loadAnimation(const char* filename, int capacity, bool useLastFrame)
         realParent->addChild(delegate);
         parent = realParent;
     }
-    parent->addChild(spriteSheet);
-    parent->removeChild(delegate, false);
+    IFEXIST(spriteSheet)->release();
+    spriteSheet = nullptr;
     delegate->setSpriteFrame(firstFrame);
-    spriteSheet->addChild(delegate);
-    spriteSheet->setContentSize(firstFrame->getOriginalSize());
-    runningAnimation = nullptr;
+    if(useSpriteBatchNode)
+    {
+        spriteSheet = SpriteBatchNode::create(file, capacity);
+        spriteSheet->retain();
+        parent->addChild(spriteSheet);
+        parent->removeChild(delegate, false);
+        spriteSheet->addChild(delegate);
+        spriteSheet->setContentSize(firstFrame->getOriginalSize());
+    }
+    //The collision depends on the spriteSheet
+    GraphicLayer::sharedLayer()->objectMoved(this);
 }
 
-void Image::replaceTexture(std::string filename, bool keepExactSize, bool async, bool keepRatio)
+void Image::replaceTexture(std::string filename, bool keepExactSize, bool async, bool keepRatio, float priority)
 {
     if(async)
     {
-        //Note : async will be done on next update to avoid the performance drop because of the overhead of addImageAsync,
+        //Note : async will be done on next update to avoid the performance drop because of the overhead of the request,
         //and in case the image already exists (which loads the image synchronously)
+        if(loadingHandle != 0)
+        {
+            TextureLoader::sharedLoader()->cancel(loadingHandle);
+            loadingHandle = 0;
+        }
         loadingFile = filename;
         loadingKeepExactSize = keepExactSize;
         loadingKeepRatio = keepRatio;
+        loadingPriority = priority;
     }
     else
     {
@@ -284,6 +384,8 @@ void Image::replaceTexture(std::string filename, bool keepExactSize, bool async,
             file = originalImageFile;
             return;
         }
+        TextureBudget::sharedBudget()->touch(newTexture, FileUtils::getInstance()->fullPathForFilename(file));
+        textureUnloaded = false;
         
         //If there is a spriteSheet, switch back normal delegate
         if(spriteSheet != nullptr)
@@ -294,7 +396,10 @@ void Image::replaceTexture(std::string filename, bool keepExactSize, bool async,
             parent->addChild(delegate);
             spriteSheet->release();
             spriteSheet = nullptr;
+            GraphicLayer::sharedLayer()->objectMoved(this);
         }
+        spriteFrames = nullptr;
+        typeFlags &= ~TypeAnimation;
         sprite->setTexture(newTexture);
         Rect textureRect = Rect(0, 0, newTexture->getContentSize().width, newTexture->getContentSize().height);
         //Change the textureRect to crop it if necessary
@@ -330,13 +435,42 @@ void Image::textureLoaded(Texture2D* tex)
     {
         this->replaceTexture(loadingFile, loadingKeepExactSize, false, loadingKeepRatio);
         loadingFile = "";
-        isLoadingTexture = false;
     }
 }
 
+bool Image::canUnloadTexture()
+{
+    return !textureUnloaded && !isAnimation() && loadingHandle == 0 && loadingFile.empty();
+}
+
+void Image::unloadTexture(Texture2D* placeholder, const std::string& textureKey)
+{
+    CCAssert(this->canUnloadTexture(), "Image unloadTexture called on an image which can't release its texture");
+    unloadedTextureKey = textureKey;
+    //Sprite::setTexture keeps the texture rect, so the reloaded texture will be displayed the same way
+    delegate->setTexture(placeholder);
+    textureUnloaded = true;
+}
+
+void Image::reloadTexture(float priority)
+{
+    if(!textureUnloaded || loadingHandle != 0)
+    {
+        return;
+    }
+    loadingHandle = TextureLoader::sharedLoader()->loadTexture(!unloadedTextureKey.empty() ? unloadedTextureKey : file, [this](Texture2D* tex) {
+        loadingHandle = 0;
+        if(tex != nullptr && textureUnloaded)
+        {
+            delegate->setTexture(tex);
+            textureUnloaded = false;
+        }
+    }, priority);
+}
+
 bool Image::isAnimation()
 {
-    return spriteSheet != nullptr;
+    return spriteFrames != nullptr;
 }
 
 bool Image::collision(Vec2 point)
@@ -49,6 +49,7 @@ public:
     //TODO : add more detailed animation methods
     //The first method is there to easily run a full animation. The 2 other to do custom things like delay/repeat/show/hide etc ...
     void runFullAnimation(float delay, bool invert = false); //delay is the delay between frames
+    //Return a new Animate, over a copy of the cached animation: modifying it doesn't affect other images
     Animate* getFullAnimation(float delay, bool invert = false);
     Node* getAnimationTarget();
     
@@ -60,13 +61,24 @@ public:
     /*replace the Image texture using a new file
      filename : the new image to be loaded (without extension)
      keepExactSize : will fit the new image inside the old one, by changing the Image scale
-     async : will defer the actual replace to next frame, and the texture will be loaded in async using TextureCache
+     async : will defer the actual replace to next frame, and the texture will be loaded in async using TextureLoader. Replaces a pending async load
      keepRatio : will crop the new image to have the same ratio as the previous one. Use keepExactSize to also have the same exact size
+     priority : for async loads, textures with a higher priority are decoded first
      */
-    void replaceTexture(std::string filename, bool keepExactSize = false, bool async = false, bool keepRatio = false);
+    void replaceTexture(std::string filename, bool keepExactSize = false, bool async = false, bool keepRatio = false, float priority = 0);
     void textureLoaded(Texture2D* tex);
+    Texture2D* getTexture() { return delegate->getTexture(); }
+    
+    //Used by TextureBudget to free the texture of images far from the screen: the texture is replaced by placeholder, keeping the size and texture rect
+    //Animations and images with a pending texture replace can't release their texture
+    bool canUnloadTexture();
+    void unloadTexture(Texture2D* placeholder, const std::string& textureKey);
+    //Load the released texture back asynchronously
+    void reloadTexture(float priority = 0);
+    bool isTextureUnloaded() { return textureUnloaded; }
     bool isAnimation();
     bool collision(Vec2 point); //Overload for spritesheet, which behaves differently
+    bool hasCollisionBeyondSize() { return spriteSheet != nullptr; }
     
     //Will generate a scaled image from fileToScale (using same extension)
     //fileToScale must be the full path. fileToSave must be only the filename, it will be saved in local path
@@ -74,23 +86,41 @@ public:
     //Throw event ImageScaled with "Name" key for filename
     static bool generateScaledImage(std::string fileToScale, std::string fileToSave, float scale);
     
+    //Sheets frames are cached and shared by all the images using the same sheet, animations by the images with the same sheet, name, delay and direction
+    //Animation frames user info has "Name", "Sheet" (the sheet file) and "Index". The displayed event target is the getAnimationTarget of the image
+    static void purgeAnimationCache();
+    /* By default, each animated Image has its own SpriteBatchNode: there is no SpriteBatchNode shared by the images of a sheet,
+     since each image keeps its own parent and draw order. Only the frames and animations are shared.
+     When disabled, animated images are plain sprites using the shared frames: the renderer already batches sprites of the same sheet
+     drawn one after another, without the quads buffer of a SpriteBatchNode per image. Only affects animations loaded afterward
+     */
+    static void setUseSpriteBatchNode(bool use);
+    
 protected:
     //the actual Sprite which will perform cocos2d actions
     Sprite* delegate;
     
-    //the animation action
+    //the animation action, retained
     Action* runningAnimation;
     
-    //nullptr if the object is not an animation
+    //nullptr if the object is not an animation, or if it doesn't use a SpriteBatchNode
     SpriteBatchNode* spriteSheet;
     
-    //empty if the object is not an animation, it is equal to animated sprites filenames in the plist
-    std::vector<std::string> spritesName;
+    //nullptr if the object is not an animation. Animated sprites frames from the plist, shared with other images using the same sheet
+    std::shared_ptr<const Vector<SpriteFrame*>> spriteFrames;
+    
+    //Cached animation of all the frames
+    Animation* getAnimation(float delay, bool invert);
     
     std::string loadingFile;
     bool loadingKeepExactSize;
     bool loadingKeepRatio;
-    bool isLoadingTexture;
+    float loadingPriority;
+    //TextureLoader handle of the pending async load or reload, 0 if there is none
+    long loadingHandle;
+    bool textureUnloaded;
+    //TextureCache key (full path) of the released texture. file can't be used to reload it, as it is only the basename for Images from CCB
+    std::string unloadedTextureKey;
 };
 NS_FENNEX_END
 
@@ -87,6 +87,7 @@ std::string InputLabel::getLabelValue()
 
 InputLabel::InputLabel() : delegate(nullptr)
 {
+    typeFlags |= TypeInputLabel;
     isOpened = false;
     originalInfos = nullptr;
     fontSize = -1;
@@ -95,6 +96,7 @@ InputLabel::InputLabel() : delegate(nullptr)
 
 InputLabel::InputLabel(ui::Scale9Sprite* sprite)
 {
+    typeFlags |= TypeInputLabel;
     isOpened = false;
     originalInfos = nullptr;
     fontSize = -1;
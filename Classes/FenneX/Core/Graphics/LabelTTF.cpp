@@ -124,11 +124,13 @@ LabelTTF::LabelTTF() :
 delegate(nullptr),
 loadingValue("")
 {
+    typeFlags |= TypeLabelTTF;
 }
 
 LabelTTF::LabelTTF(std::string labelString, std::string filename, Vec2 position, Size dimensions, TextHAlignment alignment) :
 loadingValue("")
 {
+    typeFlags |= TypeLabelTTF;
     name = labelString;
     fullText = labelString;
     fitType = CutEnd;
@@ -174,6 +176,7 @@ loadingValue("")
 LabelTTF::LabelTTF(Label* label) :
 loadingValue("")
 {
+    typeFlags |= TypeLabelTTF;
     name = label->getString();
     fullText = label->getString();
     fitType = CutEnd;
@@ -205,71 +208,307 @@ LabelTTF::~LabelTTF()
     delegate->release();
 }
 
-void LabelTTF::adjustLabel()
+/* Fit results cache: adjusting a label gives the same result for the same text, font, dimensions, fit type and starting scale,
+ so setting the same value again (or another label with the same parameters) doesn't measure anything
+ */
+struct LabelFitKey
 {
-    if(realDimensions.width != 0 && realDimensions.height != 0 && fitType != NoResize)
+    std::string text;
+    std::string font;
+    std::string fontFilePath;
+    float systemFontSize;
+    float fontSize;
+    int outlineSize;
+    bool distanceFieldEnabled;
+    float additionalKerning;
+    float lineSpacing;
+    cocos2d::Size dimensions;
+    LabelFitType fitType;
+    float scaleX;
+    float scaleY;
+    
+    bool operator<(const LabelFitKey& other) const
     {
-        bool wasChanged = false;
-        std::string original = fullText;
-        delegate->setString("l");
-        float lineHeight = delegate->getContentSize().height;
-        delegate->setString(original);
-
-        float scaleX = this->getScaleX();
-        float scaleY = this->getScaleY();
-        Size size = delegate->getContentSize();
-        
-        //Add a 5% margin for fitInside comparison since the algorithm underneath is not exact ....
-        bool fitInside = (size.height * scaleY <= realDimensions.height * 1.05 || (fitType == CutEnd && lineHeight >= size.height)) && size.width * scaleX <= realDimensions.width * 1.05;
-        
-        //Used by CutEnd to perform a binary search (optimization because Label::updateTexture is slow on Android)
-        //If you run into performance issues, you should also cache the CutEnd results
-        size_t end = utf8_len(original);
-        long start = fitInside || fitType != CutEnd ? end : 0; //If it already fit, bypass the while
-        
-        while((fitType != CutEnd && !fitInside)
-              || end - start > 1) //There is one character precision (it may cut one more character than necessary)
+        return std::tie(text, font, fontFilePath, systemFontSize, fontSize, outlineSize, distanceFieldEnabled, additionalKerning, lineSpacing, dimensions.width, dimensions.height, fitType, scaleX, scaleY)
+        < std::tie(other.text, other.font, other.fontFilePath, other.systemFontSize, other.fontSize, other.outlineSize, other.distanceFieldEnabled, other.additionalKerning, other.lineSpacing, other.dimensions.width, other.dimensions.height, other.fitType, other.scaleX, other.scaleY);
+    }
+};
+
+struct LabelFitResult
+{
+    std::string text;
+    float scaleX;
+    float scaleY;
+};
+
+//The cache is simply emptied when it is full, labels are usually set again with a few different values
+static const size_t maxFitCacheSize = 2048;
+static std::map<LabelFitKey, LabelFitResult> fitCache;
+
+void LabelTTF::purgeFitCache()
+{
+    fitCache.clear();
+}
+
+//Same as Label::getFirstWordLen
+static int getFirstWordLength(FontAtlas* atlas, const std::u32string& text, int start, int length, float maxLineWidth, float kerning)
+{
+    char32_t character = text[start];
+    if(StringUtils::isCJKUnicode(character) || StringUtils::isUnicodeSpace(character) || character == '\n')
+    {
+        return 1;
+    }
+    FontLetterDefinition letterDef;
+    if(!atlas->getLetterDefinitionForChar(character, letterDef))
+    {
+        return 1;
+    }
+    float contentScaleFactor = CC_CONTENT_SCALE_FACTOR();
+    float nextLetterX = letterDef.xAdvance + kerning;
+    int wordLength = 1;
+    for(int i = start + 1; i < length; i++)
+    {
+        character = text[i];
+        if(!atlas->getLetterDefinitionForChar(character, letterDef))
+        {
+            break;
+        }
+        float letterX = (nextLetterX + letterDef.offsetX) / contentScaleFactor;
+        if(maxLineWidth > 0 && letterX + letterDef.width > maxLineWidth && !StringUtils::isUnicodeSpace(character))
         {
-            wasChanged = true;
-            if(fitType == ResizeFont)
+            return wordLength;
+        }
+        nextLetterX += letterDef.xAdvance + kerning;
+        if(character == '\n' || StringUtils::isUnicodeSpace(character) || StringUtils::isCJKUnicode(character))
+        {
+            break;
+        }
+        wordLength++;
+    }
+    return wordLength;
+}
+
+/* Size the first length characters of text would take in the label, wrapped by word like Label::multilineTextWrapByWord,
+ computed from the glyphs advances of the font atlas, without updating the label. Kerning between pairs of letters is ignored
+ */
+static cocos2d::Size measureWithAtlas(Label* label, FontAtlas* atlas, const std::u32string& text, int length, float maxLineWidth)
+{
+    float contentScaleFactor = CC_CONTENT_SCALE_FACTOR();
+    float kerning = label->getAdditionalKerning();
+    int lines = 1;
+    float nextTokenX = 0;
+    float letterRight = 0;
+    float longestLine = 0;
+    FontLetterDefinition letterDef;
+    for(int index = 0; index < length;)
+    {
+        if(text[index] == '\n')
+        {
+            lines++;
+            nextTokenX = 0;
+            letterRight = 0;
+            index++;
+            continue;
+        }
+        int tokenLength = getFirstWordLength(atlas, text, index, length, maxLineWidth, kerning);
+        float tokenRight = letterRight;
+        float nextLetterX = nextTokenX;
+        bool newLine = false;
+        for(int i = index; i < index + tokenLength; i++)
+        {
+            char32_t character = text[i];
+            if(character == '\r' || !atlas->getLetterDefinitionForChar(character, letterDef))
             {
-                scaleX *= 0.9;
-                this->setScaleX(scaleX);
-                scaleY *= 0.9;
-                this->setScaleY(scaleY);
-                delegate->setDimensions(realDimensions.width / scaleX, 0);
-                size = delegate->getContentSize();
-                fitInside = size.height * scaleY <= realDimensions.height * 1.05 && size.width * scaleX <= realDimensions.width * 1.05;
+                continue;
             }
-            else if(fitType == CutEnd)
+            float letterX = (nextLetterX + letterDef.offsetX) / contentScaleFactor;
+            if(maxLineWidth > 0 && nextTokenX > 0 && letterX + letterDef.width > maxLineWidth && !StringUtils::isUnicodeSpace(character))
             {
-                std::string value = delegate->getString();
-                long middle = start + ((end - start) / 2);
-                value = utf8_substr(original, 0, middle);
-                CCAssert(value.length() != 0, "Invalid UTF8 string");
-                delegate->setString(value.c_str());
-                size = delegate->getContentSize();
-                //the 1.05 multiplier is there to avoid rounding issues
-                fitInside = (size.height * scaleY <= realDimensions.height * 1.05 || lineHeight >= size.height) && size.width * scaleX <= realDimensions.width * 1.05;
-                if(fitInside)
-                    start = middle;
-                else
-                    end = middle;
+                lines++;
+                nextTokenX = 0;
+                letterRight = 0;
+                newLine = true;
+                break;
             }
-            else
+            nextLetterX += letterDef.xAdvance + kerning;
+            tokenRight = nextLetterX / contentScaleFactor;
+        }
+        if(newLine)
+        {
+            continue;
+        }
+        nextTokenX = nextLetterX;
+        letterRight = tokenRight;
+        longestLine = MAX(longestLine, letterRight);
+        index += tokenLength;
+    }
+    float height = lines * label->getLineHeight() / contentScaleFactor + (lines - 1) * label->getLineSpacing();
+    return cocos2d::Size(maxLineWidth > 0 ? maxLineWidth : longestLine, height);
+}
+
+void LabelTTF::adjustLabel()
+{
+    if(realDimensions.width != 0 && realDimensions.height != 0 && fitType != NoResize)
+    {
+        const TTFConfig& ttfConfig = delegate->getTTFConfig();
+        LabelFitKey key = {fullText, fontFile, ttfConfig.fontFilePath, delegate->getSystemFontSize(), ttfConfig.fontSize,
+            ttfConfig.outlineSize, ttfConfig.distanceFieldEnabled, delegate->getAdditionalKerning(),
+            delegate->getLineSpacing(), realDimensions, fitType, this->getScaleX(), this->getScaleY()};
+        auto cached = fitCache.find(key);
+        if(cached == fitCache.end())
+        {
+            LabelFitResult result;
+            //System fonts don't have an atlas: they can only be measured by rendering the label
+            if(delegate->getFontAtlas() != nullptr ? !fitWithAtlas(result) : !fitWithLabel(result))
             {
-                log("Warning, unsupported fit type, won't cut");
                 return;
             }
+            if(fitCache.size() >= maxFitCacheSize)
+            {
+                fitCache.clear();
+            }
+            cached = fitCache.emplace(key, result).first;
+        }
+        const LabelFitResult& result = cached->second;
+        if(result.scaleX != this->getScaleX() || result.scaleY != this->getScaleY())
+        {
+            this->setScaleX(result.scaleX);
+            this->setScaleY(result.scaleY);
+            delegate->setDimensions(realDimensions.width / result.scaleX, 0);
+        }
+        //Label only lays out the text when it is needed, so the text set before adjusting costs nothing
+        delegate->setString(result.text);
+    }
+}
+
+bool LabelTTF::fitWithAtlas(LabelFitResult& result)
+{
+    FontAtlas* atlas = delegate->getFontAtlas();
+    std::u32string text;
+    if(!StringUtils::UTF8ToUTF32(fullText, text))
+    {
+        return fitWithLabel(result);
+    }
+    atlas->prepareLetterDefinitions(text);
+    float lineHeight = delegate->getLineHeight() / CC_CONTENT_SCALE_FACTOR();
+    result.text = fullText;
+    result.scaleX = this->getScaleX();
+    result.scaleY = this->getScaleY();
+    cocos2d::Size size = measureWithAtlas(delegate, atlas, text, (int)text.size(), realDimensions.width / result.scaleX);
+    
+    //Add a 5% margin for fitInside comparison, like when measuring with the Label
+    bool fitInside = (size.height * result.scaleY <= realDimensions.height * 1.05 || (fitType == CutEnd && lineHeight >= size.height)) && size.width * result.scaleX <= realDimensions.width * 1.05;
+    if(fitInside)
+    {
+        return true;
+    }
+    if(fitType == ResizeFont)
+    {
+        while(!fitInside)
+        {
+            result.scaleX *= 0.9;
+            result.scaleY *= 0.9;
+            size = measureWithAtlas(delegate, atlas, text, (int)text.size(), realDimensions.width / result.scaleX);
+            fitInside = size.height * result.scaleY <= realDimensions.height * 1.05 && size.width * result.scaleX <= realDimensions.width * 1.05;
+        }
+    }
+    else if(fitType == CutEnd)
+    {
+        //Same binary search and cut as when measuring with the Label, on the number of characters
+        if(text.size() <= 1)
+        {
+            return true;
         }
-        if(wasChanged && fitType == CutEnd)
+        int start = 0;
+        int end = (int)text.size();
+        int middle = end;
+        while(end - start > 1)
+        {
+            middle = start + ((end - start) / 2);
+            size = measureWithAtlas(delegate, atlas, text, middle, realDimensions.width / result.scaleX);
+            fitInside = (size.height * result.scaleY <= realDimensions.height * 1.05 || lineHeight >= size.height) && size.width * result.scaleX <= realDimensions.width * 1.05;
+            if(fitInside)
+                start = middle;
+            else
+                end = middle;
+        }
+        std::string value = utf8_substr(fullText, 0, middle);
+        result.text = utf8_substr(value, 0, utf8_len(value) - 3).append(".");
+    }
+    else
+    {
+        log("Warning, unsupported fit type, won't cut");
+        return false;
+    }
+    return true;
+}
+
+bool LabelTTF::fitWithLabel(LabelFitResult& result)
+{
+    bool wasChanged = false;
+    std::string original = fullText;
+    delegate->setString("l");
+    float lineHeight = delegate->getContentSize().height;
+    delegate->setString(original);
+
+    float scaleX = this->getScaleX();
+    float scaleY = this->getScaleY();
+    Size size = delegate->getContentSize();
+    
+    //Add a 5% margin for fitInside comparison since the algorithm underneath is not exact ....
+    bool fitInside = (size.height * scaleY <= realDimensions.height * 1.05 || (fitType == CutEnd && lineHeight >= size.height)) && size.width * scaleX <= realDimensions.width * 1.05;
+    
+    //Used by CutEnd to perform a binary search (optimization because Label::updateTexture is slow on Android)
+    //The results are cached by adjustLabel
+    size_t end = utf8_len(original);
+    long start = fitInside || fitType != CutEnd ? end : 0; //If it already fit, bypass the while
+    
+    while((fitType != CutEnd && !fitInside)
+          || end - start > 1) //There is one character precision (it may cut one more character than necessary)
+    {
+        wasChanged = true;
+        if(fitType == ResizeFont)
+        {
+            scaleX *= 0.9;
+            this->setScaleX(scaleX);
+            scaleY *= 0.9;
+            this->setScaleY(scaleY);
+            delegate->setDimensions(realDimensions.width / scaleX, 0);
+            size = delegate->getContentSize();
+            fitInside = size.height * scaleY <= realDimensions.height * 1.05 && size.width * scaleX <= realDimensions.width * 1.05;
+        }
+        else if(fitType == CutEnd)
         {
-            //TODO : refactor to compute the size with '.' instead of just replacing the last character
             std::string value = delegate->getString();
-            value = utf8_substr(value, 0, utf8_len(value) - 3).append(".");
+            long middle = start + ((end - start) / 2);
+            value = utf8_substr(original, 0, middle);
+            CCAssert(value.length() != 0, "Invalid UTF8 string");
             delegate->setString(value.c_str());
+            size = delegate->getContentSize();
+            //the 1.05 multiplier is there to avoid rounding issues
+            fitInside = (size.height * scaleY <= realDimensions.height * 1.05 || lineHeight >= size.height) && size.width * scaleX <= realDimensions.width * 1.05;
+            if(fitInside)
+                start = middle;
+            else
+                end = middle;
         }
+        else
+        {
+            log("Warning, unsupported fit type, won't cut");
+            return false;
+        }
+    }
+    if(wasChanged && fitType == CutEnd)
+    {
+        //TODO : refactor to compute the size with '.' instead of just replacing the last character
+        std::string value = delegate->getString();
+        value = utf8_substr(value, 0, utf8_len(value) - 3).append(".");
+        delegate->setString(value.c_str());
     }
+    result.text = delegate->getString();
+    result.scaleX = scaleX;
+    result.scaleY = scaleY;
+    return true;
 }
 
 void LabelTTF::update(float deltaTime)
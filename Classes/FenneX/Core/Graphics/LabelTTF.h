@@ -31,6 +31,8 @@ USING_NS_CC;
 #include "FenneXMacros.h"
 
 NS_FENNEX_BEGIN
+struct LabelFitResult;
+
 typedef enum
 {
     ResizeFont = 0,
@@ -71,12 +73,20 @@ public:
     std::string getFullFontFile();
     TextHAlignment getAlignment();
     
+    //Fit results are cached for all labels. Purge it if fonts are changed at runtime
+    static void purgeFitCache();
+    
 protected:
     //the actual Label which will perform cocos2d actions
     Label* delegate;
     
     cocos2d::Size realDimensions;
+    //Apply the fit type, using the cached result if this label was already adjusted with the same parameters
     void adjustLabel();
+    //Compute the fit from the glyphs of the font atlas, without laying out the Label. Return false if the fit type is unsupported
+    bool fitWithAtlas(LabelFitResult& result);
+    //Compute the fit by setting the string and measuring the Label, required for system fonts
+    bool fitWithLabel(LabelFitResult& result);
     std::string fontFile;
     std::string fullFontFile;
     std::string fullText;
@@ -48,114 +48,91 @@ LazyLoader::~LazyLoader()
 
 void LazyLoader::checkAll()
 {
-    for(FenneX::Image* image : images)
+    //Loads now instead of queuing, like addDynamicLoad with checkState. Only the objects close to the screen are checked
+    GraphicLayer* layer = GraphicLayer::sharedLayer();
+    Size bounds = Director::getInstance()->getOpenGLView()->getFrameSize();
+    candidates.clear();
+    layer->getObjectsInArea(Rect(-distance, -distance, bounds.width + distance * 2, bounds.height + distance * 2), candidates);
+    for(RawObject* obj : candidates)
     {
-        this->checkState(image);
+        auto it = entries.find(obj);
+        if(it != entries.end())
+        {
+            this->checkState(obj, it->second, true);
+        }
     }
-    for(FenneX::LabelTTF* label : labels)
+    //Objects which are not stored in GraphicLayer are not in its spatial index: check them all
+    for(auto& it : entries)
     {
-        this->checkState(label);
+        if(!it.second.loaded && !layer->containsObject(it.first))
+        {
+            this->checkState(it.first, it.second, true);
+        }
     }
 }
 
 void LazyLoader::loadAll()
 {
-    for(FenneX::Image* image : images)
-    {
-        this->loadImage(image);
-    }
-    for(FenneX::LabelTTF* label : labels)
+    for(auto& it : entries)
     {
-        this->loadLabel(label);
+        if(!it.second.loaded)
+        {
+            this->load(it.first, it.second);
+        }
     }
+    pendingLoads = decltype(pendingLoads)();
 }
 
-void LazyLoader::moveHappened(Vector<RawObject*> children)
+void LazyLoader::moveHappened(const Vector<RawObject*>& children)
 {
     for(RawObject* child : children)
     {
-        if(isKindOfClass(child, FenneX::Image))
+        auto it = entries.find(child);
+        if(it != entries.end())
         {
-            this->checkState((FenneX::Image*)child);
+            //Only the moved objects can go far away, the other loaded images don't need to be checked
+            if(unloadDistance > 0 && loadedImages.find(child) != loadedImages.end()
+               && GraphicLayer::sharedLayer()->getDistanceToScreen(child, it->second.size) > unloadDistance)
+            {
+                this->unload(child, it->second);
+            }
+            else
+            {
+                this->checkState(child, it->second, false);
+            }
         }
-        else if(isKindOfClass(child, FenneX::LabelTTF))
-        {
-            this->checkState((FenneX::LabelTTF*)child);
-        }
-        else if(isKindOfClass(child, Panel))
+        else if(isObjectOfType<Panel>(child))
         {
             this->moveHappened(((Panel*)child)->getChildren());
         }
     }
 }
 
-void LazyLoader::addDynamicLoad(FenneX::Image* image, std::string textureName, bool checkState)
+void LazyLoader::addDynamicLoad(FenneX::Image* image, const std::string& textureName, bool checkState)
 {
-    auto imagePos = std::find(images.begin(), images.end(), image);
-    if(imagePos != images.end())
-    {
-        //If an image is re-loaded, its texture and size might have changed. Remove it and reload it as new
-        auto index = std::distance(images.begin(), imagePos);
-        images.eraseObject(image);
-        textures.erase(textures.begin() + index);
-        sizes.erase(index);
-        loadedImages.eraseObject(image);
-    }
-    images.pushBack(image);
-    textures.push_back(textureName);
-    Size* size = new Size(SizeMult(image->getSize(), GraphicLayer::sharedLayer()->getRealScale(image)));
-    size->autorelease();
-    sizes.pushBack(size);
+    this->addEntry(image, false, textureName);
     if(checkState)
     {
-        this->checkState(image);
+        this->checkState(image, entries.at(image), true);
     }
 }
 
-void LazyLoader::addDynamicLoad(FenneX::LabelTTF* label, std::string string, bool checkState)
+void LazyLoader::addDynamicLoad(FenneX::LabelTTF* label, const std::string& string, bool checkState)
 {
-    auto labelPos = std::find(labels.begin(), labels.end(), label);
-    if(labelPos != labels.end())
-    {
-        //If an image is re-loaded, its texture and size might have changed. Remove it and reload it as new
-        auto index = std::distance(labels.begin(), labelPos);
-        labels.eraseObject(label);
-        strings.erase(strings.begin() + index);
-        labelSizes.erase(index);
-        loadedLabels.eraseObject(label);
-    }
-    labels.pushBack(label);
-    strings.push_back(string);
-    Size* size = new Size(SizeMult(label->getSize(), GraphicLayer::sharedLayer()->getRealScale(label)));
-    size->autorelease();
-    labelSizes.pushBack(size);
+    this->addEntry(label, true, string);
     if(checkState)
     {
-        this->checkState(label);
+        this->checkState(label, entries.at(label), true);
     }
 }
 
-void LazyLoader::addDynamicLoadFunc(FenneX::Image* image, std::string key, std::function<std::string(std::string)> getTextureName, bool checkState)
+void LazyLoader::addDynamicLoadFunc(FenneX::Image* image, const std::string& key, std::function<std::string(std::string)> getTextureName, bool checkState)
 {
-    auto imagePos = std::find(images.begin(), images.end(), image);
-    if(imagePos != images.end())
-    {
-        //If an image is re-loaded, its texture and size might have changed. Remove it and reload it as new
-        auto index = std::distance(images.begin(), imagePos);
-        images.eraseObject(image);
-        textures.erase(textures.begin() + index);
-        sizes.erase(index);
-        loadedImages.eraseObject(image);
-    }
-    images.pushBack(image);
-    textures.push_back(key);
+    this->addEntry(image, false, key);
     texturesFuncs[key] = getTextureName;
-    Size* size = new Size(SizeMult(image->getSize(), GraphicLayer::sharedLayer()->getRealScale(image)));
-    size->autorelease();
-    sizes.pushBack(size);
     if(checkState)
     {
-        this->checkState(image);
+        this->checkState(image, entries.at(image), true);
     }
 }
 
@@ -163,68 +140,120 @@ void LazyLoader::init()
 {
     this->clear();
     distance = MAX(Director::getInstance()->getWinSize().width, Director::getInstance()->getWinSize().height);
+    unloadDistance = distance * 2;
+    loadsPerFrame = 4;
 }
 
 void LazyLoader::clear()
 {
-    images.clear();
-    textures.clear();
-    sizes.clear();
+    for(auto& it : entries)
+    {
+        it.first->release();
+    }
+    entries.clear();
     loadedImages.clear();
-    labels.clear();
-    strings.clear();
-    labelSizes.clear();
-    loadedLabels.clear();
+    pendingLoads = decltype(pendingLoads)();
 }
 
-void LazyLoader::checkState(FenneX::Image* img)
+void LazyLoader::update(float deltaTime)
 {
-    if(images.find(img) != images.end()
-       && loadedImages.find(img) == loadedImages.end()
-       && GraphicLayer::sharedLayer()->isCloseToScreen(img, *sizes.at(images.getIndex(img)), distance))
+    int loads = 0;
+    while(!pendingLoads.empty() && (loadsPerFrame <= 0 || loads < loadsPerFrame))
     {
-        this->loadImage(img);
+        RawObject* obj = pendingLoads.top().second;
+        pendingLoads.pop();
+        auto it = entries.find(obj);
+        //An object can be queued several times, it's only loaded once
+        if(it != entries.end() && !it->second.loaded)
+        {
+            //Objects which went away since being queued are skipped
+            float objDistance = GraphicLayer::sharedLayer()->getDistanceToScreen(obj, it->second.size);
+            if(objDistance < this->getLoadDistance(it->second))
+            {
+                this->load(obj, it->second, MAX(objDistance, 0));
+                loads++;
+            }
+        }
     }
 }
 
-void LazyLoader::loadImage(FenneX::Image* img)
+void LazyLoader::addEntry(RawObject* obj, bool isLabel, const std::string& value)
 {
-    if(images.find(img) != images.end()
-       && loadedImages.find(img) == loadedImages.end())
+    auto it = entries.find(obj);
+    if(it == entries.end())
     {
-        std::string texture = textures.at(images.getIndex(img));
-        if(texturesFuncs.find(texture) != texturesFuncs.end())
-        {
-            std::string key = texture;
-            texture = texturesFuncs[key](key);
-            textures.at(images.getIndex(img)) = texture;
-            texturesFuncs.erase(texturesFuncs.find(key));
-        }
-        if(texture != "")
-        {
-            img->replaceTexture(texture, true, true, true);
-        }
-        loadedImages.pushBack(img);
+        obj->retain();
+        Entry& entry = entries[obj];
+        entry.initialTexture = isLabel ? "" : ((FenneX::Image*)obj)->getFile();
+        it = entries.find(obj);
     }
+    //If an object is re-loaded, its texture and size might have changed: reload it as new, but keep its initial texture for unloading
+    Entry& entry = it->second;
+    entry.isLabel = isLabel;
+    entry.value = value;
+    entry.size = SizeMult(obj->getSize(), GraphicLayer::sharedLayer()->getRealScale(obj));
+    entry.loaded = false;
+    loadedImages.erase(obj);
 }
 
-void LazyLoader::checkState(FenneX::LabelTTF* label)
+void LazyLoader::checkState(RawObject* obj, Entry& entry, bool loadNow)
 {
-    if(labels.find(label) != labels.end()
-       && loadedLabels.find(label) == loadedLabels.end()
-       && GraphicLayer::sharedLayer()->isOnScreen(label, *labelSizes.at(labels.getIndex(label))))
+    if(!entry.loaded)
     {
-        this->loadLabel(label);
+        float objDistance = GraphicLayer::sharedLayer()->getDistanceToScreen(obj, entry.size);
+        if(objDistance < this->getLoadDistance(entry))
+        {
+            if(loadNow)
+            {
+                this->load(obj, entry, MAX(objDistance, 0));
+            }
+            else
+            {
+                pendingLoads.push(std::make_pair(MAX(objDistance, 0), obj));
+            }
+        }
     }
 }
 
-void LazyLoader::loadLabel(FenneX::LabelTTF* label)
+float LazyLoader::getLoadDistance(const Entry& entry)
 {
-    if(labels.find(label) != labels.end()
-       && loadedLabels.find(label) == loadedLabels.end())
+    //Labels are only loaded once on screen
+    return entry.isLabel ? 0 : distance;
+}
+
+void LazyLoader::load(RawObject* obj, Entry& entry, float objDistance)
+{
+    if(entry.isLabel)
+    {
+        ((FenneX::LabelTTF*)obj)->setLabelValue(entry.value, false);
+    }
+    else
     {
-        label->setLabelValue(strings.at(labels.getIndex(label)), false);
-        loadedLabels.pushBack(label);
+        if(texturesFuncs.find(entry.value) != texturesFuncs.end())
+        {
+            std::string key = entry.value;
+            entry.value = texturesFuncs[key](key);
+            texturesFuncs.erase(texturesFuncs.find(key));
+        }
+        if(entry.value != "")
+        {
+            //Closest textures are decoded first
+            ((FenneX::Image*)obj)->replaceTexture(entry.value, true, true, true, -objDistance);
+            if(!entry.initialTexture.empty())
+            {
+                loadedImages.insert(obj);
+            }
+        }
     }
+    entry.loaded = true;
 }
+
+void LazyLoader::unload(RawObject* obj, Entry& entry)
+{
+    //Async too, so that it replaces a load which may not be done yet. Lower priority than any load
+    ((FenneX::Image*)obj)->replaceTexture(entry.initialTexture, true, true, true, -unloadDistance);
+    entry.loaded = false;
+    loadedImages.erase(obj);
+}
+
 NS_FENNEX_END
@@ -27,47 +27,85 @@ THE SOFTWARE.
 
 #include "Image.h"
 #include "LabelTTF.h"
+#include "Pausable.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <queue>
 
 USING_NS_CC;
 
 
 NS_FENNEX_BEGIN
-class LazyLoader : public Ref
+/* Load textures of Images and values of Labels only when they get close to the screen
+ Objects reported by moveHappened are queued, then loaded by distance to the screen (closest first), with a limited number of loads per frame.
+ Pending loads which went away before being done are skipped.
+ addDynamicLoad with checkState and checkAll load close objects right away instead, like moveHappened used to.
+ Textures are loaded asynchronously by TextureLoader, with the distance to the screen as priority.
+ Images going far away from the screen are reverted to the texture they had when they were added, so that their texture can be released
+ */
+class LazyLoader : public Ref, public Pausable
 {
 public:
     static LazyLoader* sharedLoader(void);
     ~LazyLoader();
-    void moveHappened(Vector<RawObject*> children);
+    //Queue the loads of the moved objects (and the children of moved Panels) which got close, and unload those which went far away
+    void moveHappened(const Vector<RawObject*>& children);
+    /* Load the objects close to the screen now, found using GraphicLayer spatial index. Objects which are not stored in GraphicLayer are all checked.
+     The index picks up changes done directly on a Node at GraphicLayer next update, like its position queries
+     */
     void checkAll();
     //Force load of all lazy-loaded objects
     void loadAll();
-    void addDynamicLoad(Image* image, std::string textureName, bool checkState = true);
-    void addDynamicLoad(LabelTTF* label, std::string string, bool checkState = true);
+    void addDynamicLoad(Image* image, const std::string& textureName, bool checkState = true);
+    void addDynamicLoad(LabelTTF* label, const std::string& string, bool checkState = true);
     //Allow to defer textureName resolving to when it is really needed (in case getting textureName is time-consuming)
-    void addDynamicLoadFunc(Image* image, std::string key, std::function<std::string(std::string)> getTextureName, bool checkState = true);
+    void addDynamicLoadFunc(Image* image, const std::string& key, std::function<std::string(std::string)> getTextureName, bool checkState = true);
     void clear();
+    
+    //Maximum number of texture replacements and label updates done per frame, 0 for no limit. Default 4
+    void setLoadsPerFrame(int loads) { loadsPerFrame = loads; }
+    //Images further than this distance from the screen get their initial texture back, 0 to never unload. Default twice the load distance
+    void setUnloadDistance(float newDistance) { unloadDistance = newDistance; }
+    
+    //Run the queued loads within the frame budget
+    virtual void update(float deltaTime);
 protected:
     void init();
-    void checkState(Image* img);
-    void loadImage(Image* img);
-    void checkState(LabelTTF* label);
-    void loadLabel(LabelTTF* label);
+    
+    struct Entry
+    {
+        bool isLabel;
+        std::string value; //Texture name, key of texturesFuncs, or label string
+        std::string initialTexture; //Texture to use when unloading an Image
+        cocos2d::Size size; //Size when added, kept for better performance
+        bool loaded;
+    };
+    
+    //Add or replace the entry. If an object is re-loaded, its texture and size might have changed, so it is reloaded as new
+    void addEntry(RawObject* obj, bool isLabel, const std::string& value);
+    //If the object is not loaded and close enough to the screen, load it now or queue it
+    void checkState(RawObject* obj, Entry& entry, bool loadNow);
+    //Distance to the screen under which an entry is loaded
+    float getLoadDistance(const Entry& entry);
+    //objDistance is used as the texture decode priority: the closest first
+    void load(RawObject* obj, Entry& entry, float objDistance = 0);
+    void unload(RawObject* obj, Entry& entry);
     
     //limit distance
     float distance;
+    float unloadDistance;
+    int loadsPerFrame;
     
-    //Images
-    Vector<Image*> images; //The images which should load dynamically
-    std::vector<std::string> textures; //The textures associated with those images
-    Vector<cocos2d::Size*> sizes; //The sizes of images, kept for better performance
-    Vector<Image*> loadedImages; //The loaded image to avoid reloading images
+    //All lazy-loaded objects, retained
+    std::unordered_map<RawObject*, Entry> entries;
     std::map<std::string, std::function<std::string(std::string)>> texturesFuncs;
+    //Loaded images, which may need to be unloaded
+    std::unordered_set<RawObject*> loadedImages;
     
-    //Labels
-    Vector<LabelTTF*> labels; //The labels which should load dynamically
-    std::vector<std::string> strings; //The string associated with those labels
-    Vector<cocos2d::Size*> labelSizes; //The sizes of labels, kept for better performance
-    Vector<LabelTTF*> loadedLabels; //The loaded labels to avoid reloading labels
+    //Objects to load, closest to the screen first. Their distance is checked again before loading them
+    typedef std::pair<float, RawObject*> PendingLoad;
+    std::priority_queue<PendingLoad, std::vector<PendingLoad>, std::greater<PendingLoad>> pendingLoads;
+    std::vector<RawObject*> candidates;
 };
 
 NS_FENNEX_END
@@ -57,6 +57,8 @@ void Panel::setNode(Node* node)
     
     delegate = node;
     delegate->retain();
+    //Children cached world state depends on this panel being a crop node
+    GraphicLayer::sharedLayer()->objectMoved(this);
 }
 
 bool Panel::isACropNode()
@@ -69,10 +71,13 @@ void Panel::setClippingNode()
     ClippingNode* clipNode = ClippingNode::create();
     this->setNode(clipNode);
     clipNode->setSquareStencil();
+    //Crops are axis-aligned most of the time: use a scissor then, the stencil is only used when rotated
+    clipNode->setScissorEnabled(true);
 }
 
 Panel::Panel(std::string panelName, Vec2 location)
 {
+    typeFlags |= TypePanel;
     delegate = Node::create();
     delegate->retain();
     delegate->setPosition(location);
@@ -81,6 +86,7 @@ Panel::Panel(std::string panelName, Vec2 location)
 
 Panel::Panel(Node* node, std::string panelName)
 {
+    typeFlags |= TypePanel;
     name = panelName != "" ? panelName : "Panel";
     delegate = node;
     delegate->retain();
@@ -136,7 +142,7 @@ void Panel::reorderChild(RawObject* child, int zOrder)
     }
 }
 
-Vector<RawObject*> Panel::getChildren()
+const Vector<RawObject*>& Panel::getChildren()
 {
     return children;
 }
@@ -152,9 +158,10 @@ bool Panel::collision(Vec2 point)
     {
         return true;
     }
-    else if(isValueOfType(eventInfos["InfiniteScrolling"], BOOLEAN) && eventInfos["InfiniteScrolling"].asBool())
+    else if(isValueOfType(this->getEventInfo("InfiniteScrolling"), BOOLEAN) && this->getEventInfo("InfiniteScrolling").asBool())
     {
-        bool vertical = isValueOfType(eventInfos["isVertical"], BOOLEAN) && eventInfos["isVertical"].asBool();
+        const Value& isVertical = this->getEventInfo(EventInfoKey::IsVertical);
+        bool vertical = isValueOfType(isVertical, BOOLEAN) && isVertical.asBool();
         if(vertical
            && point.x > this->getPosition().x - this->getSize().width * this->getNode()->getAnchorPoint().x  * this->getScaleX()
            && point.x < this->getPosition().x + this->getSize().width * (1-this->getNode()->getAnchorPoint().x)  * this->getScaleX())
@@ -40,7 +40,7 @@ public:
     
     //WARNING : experimental method, used to replace the standard node by a ClippingNode
     void setNode(Node* node);
-    void setClippingNode(); //Will replace itself by a ClippingNode with a DrawNode stencil using ContentSize
+    void setClippingNode(); //Will replace itself by a ClippingNode using ContentSize: a scissor rectangle when axis-aligned, a DrawNode stencil otherwise
     //This function is solely used to determine if the current panel has used setClippingNode() and is therefore a clippingNode()
     //This function is currently only used to avoid images being clickable while they are out of there parent cropNode
     bool isACropNode();
@@ -54,7 +54,7 @@ public:
     void removeChild(RawObject* child);
     void reorderChild(RawObject* child, int zOrder);
     void clear();
-    Vector<RawObject*> getChildren();
+    const Vector<RawObject*>& getChildren();
     
     //TODO : reorder methods when needed by GraphicLayer (protected and friend GraphicLayer ?)
     
@@ -25,8 +25,32 @@ THE SOFTWARE.
 #include "RawObject.h"
 #include "GraphicLayer.h"
 #include "Shorteners.h"
+#include "Panel.h"
+#include "CustomObject.h"
+#include "Image.h"
+#include "LabelTTF.h"
 
 NS_FENNEX_BEGIN
+namespace EventInfoKey
+{
+    const std::string Sender = "Sender";
+    const std::string Scene = "Scene";
+    const std::string IsVertical = "isVertical";
+    const std::string OriginalImageFile = "_OriginalImageFile";
+    const std::string TouchPositionX = "TouchPositionX";
+    const std::string TouchPositionY = "TouchPositionY";
+}
+
+void RawObject::setName(const std::string& newName)
+{
+    if(name.compare(newName))
+    {
+        std::string previousName = name;
+        name = newName;
+        GraphicLayer::sharedLayer()->updateNameIndex(this, previousName);
+    }
+}
+
 const Vec2& RawObject::getPosition()
 {
     return this->getNode()->getPosition();
@@ -34,10 +58,12 @@ const Vec2& RawObject::getPosition()
 void RawObject::setPosition(const Vec2& newPosition)
 {
     this->getNode()->setPosition(newPosition);
+    GraphicLayer::sharedLayer()->objectMoved(this);
 }
 void RawObject::setVisible(bool newVisible)
 {
     this->getNode()->setVisible(newVisible);
+    GraphicLayer::sharedLayer()->objectMoved(this);
 }
 bool RawObject::isVisible()
 {
@@ -58,6 +84,7 @@ const float RawObject::getScale()
 void RawObject::setScale(const float newScale)
 {
     this->getNode()->setScale(newScale);
+    GraphicLayer::sharedLayer()->objectMoved(this);
 }
 const float RawObject::getScaleX()
 {
@@ -66,6 +93,7 @@ const float RawObject::getScaleX()
 void RawObject::setScaleX(const float newScale)
 {
     this->getNode()->setScaleX(newScale);
+    GraphicLayer::sharedLayer()->objectMoved(this);
 }
 const float RawObject::getScaleY()
 {
@@ -74,6 +102,7 @@ const float RawObject::getScaleY()
 void RawObject::setScaleY(const float newScale)
 {
     this->getNode()->setScaleY(newScale);
+    GraphicLayer::sharedLayer()->objectMoved(this);
 }
 
 void RawObject::setOpacity(GLubyte opacity)
@@ -88,7 +117,7 @@ GLubyte RawObject::getOpacity()
 
 void RawObject::setOpacityRecursive(GLubyte opacity)
 {
-    if(isKindOfClass(this, Panel))
+    if(isObjectOfType<Panel>(this))
     {
         for(RawObject* target : ((Panel*)this)->getChildren())
         {
@@ -103,51 +132,145 @@ void RawObject::setOpacityRecursive(GLubyte opacity)
 
 ValueMap RawObject::getEventInfos() const
 {
-    ValueMap infos = eventInfos;
-    if(infos["Sender"].isNull())
+    ValueMap infos = this->getEventInfosRef();
+    if(infos[EventInfoKey::Sender].isNull())
     {
-        infos["Sender"] = Value(identifier);
+        infos[EventInfoKey::Sender] = sender;
     }
     return infos;
 }
 
-Value RawObject::getEventInfo(std::string key) const
+const ValueMap& RawObject::getEventInfosRef() const
+{
+    static const ValueMap empty;
+    return eventInfos != nullptr ? *eventInfos : empty;
+}
+
+const Value& RawObject::getEventInfo(const std::string& key) const
+{
+    const ValueMap& infos = this->getEventInfosRef();
+    auto it = infos.find(key);
+    if(it != infos.end() && !it->second.isNull())
+    {
+        return it->second;
+    }
+    return key == EventInfoKey::Sender ? sender : Value::Null;
+}
+
+ValueMap& RawObject::editEventInfos()
 {
-    return getEventInfos()[key];
+    if(eventInfos == nullptr)
+    {
+        eventInfos = std::make_shared<ValueMap>();
+    }
+    else if(eventInfos.use_count() > 1)
+    {
+        eventInfos = std::make_shared<ValueMap>(*eventInfos);
+    }
+    eventInfosVersion++;
+    return *eventInfos;
+}
+
+std::shared_ptr<const Value> RawObject::getTouchEventInfos(const Vec2& position)
+{
+    bool reuse = touchEventInfos != nullptr && touchEventInfos.use_count() == 1 && touchEventInfosVersion == eventInfosVersion;
+    //The payload is dispatched as a void*, so a listener can still modify it: never reuse one with added or removed keys
+    if(reuse && touchEventInfos->asValueMap().size() != touchEventInfosSize)
+    {
+        CCASSERT(false, "A listener modified the touch event infos in place, copy them instead");
+        reuse = false;
+    }
+#if COCOS2D_DEBUG > 0
+    if(reuse)
+    {
+        const ValueMap& infos = touchEventInfos->asValueMap();
+        ValueMap expected = this->getEventInfos();
+        for(const std::string* key : {&EventInfoKey::TouchPositionX, &EventInfoKey::TouchPositionY})
+        {
+            auto found = infos.find(*key);
+            if(found != infos.end())
+            {
+                expected[*key] = found->second;
+            }
+        }
+        reuse = expected == infos;
+        CCASSERT(reuse, "A listener modified the touch event infos in place, copy them instead");
+    }
+#endif
+    if(!reuse)
+    {
+        touchEventInfos = std::make_shared<Value>(this->getEventInfos());
+        touchEventInfosVersion = eventInfosVersion;
+    }
+    ValueMap& infos = touchEventInfos->asValueMap();
+    infos[EventInfoKey::TouchPositionX] = Value(position.x);
+    infos[EventInfoKey::TouchPositionY] = Value(position.y);
+    touchEventInfosSize = infos.size();
+    return touchEventInfos;
 }
 
-void RawObject::setEventInfo(std::string key, Value obj)
+void RawObject::setEventInfo(const std::string& key, const Value& obj)
 {
-    eventInfos[key] = obj;
+    this->editEventInfos()[key] = obj;
 }
 
-void RawObject::addEventInfos(ValueMap infos)
+void RawObject::addEventInfos(const ValueMap& infos)
 {
-    for(ValueMap::iterator it = infos.begin(); it != infos.end(); ++it) {
-        if(it->first != "Sender")
+    if(infos.empty())
+    {
+        return;
+    }
+    ValueMap& ownInfos = this->editEventInfos();
+    for(auto it = infos.begin(); it != infos.end(); ++it) {
+        if(it->first != EventInfoKey::Sender)
         {
-            eventInfos[it->first] = it->second;
+            ownInfos[it->first] = it->second;
         }
     }
 }
 
-void RawObject::removeEventInfo(std::string key)
+void RawObject::shareEventInfos(const RawObject* other)
+{
+    const ValueMap& otherInfos = other->getEventInfosRef();
+    //A Sender set explicitly is never copied, so it can't be shared either
+    if(this->getEventInfosRef().empty() && otherInfos.find(EventInfoKey::Sender) == otherInfos.end())
+    {
+        eventInfos = other->eventInfos;
+        eventInfosVersion++;
+    }
+    else
+    {
+        this->addEventInfos(otherInfos);
+    }
+}
+
+void RawObject::removeEventInfo(const std::string& key)
 {
-    eventInfos.erase(key);
+    if(this->getEventInfosRef().find(key) != this->getEventInfosRef().end())
+    {
+        this->editEventInfos().erase(key);
+    }
 }
 
 RawObject::RawObject():
-name(""),
 eventName(""),
-isEventActivated(true)
+isEventActivated(true),
+name(""),
+eventInfosVersion(0),
+touchEventInfosVersion(0),
+touchEventInfosSize(0),
+typeFlags(0)
 {
-    eventInfos = ValueMap();
     identifier = GraphicLayer::sharedLayer()->getNextId();
+    sender = Value(identifier);
+    localState.node = nullptr;
+    localState.version = 0;
+    localState.visible = false;
+    parentsState.valid = false;
 }
 
 RawObject::~RawObject()
 {
-    eventInfos.clear();
 }
 
 bool RawObject::collision(Vec2 point)
@@ -192,22 +315,71 @@ bool RawObject::containsRect(Rect rect)
 
 bool operator<(const RawObject& obj1, const RawObject& obj2)
 {
-    if(isValueOfType(obj1.getEventInfos()["Order"], INTEGER) &&
-       isValueOfType(obj2.getEventInfos()["Order"], INTEGER))
+    const Value& obj1Order = obj1.getEventInfo("Order");
+    const Value& obj2Order = obj2.getEventInfo("Order");
+    if(isValueOfType(obj1Order, INTEGER) && isValueOfType(obj2Order, INTEGER))
     {
-        int obj1Order = obj1.getEventInfos()["Order"].asInt();
-        int obj2Order = obj2.getEventInfos()["Order"].asInt();
-        return obj1Order < obj2Order;
+        return obj1Order.asInt() < obj2Order.asInt();
     }
-    if(isValueOfType(obj1.getEventInfos()["Index"], INTEGER) &&
-       isValueOfType(obj2.getEventInfos()["Index"], INTEGER))
+    const Value& obj1Index = obj1.getEventInfo("Index");
+    const Value& obj2Index = obj2.getEventInfo("Index");
+    if(isValueOfType(obj1Index, INTEGER) && isValueOfType(obj2Index, INTEGER))
     {
-        int obj1Order = obj1.getEventInfos()["Index"].asInt();
-        int obj2Order = obj2.getEventInfos()["Index"].asInt();
-        return obj1Order < obj2Order;
+        return obj1Index.asInt() < obj2Index.asInt();
     }
     //If all else fails, order them by screen zorder
     GraphicLayer* layer = GraphicLayer::sharedLayer();
     return layer->isInFront(layer->first(obj1.getID()), layer->first(obj2.getID()));
 }
+
+void benchmarkObjectTypes(int count, int iterations)
+{
+    //Plain objects, never added to GraphicLayer, so that the benchmark doesn't change the application state
+    std::vector<RawObject*> objects;
+    objects.reserve(count);
+    for(int i = 0; i < count; i++)
+    {
+        Node* node = Node::create();
+        objects.push_back(i % 2 == 0 ? (RawObject*)new Panel(node) : (RawObject*)new CustomObject(node));
+    }
+    
+    //Same checks as the layer does on each object: Panel for the subtree walks, then the leaf types
+    timeval startTime;
+    timeval endTime;
+    long matches[2] = {0, 0};
+    gettimeofday(&startTime, nullptr);
+    for(int i = 0; i < iterations; i++)
+    {
+        for(RawObject* obj : objects)
+        {
+            if(isKindOfClass(obj, Panel)) matches[0]++;
+            else if(isKindOfClass(obj, Image)) matches[0]++;
+            else if(isKindOfClass(obj, LabelTTF)) matches[0]++;
+            else if(isKindOfClass(obj, CustomObject)) matches[0]++;
+        }
+    }
+    gettimeofday(&endTime, nullptr);
+    float dynamicCastTime = getTimeDifferenceMS(startTime, endTime) / iterations;
+    gettimeofday(&startTime, nullptr);
+    for(int i = 0; i < iterations; i++)
+    {
+        for(RawObject* obj : objects)
+        {
+            if(isObjectOfType<Panel>(obj)) matches[1]++;
+            else if(isObjectOfType<Image>(obj)) matches[1]++;
+            else if(isObjectOfType<LabelTTF>(obj)) matches[1]++;
+            else if(isObjectOfType<CustomObject>(obj)) matches[1]++;
+        }
+    }
+    gettimeofday(&endTime, nullptr);
+    float flagsTime = getTimeDifferenceMS(startTime, endTime) / iterations;
+    CCAssert(matches[0] == matches[1], "benchmarkObjectTypes: type flags and dynamic_cast disagree");
+    
+    for(RawObject* obj : objects)
+    {
+        obj->release();
+    }
+    log("Object types benchmark on %d objects, average of %d iterations: type checks with dynamic_cast %f ms, with type flags %f ms",
+        count, iterations, dynamicCastTime, flagsTime);
+}
 NS_FENNEX_END
@@ -32,13 +32,48 @@ USING_NS_CC;
 #include "FenneXMacros.h"
 
 NS_FENNEX_BEGIN
+class Panel;
+
+/* Keys used by FenneX in event infos, as shared string constants. They are not interned: event infos are cocos ValueMaps, keyed by std::string,
+ and listeners and saved plists use the same maps. A lookup still hashes and compares the string,
+ but using them on hot paths avoids building a temporary std::string from a literal for each lookup
+ */
+namespace EventInfoKey
+{
+    extern const std::string Sender;
+    extern const std::string Scene;
+    extern const std::string IsVertical; //"isVertical"
+    extern const std::string OriginalImageFile; //"_OriginalImageFile"
+    extern const std::string TouchPositionX;
+    extern const std::string TouchPositionY;
+}
+
 class RawObject : public Ref
 {
-    CC_SYNTHESIZE_STRING(name, Name);
+    friend class GraphicLayer;
     CC_SYNTHESIZE_STRING(eventName, EventName);
     CC_SYNTHESIZE(bool, isEventActivated, EventActivated);
     CC_SYNTHESIZE_READONLY(int, identifier, ID);
 public:
+    /* Type of the object, as flags: each constructor adds its own flag to its parent ones (a DropDownList is also an Image)
+     Much cheaper than dynamic_cast, use isObjectOfType and objectCast instead of isKindOfClass for FenneX objects
+     */
+    enum TypeFlag : unsigned short
+    {
+        TypeImage = 1 << 0,
+        TypeAnimation = 1 << 1, //Image currently using a sprite sheet, updated when it changes
+        TypeLabelTTF = 1 << 2,
+        TypePanel = 1 << 3,
+        TypeCustomObject = 1 << 4,
+        TypeInputLabel = 1 << 5,
+        TypeDropDownList = 1 << 6,
+    };
+    bool isOfType(unsigned short flags) const { return (typeFlags & flags) == flags; }
+    unsigned short getTypeFlags() const { return typeFlags; }
+    
+    virtual const std::string getName(void) const { return name; }
+    //Also keeps GraphicLayer name index up to date
+    virtual void setName(const std::string& newName);
     
     //property-like methods that will actually call getNode
     virtual const Vec2& getPosition();
@@ -57,12 +92,26 @@ public:
     GLubyte getOpacity();
     void setOpacityRecursive(GLubyte opacity);
     
+    /* Event infos are stored in a map shared between objects (see shareEventInfos) and copied on write.
+     Sender is not stored: it is added by getEventInfos and getEventInfo unless it was set explicitly
+     */
     ValueMap getEventInfos() const;//Warning : the returned ValueMap is copied, changes will not affect RawObject
-    Value getEventInfo(std::string key) const;
+    //Without Sender, nothing is copied. The reference is invalidated by any change to the event infos
+    const ValueMap& getEventInfosRef() const;
+    //Returns Value::Null when the key is missing
+    const Value& getEventInfo(const std::string& key) const;
     //Will not copy Sender automatically. Do it manually if required
-    void addEventInfos(ValueMap infos);
-    void setEventInfo(std::string key, Value obj);
-    void removeEventInfo(std::string key);
+    void addEventInfos(const ValueMap& infos);
+    //Same as addEventInfos(other->getEventInfos()), but shares other storage instead of copying it when this object has no event infos yet
+    void shareEventInfos(const RawObject* other);
+    void setEventInfo(const std::string& key, const Value& obj);
+    void removeEventInfo(const std::string& key);
+    /* Payload dispatched by GraphicLayer::touchObject: event infos with Sender and TouchPositionX/Y.
+     The cached payload is reused when the event infos didn't change, so touching an object doesn't allocate.
+     A new one is built while the previous one is still held (a touch during the dispatch). Keep the returned pointer for the whole dispatch
+     It is read-only: listeners must copy it to modify it. A payload with added or removed keys is rebuilt, and any change is asserted in debug
+     */
+    std::shared_ptr<const Value> getTouchEventInfos(const Vec2& position);
     //TODO : add opacity, isMoving
     
     RawObject();
@@ -76,6 +125,9 @@ public:
     virtual bool collision(Vec2 point);
     virtual bool collision(cocos2d::Rect rect);
     virtual bool containsRect(cocos2d::Rect rect);
+    //Return true if collision(Vec2) can be true outside of the content size, so that GraphicLayer hit-tests the object at any position
+    //Subclasses whose collision override reaches beyond it must return true. Call GraphicLayer::objectMoved when the result changes
+    virtual bool hasCollisionBeyondSize() { return false; }
     
     virtual void update(float deltatime) {};
     
@@ -89,10 +141,86 @@ public:
     }
     
 protected:
-    ValueMap eventInfos;
+    std::string name;
+    //Copy-on-write: null until the first change, never modified in place while shared. Only use editEventInfos to change it
+    std::shared_ptr<ValueMap> eventInfos;
+    ValueMap& editEventInfos();
+    unsigned int eventInfosVersion;
+    Value sender;
+    std::shared_ptr<Value> touchEventInfos;
+    unsigned int touchEventInfosVersion;
+    size_t touchEventInfosSize; //To detect a payload modified by a listener
+    unsigned short typeFlags;
+    
+    //Node properties as last seen by GraphicLayer, to detect changes done directly on the Node
+    struct LocalState
+    {
+        //Node and Node::getTransformVersion when the properties were last compared
+        Node* node;
+        unsigned int version;
+        Vec2 position;
+        Vec2 scale;
+        Vec2 anchorPoint;
+        cocos2d::Size size;
+        bool visible;
+    };
+    LocalState localState;
+    
+    //Accumulated transform and visibility of the parent Panels, excluding the base layer, cached by GraphicLayer
+    //It doesn't depend on this object own properties, so it is only invalidated when an ancestor changes or when the object changes panel
+    //Descendants of an object with an invalid state are always invalid too
+    struct ParentsState
+    {
+        bool valid;
+        Vec2 scale; //Product of parents scaleX/scaleY
+        float maxScale; //Product of parents getScale()
+        Vec2 positionOffset; //Used by getRealPosition: position * scale + positionOffset
+        Vec2 anchoredOffset; //Same, taking parents anchor points into account
+        bool visible;
+        Panel* cropParent; //Closest parent which is a crop node
+    };
+    ParentsState parentsState;
+
+    //Position of this object in GraphicLayer storedObjects: (zOrder, insertion sequence) of each parent Panel from the base layer, then of this object
+    //Maintained by GraphicLayer. Children are ordered inside their panel, and before it
+    std::vector<std::pair<int, long>> orderKey;
 };
 
 bool operator<(const RawObject& obj1, const RawObject& obj2);
+
+//Flag of each FenneX object class, used by isObjectOfType and objectCast
+template<typename T> struct RawObjectTypeFlag;
+class Image;
+class LabelTTF;
+class CustomObject;
+class InputLabel;
+class DropDownList;
+template<> struct RawObjectTypeFlag<Image> { static const unsigned short value = RawObject::TypeImage; };
+template<> struct RawObjectTypeFlag<LabelTTF> { static const unsigned short value = RawObject::TypeLabelTTF; };
+template<> struct RawObjectTypeFlag<Panel> { static const unsigned short value = RawObject::TypePanel; };
+template<> struct RawObjectTypeFlag<CustomObject> { static const unsigned short value = RawObject::TypeCustomObject; };
+template<> struct RawObjectTypeFlag<InputLabel> { static const unsigned short value = RawObject::TypeInputLabel; };
+template<> struct RawObjectTypeFlag<DropDownList> { static const unsigned short value = RawObject::TypeDropDownList; };
+
+template<typename T> inline bool isObjectOfType(const RawObject* obj)
+{
+    return obj != nullptr && obj->isOfType(RawObjectTypeFlag<T>::value);
+}
+
+//Checked cast using the type flags: nullptr if obj is not a T. Debug builds also check the result against dynamic_cast
+template<typename T> inline T* objectCast(RawObject* obj)
+{
+    T* result = isObjectOfType<T>(obj) ? static_cast<T*>(obj) : nullptr;
+#if COCOS2D_DEBUG > 1
+    CCAssert(result == dynamic_cast<T*>(obj), "objectCast: type flags don't match the object class");
+#endif
+    return result;
+}
+
+/* Compare isKindOfClass and the type flags for the type checks done by GraphicLayer, LazyLoader and Scene on count objects
+ The objects are never added to GraphicLayer, so the benchmark can run at any time without side effects
+ */
+void benchmarkObjectTypes(int count = 5000, int iterations = 20);
 NS_FENNEX_END
 
 #endif /* defined(__FenneX__RawObject__) */
@@ -0,0 +1,249 @@
+/****************************************************************************
+Copyright (c) 2013-2014 Auticiel SAS
+
+http://www.fennex.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************///
+
+#include "SpatialGrid.h"
+
+NS_FENNEX_BEGIN
+
+static inline void removeFromBucket(std::vector<RawObject*>& bucket, RawObject* obj)
+{
+    auto it = std::find(bucket.begin(), bucket.end(), obj);
+    if(it != bucket.end())
+    {
+        //Order doesn't matter in a bucket, swap with the last one to avoid moving everything
+        *it = bucket.back();
+        bucket.pop_back();
+    }
+}
+
+SpatialGrid::SpatialGrid(float cellSize, int maxCellsPerObject) :
+maxCellsPerObject(maxCellsPerObject)
+{
+    for(int level = 0; level < LevelsCount; level++)
+    {
+        cellSizes[level] = cellSize;
+        cellSize *= LevelsFactor;
+    }
+}
+
+uint64_t SpatialGrid::cellKey(int x, int y)
+{
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+int SpatialGrid::cellCoordinate(float value, int level) const
+{
+    return (int)floorf(value / cellSizes[level]);
+}
+
+void SpatialGrid::insert(RawObject* obj, const cocos2d::Rect& box)
+{
+    Entry entry;
+    entry.unbounded = true;
+    for(entry.level = 0; entry.level < LevelsCount && entry.unbounded; entry.level++)
+    {
+        entry.minX = cellCoordinate(box.getMinX(), entry.level);
+        entry.minY = cellCoordinate(box.getMinY(), entry.level);
+        entry.maxX = cellCoordinate(box.getMaxX(), entry.level);
+        entry.maxY = cellCoordinate(box.getMaxY(), entry.level);
+        entry.unbounded = (long)(entry.maxX - entry.minX + 1) * (entry.maxY - entry.minY + 1) > maxCellsPerObject;
+    }
+    //The loop goes one level past the one found
+    entry.level--;
+    
+    auto it = entries.find(obj);
+    if(it != entries.end())
+    {
+        const Entry& previous = it->second;
+        if(previous.unbounded == entry.unbounded
+           && (entry.unbounded || (previous.level == entry.level && previous.minX == entry.minX && previous.minY == entry.minY && previous.maxX == entry.maxX && previous.maxY == entry.maxY)))
+        {
+            //Still in the same cells, nothing to do
+            return;
+        }
+        this->remove(obj);
+    }
+    entries[obj] = entry;
+    if(entry.unbounded)
+    {
+#if VERBOSE_WARNING
+        log("Warning : object too large for the spatial grid, it will be hit-tested at every position");
+#endif
+        unboundedObjects.push_back(obj);
+    }
+    else
+    {
+        auto& levelCells = cells[entry.level];
+        for(int x = entry.minX; x <= entry.maxX; x++)
+        {
+            for(int y = entry.minY; y <= entry.maxY; y++)
+            {
+                levelCells[cellKey(x, y)].push_back(obj);
+            }
+        }
+    }
+}
+
+void SpatialGrid::insertUnbounded(RawObject* obj)
+{
+    auto it = entries.find(obj);
+    if(it != entries.end())
+    {
+        if(it->second.unbounded)
+        {
+            return;
+        }
+        this->remove(obj);
+    }
+    Entry entry;
+    entry.minX = entry.minY = entry.maxX = entry.maxY = 0;
+    entry.level = 0;
+    entry.unbounded = true;
+    entries[obj] = entry;
+    unboundedObjects.push_back(obj);
+}
+
+void SpatialGrid::remove(RawObject* obj)
+{
+    auto it = entries.find(obj);
+    if(it == entries.end())
+    {
+        return;
+    }
+    const Entry& entry = it->second;
+    if(entry.unbounded)
+    {
+        removeFromBucket(unboundedObjects, obj);
+    }
+    else
+    {
+        auto& levelCells = cells[entry.level];
+        for(int x = entry.minX; x <= entry.maxX; x++)
+        {
+            for(int y = entry.minY; y <= entry.maxY; y++)
+            {
+                auto cell = levelCells.find(cellKey(x, y));
+                if(cell != levelCells.end())
+                {
+                    removeFromBucket(cell->second, obj);
+                    if(cell->second.empty())
+                    {
+                        levelCells.erase(cell);
+                    }
+                }
+            }
+        }
+    }
+    entries.erase(it);
+}
+
+void SpatialGrid::clear()
+{
+    for(int level = 0; level < LevelsCount; level++)
+    {
+        cells[level].clear();
+    }
+    entries.clear();
+    unboundedObjects.clear();
+}
+
+void SpatialGrid::query(const Vec2& position, std::vector<RawObject*>& result) const
+{
+    result.insert(result.end(), unboundedObjects.begin(), unboundedObjects.end());
+    for(int level = 0; level < LevelsCount; level++)
+    {
+        auto cell = cells[level].find(cellKey(cellCoordinate(position.x, level), cellCoordinate(position.y, level)));
+        if(cell != cells[level].end())
+        {
+            result.insert(result.end(), cell->second.begin(), cell->second.end());
+        }
+    }
+}
+
+void SpatialGrid::query(const cocos2d::Rect& area, std::vector<RawObject*>& result) const
+{
+    result.insert(result.end(), unboundedObjects.begin(), unboundedObjects.end());
+    int minX[LevelsCount], minY[LevelsCount], maxX[LevelsCount], maxY[LevelsCount];
+    for(int level = 0; level < LevelsCount; level++)
+    {
+        minX[level] = cellCoordinate(area.getMinX(), level);
+        minY[level] = cellCoordinate(area.getMinY(), level);
+        maxX[level] = cellCoordinate(area.getMaxX(), level);
+        maxY[level] = cellCoordinate(area.getMaxY(), level);
+    }
+    if((long)(maxX[0] - minX[0] + 1) * (maxY[0] - minY[0] + 1) > (long)entries.size())
+    {
+        //Large area compared to the number of objects: checking each object is cheaper than visiting each cell
+        for(const auto& it : entries)
+        {
+            const Entry& entry = it.second;
+            int level = entry.level;
+            if(!entry.unbounded && entry.minX <= maxX[level] && entry.maxX >= minX[level] && entry.minY <= maxY[level] && entry.maxY >= minY[level])
+            {
+                result.push_back(it.first);
+            }
+        }
+        return;
+    }
+    for(int level = 0; level < LevelsCount; level++)
+    {
+        const auto& levelCells = cells[level];
+        if(levelCells.empty())
+        {
+            continue;
+        }
+        for(int x = minX[level]; x <= maxX[level]; x++)
+        {
+            for(int y = minY[level]; y <= maxY[level]; y++)
+            {
+                auto cell = levelCells.find(cellKey(x, y));
+                if(cell == levelCells.end())
+                {
+                    continue;
+                }
+                for(RawObject* obj : cell->second)
+                {
+                    //An object covering several cells is only reported from its first cell inside area
+                    const Entry& entry = entries.at(obj);
+                    if(x == MAX(entry.minX, minX[level]) && y == MAX(entry.minY, minY[level]))
+                    {
+                        result.push_back(obj);
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool SpatialGrid::contains(RawObject* obj) const
+{
+    return entries.find(obj) != entries.end();
+}
+
+long SpatialGrid::size() const
+{
+    return entries.size();
+}
+
+NS_FENNEX_END
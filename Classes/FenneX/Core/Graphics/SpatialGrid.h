@@ -0,0 +1,84 @@
+/****************************************************************************
+Copyright (c) 2013-2014 Auticiel SAS
+
+http://www.fennex.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************///
+
+#ifndef __FenneX__SpatialGrid__
+#define __FenneX__SpatialGrid__
+
+#include "cocos2d.h"
+USING_NS_CC;
+#include "FenneXMacros.h"
+
+NS_FENNEX_BEGIN
+
+class RawObject;
+
+//Grid of world-space bounding boxes, used by GraphicLayer to only hit-test objects close to a position
+//Objects covering too many cells are stored in a coarser level, whose cells are LevelsFactor times larger
+//Only objects which don't have bounds (for example Panels with a size of 0) or are too large for the coarsest level are stored apart and always returned
+class SpatialGrid
+{
+public:
+    SpatialGrid(float cellSize = 128, int maxCellsPerObject = 64);
+    
+    //Insert the object, or move it if it is already in the grid
+    void insert(RawObject* obj, const cocos2d::Rect& box);
+    void insertUnbounded(RawObject* obj);
+    void remove(RawObject* obj);
+    void clear();
+    
+    //Append objects whose box may contain position, in no particular order. Caller must still do the exact collision test
+    void query(const Vec2& position, std::vector<RawObject*>& result) const;
+    //Same for objects whose box may intersect area. Each object is appended once
+    void query(const cocos2d::Rect& area, std::vector<RawObject*>& result) const;
+    
+    bool contains(RawObject* obj) const;
+    long size() const;
+    
+private:
+    static const int LevelsCount = 3;
+    static const int LevelsFactor = 8;
+    
+    struct Entry
+    {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+        int level;
+        bool unbounded;
+    };
+    
+    static uint64_t cellKey(int x, int y);
+    int cellCoordinate(float value, int level) const;
+    
+    float cellSizes[LevelsCount];
+    int maxCellsPerObject;
+    std::unordered_map<uint64_t, std::vector<RawObject*>> cells[LevelsCount];
+    std::unordered_map<RawObject*, Entry> entries;
+    std::vector<RawObject*> unboundedObjects;
+};
+
+NS_FENNEX_END
+
+#endif /* defined(__FenneX__SpatialGrid__) */
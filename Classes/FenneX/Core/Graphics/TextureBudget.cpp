@@ -0,0 +1,337 @@
+/****************************************************************************
+Copyright (c) 2013-2014 Auticiel SAS
+
+http://www.fennex.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************///
+
+#include "TextureBudget.h"
+#include "GraphicLayer.h"
+#include "Image.h"
+#include "Shorteners.h"
+#include "LabelTTF.h"
+#include "FenneXCCBLoader.h"
+
+#define CHECK_INTERVAL 0.5
+#define PLACEHOLDER_KEY "/FenneX_transparent_placeholder"
+
+NS_FENNEX_BEGIN
+// singleton stuff
+static TextureBudget *s_SharedBudget = nullptr;
+
+TextureBudget* TextureBudget::sharedBudget(void)
+{
+    if (!s_SharedBudget)
+    {
+        s_SharedBudget = new TextureBudget();
+        s_SharedBudget->init();
+    }
+    
+    return s_SharedBudget;
+}
+
+TextureBudget::~TextureBudget()
+{
+    Console* console = Director::getInstance()->getConsole();
+    if(console != nullptr)
+    {
+        console->delSubCommand("texture", "budget");
+    }
+    s_SharedBudget = nullptr;
+}
+
+void TextureBudget::init()
+{
+    budget = 0;
+    unloadOffscreen = false;
+    timeSinceCheck = 0;
+    checksCount = 0;
+    evictions = 0;
+    unloads = 0;
+    reloads = 0;
+    Console* console = Director::getInstance()->getConsole();
+    if(console != nullptr)
+    {
+        console->addSubCommand("texture", {"budget", "Print FenneX texture budget stats: tracked textures memory, evictions and reloads.", [](int fd, const std::string& args) {
+            //Like the other texture commands, run on the cocos thread
+            Director::getInstance()->getScheduler()->performFunctionInCocosThread([fd]() {
+                Console::Utility::mydprintf(fd, "%s", TextureBudget::sharedBudget()->getStatsDescription().c_str());
+                Console::Utility::sendPrompt(fd);
+            });
+        }});
+    }
+}
+
+void TextureBudget::touch(Texture2D* texture, const std::string& key)
+{
+    if(texture == nullptr)
+    {
+        return;
+    }
+    auto it = entries.find(texture);
+    if(it != entries.end() && this->getValidEntry(texture) == nullptr)
+    {
+        it = entries.end();
+    }
+    if(it == entries.end())
+    {
+        std::string textureKey = key.empty() ? Director::getInstance()->getTextureCache()->getKeyForTexture(texture) : key;
+        //Textures which are not in TextureCache can't be evicted
+        if(textureKey.empty() || textureKey == PLACEHOLDER_KEY)
+        {
+            return;
+        }
+        Entry& entry = entries[texture];
+        entry.key = textureKey;
+        entry.bytes = (size_t)texture->getPixelsWide() * texture->getPixelsHigh() * texture->getBitsPerPixelForFormat() / 8;
+        entry.lastUse = checksCount;
+        entry.lruPosition = lru.insert(lru.end(), texture);
+        auto evicted = evictedKeys.find(textureKey);
+        if(evicted != evictedKeys.end())
+        {
+            reloads++;
+            evictedKeys.erase(evicted);
+        }
+    }
+    else
+    {
+        it->second.lastUse = checksCount;
+        lru.splice(lru.end(), lru, it->second.lruPosition);
+    }
+}
+
+TextureBudget::Entry* TextureBudget::getValidEntry(Texture2D* texture)
+{
+    auto it = entries.find(texture);
+    if(it == entries.end())
+    {
+        return nullptr;
+    }
+    //The texture may have been removed by someone else: its pointer is only compared, never dereferenced
+    if(Director::getInstance()->getTextureCache()->getTextureForKey(it->second.key) != texture)
+    {
+        this->untrack(texture);
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void TextureBudget::untrack(Texture2D* texture)
+{
+    auto it = entries.find(texture);
+    if(it != entries.end())
+    {
+        lru.erase(it->second.lruPosition);
+        entries.erase(it);
+    }
+}
+
+void TextureBudget::update(float deltaTime)
+{
+    timeSinceCheck += deltaTime;
+    if(timeSinceCheck < CHECK_INTERVAL)
+    {
+        return;
+    }
+    timeSinceCheck = 0;
+    checksCount++;
+    this->checkScreen();
+    this->enforceBudget();
+}
+
+void TextureBudget::checkScreen()
+{
+    //Half a screen of margin, so that released textures are reloaded before being visible
+    Size bounds = Director::getInstance()->getOpenGLView()->getFrameSize();
+    float margin = MAX(bounds.width, bounds.height) / 2;
+    candidates.clear();
+    GraphicLayer::sharedLayer()->getObjectsInArea(Rect(-margin, -margin, bounds.width + margin * 2, bounds.height + margin * 2), candidates);
+    for(RawObject* obj : candidates)
+    {
+        if(isObjectOfType<FenneX::Image>(obj))
+        {
+            FenneX::Image* image = (FenneX::Image*)obj;
+            if(image->isTextureUnloaded())
+            {
+                image->reloadTexture();
+            }
+            else
+            {
+                this->touch(image->getTexture());
+            }
+        }
+    }
+}
+
+void TextureBudget::purgeCaches()
+{
+    Image::purgeAnimationCache();
+    LabelTTF::purgeFitCache();
+    CCBLoaderPurgeTemplates();
+    Director::getInstance()->getTextureCache()->removeUnusedTextures();
+    //Entries of removed textures are dropped by getValidEntry
+}
+
+void TextureBudget::enforceBudget()
+{
+    if(budget == 0)
+    {
+        return;
+    }
+    //Copy, since invalid entries are removed during the iteration
+    std::vector<Texture2D*> textures(lru.begin(), lru.end());
+    size_t total = 0;
+    for(Texture2D* texture : textures)
+    {
+        Entry* entry = this->getValidEntry(texture);
+        if(entry != nullptr)
+        {
+            total += entry->bytes;
+        }
+    }
+    TextureCache* cache = Director::getInstance()->getTextureCache();
+    for(Texture2D* texture : textures)
+    {
+        if(total <= budget)
+        {
+            break;
+        }
+        auto it = entries.find(texture);
+        //Only referenced by TextureCache
+        if(it != entries.end() && texture->getReferenceCount() == 1)
+        {
+            total -= it->second.bytes;
+            evictedKeys.insert(it->second.key);
+            this->untrack(texture);
+            cache->removeTexture(texture);
+            evictions++;
+        }
+    }
+    if(total > budget && unloadOffscreen)
+    {
+        this->unloadImages(total);
+    }
+#if VERBOSE_PERFORMANCE_TIME
+    if(total > budget)
+    {
+        log("Textures still over budget after eviction: %.1f MB used for %.1f MB", total / 1048576.f, budget / 1048576.f);
+    }
+#endif
+}
+
+void TextureBudget::unloadImages(size_t& total)
+{
+    std::unordered_map<Texture2D*, std::vector<FenneX::Image*>> users;
+    Vector<RawObject*> objects = GraphicLayer::sharedLayer()->all();
+    for(RawObject* obj : objects)
+    {
+        if(isObjectOfType<FenneX::Image>(obj) && ((FenneX::Image*)obj)->canUnloadTexture())
+        {
+            users[((FenneX::Image*)obj)->getTexture()].push_back((FenneX::Image*)obj);
+        }
+    }
+    TextureCache* cache = Director::getInstance()->getTextureCache();
+    std::vector<Texture2D*> textures(lru.begin(), lru.end());
+    for(Texture2D* texture : textures)
+    {
+        if(total <= budget)
+        {
+            break;
+        }
+        auto it = entries.find(texture);
+        auto usersIt = users.find(texture);
+        //Used close to the screen during the last check
+        if(it == entries.end() || it->second.lastUse == checksCount || usersIt == users.end())
+        {
+            continue;
+        }
+        //Releasing it would not free anything if something else references it (sprite frames, other nodes ...)
+        if(texture->getReferenceCount() != 1 + usersIt->second.size())
+        {
+            continue;
+        }
+        for(FenneX::Image* image : usersIt->second)
+        {
+            image->unloadTexture(this->getPlaceholder(), it->second.key);
+            unloads++;
+        }
+        total -= it->second.bytes;
+        evictedKeys.insert(it->second.key);
+        this->untrack(texture);
+        cache->removeTexture(texture);
+        evictions++;
+    }
+}
+
+Texture2D* TextureBudget::getPlaceholder()
+{
+    TextureCache* cache = Director::getInstance()->getTextureCache();
+    Texture2D* placeholder = cache->getTextureForKey(PLACEHOLDER_KEY);
+    if(placeholder == nullptr)
+    {
+        static const unsigned char transparentPixels[16] = {0};
+        cocos2d::Image* image = new cocos2d::Image();
+        image->initWithRawData(transparentPixels, sizeof(transparentPixels), 2, 2, 8);
+        placeholder = cache->addImage(image, PLACEHOLDER_KEY);
+        image->release();
+    }
+    return placeholder;
+}
+
+TextureStats TextureBudget::getStats()
+{
+    TextureStats stats;
+    stats.count = 0;
+    stats.bytes = 0;
+    stats.evictions = evictions;
+    stats.unloads = unloads;
+    stats.reloads = reloads;
+    std::vector<Texture2D*> textures(lru.begin(), lru.end());
+    for(Texture2D* texture : textures)
+    {
+        Entry* entry = this->getValidEntry(texture);
+        if(entry != nullptr)
+        {
+            stats.count++;
+            stats.bytes += entry->bytes;
+            stats.bytesPerFormat[texture->getStringForFormat()] += entry->bytes;
+        }
+    }
+    return stats;
+}
+
+std::string TextureBudget::getStatsDescription()
+{
+    TextureStats stats = this->getStats();
+    std::string description = StringUtils::format("%d tracked textures, %.2f MB", stats.count, stats.bytes / 1048576.f);
+    if(budget != 0)
+    {
+        description += StringUtils::format(" (budget %.2f MB)", budget / 1048576.f);
+    }
+    description += "\n";
+    for(const auto& format : stats.bytesPerFormat)
+    {
+        description += StringUtils::format("    %s: %.2f MB\n", format.first.c_str(), format.second / 1048576.f);
+    }
+    description += StringUtils::format("%ld evictions, %ld images unloaded, %ld reloads\n", stats.evictions, stats.unloads, stats.reloads);
+    return description;
+}
+
+NS_FENNEX_END
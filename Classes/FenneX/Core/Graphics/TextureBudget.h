@@ -0,0 +1,123 @@
+/****************************************************************************
+Copyright (c) 2013-2014 Auticiel SAS
+
+http://www.fennex.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************///
+
+#ifndef __FenneX__TextureBudget__
+#define __FenneX__TextureBudget__
+
+#include "cocos2d.h"
+#include "FenneXMacros.h"
+#include "Pausable.h"
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
+USING_NS_CC;
+
+NS_FENNEX_BEGIN
+class Image;
+class RawObject;
+
+struct TextureStats
+{
+    int count;
+    size_t bytes;
+    //By Texture2D::getStringForFormat
+    std::map<std::string, size_t> bytesPerFormat;
+    long evictions; //Textures removed from TextureCache to get under budget
+    long unloads; //Images which released their texture while away from the screen
+    long reloads; //Evicted textures which were loaded again
+};
+
+/* Keep the memory used by textures under a byte budget.
+ Textures are tracked when they are loaded by FenneX Images and TextureLoader, and when an Image using them is close to the screen.
+ They are ordered by last use: when over budget, the least recently used textures which are not referenced anymore are removed from TextureCache.
+ Optionally, if that is not enough, Images far from the screen release their texture, and reload it asynchronously when they come back.
+ Stats are also available in the cocos2d Console with "texture budget"
+ */
+class TextureBudget : public Ref, public Pausable
+{
+public:
+    static TextureBudget* sharedBudget(void);
+    ~TextureBudget();
+    
+    //Budget in bytes, 0 for no budget (textures are still tracked for stats). Default 0
+    void setBudget(size_t bytes) { budget = bytes; }
+    size_t getBudget() { return budget; }
+    //Allow Images far from the screen to release their texture when evicting unused textures is not enough. Default false
+    void setUnloadOffscreen(bool unload) { unloadOffscreen = unload; }
+    
+    //Mark the texture as used now. key is its TextureCache key, found with a linear search if empty and it is not tracked yet
+    void touch(Texture2D* texture, const std::string& key = "");
+    //Evict until under budget, without waiting for the next check
+    void enforceBudget();
+    /* Purge the FenneX caches (Image sprite sheet frames and animations, which keep their textures alive, LabelTTF fits and CCB templates),
+     then remove unused textures from TextureCache. Called on memory warnings, from the cocos thread
+     */
+    void purgeCaches();
+    
+    TextureStats getStats();
+    std::string getStatsDescription();
+    
+    //Track textures used close to the screen, reload released textures and enforce the budget, twice per second
+    virtual void update(float deltaTime);
+protected:
+    void init();
+    
+    struct Entry
+    {
+        std::string key;
+        size_t bytes;
+        long lastUse; //Number of the last check during which it was used
+        std::list<Texture2D*>::iterator lruPosition;
+    };
+    
+    //Return the entry if the texture is still in TextureCache, or nullptr after removing an outdated entry
+    Entry* getValidEntry(Texture2D* texture);
+    void untrack(Texture2D* texture);
+    //Touch textures of Images close to the screen and reload the ones which were released
+    void checkScreen();
+    //Release the textures of Images far from the screen, least recently used first, until under budget
+    void unloadImages(size_t& total);
+    Texture2D* getPlaceholder();
+    
+    size_t budget;
+    bool unloadOffscreen;
+    float timeSinceCheck;
+    long checksCount;
+    
+    long evictions;
+    long unloads;
+    long reloads;
+    
+    std::unordered_map<Texture2D*, Entry> entries;
+    //Least recently used first
+    std::list<Texture2D*> lru;
+    //Keys of evicted textures, to count reloads
+    std::unordered_set<std::string> evictedKeys;
+    std::vector<RawObject*> candidates;
+};
+
+NS_FENNEX_END
+
+#endif /* defined(__FenneX__TextureBudget__) */
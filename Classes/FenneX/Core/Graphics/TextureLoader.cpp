@@ -0,0 +1,301 @@
+/****************************************************************************
+Copyright (c) 2013-2014 Auticiel SAS
+
+http://www.fennex.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************///
+
+#include "TextureLoader.h"
+#include "Shorteners.h"
+#include "TextureBudget.h"
+#include "Profiler.h"
+
+NS_FENNEX_BEGIN
+// singleton stuff
+static TextureLoader *s_SharedLoader = nullptr;
+
+TextureLoader* TextureLoader::sharedLoader(void)
+{
+    if (!s_SharedLoader)
+    {
+        s_SharedLoader = new TextureLoader();
+        s_SharedLoader->init();
+    }
+    
+    return s_SharedLoader;
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(requestsMutex);
+        stopping = true;
+    }
+    requestsCondition.notify_all();
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    for(auto& it : requests)
+    {
+        IFEXIST(it.second.image)->release();
+    }
+    s_SharedLoader = nullptr;
+}
+
+void TextureLoader::init()
+{
+    workersCount = 2;
+    uploadsPerFrame = 2;
+    uploadTimePerFrame = 8;
+    stopping = false;
+    lastHandle = 0;
+    lastOrder = 0;
+}
+
+long TextureLoader::loadTexture(const std::string& filename, const Callback& callback, float priority)
+{
+    std::string path = FileUtils::getInstance()->fullPathForFilename(filename);
+    Texture2D* texture = path.empty() ? nullptr : Director::getInstance()->getTextureCache()->getTextureForKey(path);
+    if(path.empty() || texture != nullptr)
+    {
+#if VERBOSE_WARNING
+        if(path.empty())
+        {
+            log("Warning : Problem with asset : %s, texture not loaded", filename.c_str());
+        }
+#endif
+        callback(texture);
+        return 0;
+    }
+    this->startWorkers();
+    long handle;
+    {
+        std::lock_guard<std::mutex> lock(requestsMutex);
+        handle = ++lastHandle;
+        handles[handle] = path;
+        auto it = requests.find(path);
+        if(it == requests.end())
+        {
+            Request& request = requests[path];
+            request.priority = priority;
+            request.order = ++lastOrder;
+            request.decoding = false;
+            request.image = nullptr;
+            request.callbacks.push_back(std::make_pair(handle, callback));
+            decodeQueue.insert({priority, request.order, path});
+        }
+        else
+        {
+            Request& request = it->second;
+            request.callbacks.push_back(std::make_pair(handle, callback));
+            if(!request.decoding && priority > request.priority)
+            {
+                decodeQueue.erase({request.priority, request.order, path});
+                request.priority = priority;
+                decodeQueue.insert({priority, request.order, path});
+            }
+        }
+    }
+    requestsCondition.notify_one();
+    return handle;
+}
+
+void TextureLoader::cancel(long handle)
+{
+    std::lock_guard<std::mutex> lock(requestsMutex);
+    auto handleIt = handles.find(handle);
+    if(handleIt == handles.end())
+    {
+        return;
+    }
+    auto it = requests.find(handleIt->second);
+    handles.erase(handleIt);
+    if(it == requests.end())
+    {
+        return;
+    }
+    Request& request = it->second;
+    request.callbacks.erase(std::remove_if(request.callbacks.begin(),
+                                           request.callbacks.end(),
+                                           [handle](const std::pair<long, Callback>& callback) { return callback.first == handle; }),
+                            request.callbacks.end());
+    //Once taken by a worker, the request is dropped after the decode, without being uploaded
+    if(request.callbacks.empty() && !request.decoding)
+    {
+        decodeQueue.erase({request.priority, request.order, it->first});
+        requests.erase(it);
+    }
+}
+
+void TextureLoader::cancelAll()
+{
+    std::lock_guard<std::mutex> lock(requestsMutex);
+    handles.clear();
+    decodeQueue.clear();
+    for(auto it = requests.begin(); it != requests.end();)
+    {
+        it->second.callbacks.clear();
+        if(!it->second.decoding)
+        {
+            it = requests.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void TextureLoader::setWorkersCount(int count)
+{
+    count = MAX(count, 1);
+    {
+        std::lock_guard<std::mutex> lock(requestsMutex);
+        workersCount = count;
+    }
+    requestsCondition.notify_all();
+    while((int)workers.size() > count)
+    {
+        workers.back().join();
+        workers.pop_back();
+    }
+}
+
+int TextureLoader::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(requestsMutex);
+    return (int)requests.size();
+}
+
+void TextureLoader::startWorkers()
+{
+    //workersCount is only written on this thread, no need to lock to read it
+    while((int)workers.size() < workersCount)
+    {
+        workers.push_back(std::thread(&TextureLoader::runWorker, this, (int)workers.size()));
+    }
+}
+
+void TextureLoader::runWorker(int index)
+{
+    Profiler::setThreadName("TextureLoader");
+    std::unique_lock<std::mutex> lock(requestsMutex);
+    while(true)
+    {
+        requestsCondition.wait(lock, [this, index] { return stopping || index >= workersCount || !decodeQueue.empty(); });
+        if(stopping || index >= workersCount)
+        {
+            return;
+        }
+        std::string path = decodeQueue.begin()->path;
+        decodeQueue.erase(decodeQueue.begin());
+        requests.at(path).decoding = true;
+        lock.unlock();
+        
+        cocos2d::Image* image = new cocos2d::Image();
+        {
+            FENNEX_PROFILE_SCOPE("TextureLoader decode");
+            //Same as Image::initWithImageFileThreadSafe, which is only accessible to TextureCache
+            Data data = FileUtils::getInstance()->getDataFromFile(path);
+            if(data.isNull() || !image->initWithImageData(data.getBytes(), data.getSize()))
+            {
+                image->release();
+                image = nullptr;
+            }
+        }
+        
+        lock.lock();
+        //A request can't be removed while it is decoding, even if all its callbacks were cancelled
+        requests.at(path).image = image;
+        decoded.push_back(path);
+        //The upload happens during a frame: wake up the Director if it renders on demand (thread safe)
+        Director::getInstance()->requestRedraw();
+    }
+}
+
+void TextureLoader::update(float deltaTime)
+{
+    timeval startTime;
+    gettimeofday(&startTime, NULL);
+    TextureCache* cache = Director::getInstance()->getTextureCache();
+    int uploads = 0;
+    while(uploadsPerFrame <= 0 || uploads < uploadsPerFrame)
+    {
+        std::string path;
+        Request request;
+        {
+            std::lock_guard<std::mutex> lock(requestsMutex);
+            if(decoded.empty())
+            {
+                break;
+            }
+            path = decoded.front();
+            decoded.pop_front();
+            auto it = requests.find(path);
+            request = std::move(it->second);
+            requests.erase(it);
+            for(const auto& callback : request.callbacks)
+            {
+                handles.erase(callback.first);
+            }
+        }
+        //All callbacks were cancelled during the decode, don't waste an upload
+        if(request.callbacks.empty())
+        {
+            IFEXIST(request.image)->release();
+            continue;
+        }
+        Texture2D* texture = nullptr;
+        if(request.image != nullptr)
+        {
+            FENNEX_PROFILE_SCOPE("TextureLoader upload");
+            texture = cache->addImage(request.image, path);
+            request.image->release();
+            TextureBudget::sharedBudget()->touch(texture, path);
+        }
+#if VERBOSE_WARNING
+        else
+        {
+            log("Warning : Problem with asset : %s, texture not loaded", path.c_str());
+        }
+#endif
+        //Callbacks may request other textures, the lock must not be held
+        for(const auto& callback : request.callbacks)
+        {
+            callback.second(texture);
+        }
+        uploads++;
+        timeval now;
+        gettimeofday(&now, NULL);
+        if(uploadTimePerFrame > 0 && getTimeDifferenceMS(startTime, now) >= uploadTimePerFrame)
+        {
+            break;
+        }
+    }
+    //Remaining uploads are done in the next frames
+    std::lock_guard<std::mutex> lock(requestsMutex);
+    if(!decoded.empty())
+    {
+        Director::getInstance()->requestRedraw();
+    }
+}
+
+NS_FENNEX_END
@@ -0,0 +1,131 @@
+/****************************************************************************
+Copyright (c) 2013-2014 Auticiel SAS
+
+http://www.fennex.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************///
+
+#ifndef __FenneX__TextureLoader__
+#define __FenneX__TextureLoader__
+
+#include "cocos2d.h"
+#include "FenneXMacros.h"
+#include "Pausable.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+USING_NS_CC;
+
+NS_FENNEX_BEGIN
+/* Load textures asynchronously, replacing TextureCache::addImageAsync which decodes everything on a single thread in request order.
+ Images are decoded by a pool of workers, highest priority first. Requests for the same file are coalesced into a single decode.
+ A request can be cancelled: if it was the last one for its file and the decode didn't start yet, the file is not decoded at all.
+ Decoded images are uploaded to the GPU during update (on the GL thread), with a limited number of uploads per frame,
+ then added to the TextureCache, so that TextureCache::addImage returns them directly.
+ It is a FenneX class rather than a TextureCache change since its priorities and cancellations come from Image and LazyLoader:
+ TextureCache::addImageAsync keeps its behavior for the engine and the other callers.
+ */
+class TextureLoader : public Ref, public Pausable
+{
+public:
+    typedef std::function<void(Texture2D*)> Callback;
+    
+    static TextureLoader* sharedLoader(void);
+    ~TextureLoader();
+    
+    /* Request the texture of a file, callback is called on the GL thread with the texture, or nullptr if the file couldn't be loaded
+     priority : higher priority requests are decoded first. Requesting a file already requested raises its priority if needed
+     Return a handle which can be used to cancel the request, or 0 if the texture was already in TextureCache (callback is then called right away)
+     */
+    long loadTexture(const std::string& filename, const Callback& callback, float priority = 0);
+    //The callback of this request won't be called. Does nothing if it was already called
+    void cancel(long handle);
+    void cancelAll();
+    
+    //Number of decode threads, started when needed. Lowering it waits for the extra workers to finish their current decode. Default 2
+    void setWorkersCount(int count);
+    //Maximum number of textures uploaded per frame, 0 for no limit. Default 2
+    void setUploadsPerFrame(int uploads) { uploadsPerFrame = uploads; }
+    //No more upload is started after this time in ms during a frame, 0 for no limit. At least one texture is uploaded per frame. Default 8
+    void setUploadTimePerFrame(float ms) { uploadTimePerFrame = ms; }
+    
+    //Number of files waiting to be decoded, being decoded, or waiting for upload
+    int getPendingCount();
+    
+    //Upload decoded images within the frame budget and call their callbacks
+    virtual void update(float deltaTime);
+protected:
+    void init();
+    
+    struct Request
+    {
+        std::vector<std::pair<long, Callback>> callbacks;
+        float priority;
+        long order; //Requests with the same priority are decoded in request order
+        bool decoding; //Taken by a worker, it can't be removed from the queue anymore
+        cocos2d::Image* image; //Set once decoded, nullptr if the decode failed
+    };
+    
+    //Position in the decode queue: highest priority first, then oldest request first
+    struct QueueKey
+    {
+        float priority;
+        long order;
+        std::string path;
+        bool operator<(const QueueKey& other) const
+        {
+            if(priority != other.priority) return priority > other.priority;
+            return order < other.order;
+        }
+    };
+    
+    void startWorkers();
+    void runWorker(int index);
+    
+    int uploadsPerFrame;
+    float uploadTimePerFrame;
+    
+    //Only used on the GL thread
+    std::vector<std::thread> workers;
+    
+    //Everything below is protected by requestsMutex
+    std::mutex requestsMutex;
+    std::condition_variable requestsCondition;
+    int workersCount;
+    bool stopping;
+    long lastHandle;
+    long lastOrder;
+    //Requests by full path
+    std::unordered_map<std::string, Request> requests;
+    //Full path of the request of each pending handle
+    std::unordered_map<long, std::string> handles;
+    //Requests not taken by a worker yet
+    std::set<QueueKey> decodeQueue;
+    //Full paths of decoded requests, in decode order
+    std::deque<std::string> decoded;
+};
+
+NS_FENNEX_END
+
+#endif /* defined(__FenneX__TextureLoader__) */
@@ -30,6 +30,10 @@ THE SOFTWARE.
 #include "AppMacros.h"
 #include "NativeUtility.h"
 #include "InactivityTimer.h"
+#include "LazyLoader.h"
+#include "TextureLoader.h"
+#include "TextureBudget.h"
+#include "Profiler.h"
 #include "StringUtility.h"
 #include "FileLogger.h"
 
@@ -62,6 +66,14 @@ sceneName(identifier)
     //GraphicLayer is a Ref*, retain it for updateList
     GraphicLayer::sharedLayer()->retain();
     updateList.push_back(GraphicLayer::sharedLayer());
+    //LazyLoader checks use the objects bounds refreshed by GraphicLayer update
+    LazyLoader::sharedLoader()->retain();
+    updateList.push_back(LazyLoader::sharedLoader());
+    //TextureLoader uploads the textures requested by Images and LazyLoader during this frame, if they are already decoded
+    TextureLoader::sharedLoader()->retain();
+    updateList.push_back(TextureLoader::sharedLoader());
+    TextureBudget::sharedBudget()->retain();
+    updateList.push_back(TextureBudget::sharedBudget());
     InactivityTimer::getInstance()->retain();
     updateList.push_back(InactivityTimer::getInstance());
     
@@ -124,6 +136,7 @@ Scene::~Scene()
 
 void Scene::update(float deltaTime)
 {
+    FENNEX_PROFILE_SCOPE("Scene::update");
     frameNumber++;
 #if VERBOSE_PERFORMANCE_TIME
     timeval startTime;
@@ -136,7 +149,7 @@ void Scene::update(float deltaTime)
 #endif
     for(Pausable* obj : updateList)
     {
-        //log("Updating object of type: %s", typeid(*obj).name());
+        FENNEX_PROFILE_SCOPE(typeid(*obj).name());
         obj->update(deltaTime);
     }
 #if VERBOSE_GENERAL_INFO
@@ -288,6 +301,7 @@ bool Scene::onTouchBegan(Touch *touch, Event *pEvent)
     //log("sending to receivers ...");
     for(GenericRecognizer* receiver : touchReceiversList)
     {
+        FENNEX_PROFILE_SCOPE(typeid(*receiver).name());
         if(!receiversToRemove.contains(receiver)) receiver->onTouchBegan(touch, pEvent);
     }
     //TODO : cancel selection if needed
@@ -302,7 +316,7 @@ void Scene::onTouchMoved(Touch *touch, Event *pEvent)
 {
     //log("onTouchMoved started...");
     if(linker->linkedObjectOf(touch) != nullptr
-       && isKindOfClass(linker->linkedObjectOf(touch), const Image))
+       && isObjectOfType<Image>(linker->linkedObjectOf(touch)))
     {
         Image* toggle = (Image*)linker->linkedObjectOf(touch);
         GraphicLayer* layer = GraphicLayer::sharedLayer();
@@ -316,6 +330,7 @@ void Scene::onTouchMoved(Touch *touch, Event *pEvent)
     
     for(GenericRecognizer* receiver : touchReceiversList)
     {
+        FENNEX_PROFILE_SCOPE(typeid(*receiver).name());
         if(!receiversToRemove.contains(receiver)) receiver->onTouchMoved(touch, pEvent);
     }
     //log("onTouchMoved ended");
@@ -326,14 +341,14 @@ void Scene::onTouchEnded(Touch *touch, Event *pEvent)
 {
     //log("onTouchEnded started...");
     if(linker->linkedObjectOf(touch) != nullptr
-       && isKindOfClass(linker->linkedObjectOf(touch), const Image)
+       && isObjectOfType<Image>(linker->linkedObjectOf(touch))
        && GraphicLayer::sharedLayer()->containsObject((RawObject*)linker->linkedObjectOf(touch)))
     {
         Image* toggle = (Image*)linker->linkedObjectOf(touch);
         linker->unlinkTouch(touch);
         std::string file = toggle->getFile();
         std::string extension = file.substr(file.length() - 4);
-        if(stringEndsWith(file, "-on" + extension) && !toggle->getEventInfos()["_OriginalImageFile"].isNull() && linker->touchesLinkedTo(toggle).size() == 0)
+        if(stringEndsWith(file, "-on" + extension) && !toggle->getEventInfo(EventInfoKey::OriginalImageFile).isNull() && linker->touchesLinkedTo(toggle).size() == 0)
         {
             this->switchButton(toggle, false);
         }
@@ -341,6 +356,7 @@ void Scene::onTouchEnded(Touch *touch, Event *pEvent)
     
     for(GenericRecognizer* receiver : touchReceiversList)
     {
+        FENNEX_PROFILE_SCOPE(typeid(*receiver).name());
         if(!receiversToRemove.contains(receiver)) receiver->onTouchEnded(touch, pEvent);
     }
     numberOfTouches--;
@@ -377,9 +393,9 @@ void Scene::switchButton(Image* obj, bool state, Touch* touch)
     {
         std::string file = obj->getFile();
         std::string extension = file.substr(file.length() - 4);
-        if(obj->getEventInfos()["_OriginalImageFile"].isNull())
+        if(obj->getEventInfo(EventInfoKey::OriginalImageFile).isNull())
         {
-            obj->setEventInfo("_OriginalImageFile", Value(obj->getFile()));
+            obj->setEventInfo(EventInfoKey::OriginalImageFile, Value(obj->getFile()));
             file.erase(file.length() - 4, 4);
             obj->replaceTexture(file + "-on" + extension);
         }
@@ -390,15 +406,16 @@ void Scene::switchButton(Image* obj, bool state, Touch* touch)
         }
         else
         {
-            obj->removeEventInfo("_OriginalImageFile");
+            obj->removeEventInfo(EventInfoKey::OriginalImageFile);
         }
     }
     else
     {
-        if(isValueOfType(obj->getEventInfos()["_OriginalImageFile"], STRING))
+        const Value& originalImageFile = obj->getEventInfo(EventInfoKey::OriginalImageFile);
+        if(isValueOfType(originalImageFile, STRING))
         {
-            obj->replaceTexture(obj->getEventInfos()["_OriginalImageFile"].asString());
-            obj->removeEventInfo("_OriginalImageFile");
+            obj->replaceTexture(originalImageFile.asString());
+            obj->removeEventInfo(EventInfoKey::OriginalImageFile);
         }
         linker->unlinkObject(obj);
     }
@@ -539,21 +556,20 @@ int Scene::getFrameNumber()
 
 Image* Scene::getButtonAtPosition(Vec2 position, bool state)
 {
-    return (Image*)GraphicLayer::sharedLayer()->first([position, state](RawObject* obj) -> bool {
-        //All visible objects at position
+    return (Image*)GraphicLayer::sharedLayer()->first(position, [position, state](RawObject* obj) -> bool {
+        //All visible objects at position, first() already checked the collision
         if (obj->getNode() != nullptr &&
-            dynamic_cast<Image*>(obj) != nullptr &&
+            isObjectOfType<Image>(obj) &&
             obj->getEventActivated() &&
             !obj->getEventName().empty() &&
             obj->getEventName()[0] != '\0' &&
             GraphicLayer::sharedLayer()->isWorldVisible(obj) &&
-            GraphicLayer::sharedLayer()->isInClippingNode(obj, position) && //This was added especially for scrolling to avoid item moving out of the parent cropNode boundaries being clickable (and therefore change their color to their selected form "-on" even if we click them out of the scrolling zone defined by the cropNode content size)
-            obj->collision(GraphicLayer::sharedLayer()->getPositionRelativeToObject(position, obj)))
+            GraphicLayer::sharedLayer()->isInClippingNode(obj, position)) //This was added especially for scrolling to avoid item moving out of the parent cropNode boundaries being clickable (and therefore change their color to their selected form "-on" even if we click them out of the scrolling zone defined by the cropNode content size)
         {
             std::string file = ((Image*)obj)->getFile();
             std::string extension = file.substr(file.length() - 4);
             //If state = false, the object imagefile must finish by "-on" and and have an _OriginalImageFile
-            if(state || (stringEndsWith(file, "-on" + extension) && isValueOfType(obj->getEventInfos()["_OriginalImageFile"], STRING)))
+            if(state || (stringEndsWith(file, "-on" + extension) && isValueOfType(obj->getEventInfo(EventInfoKey::OriginalImageFile), STRING)))
             {
                 return true;
             }
@@ -96,7 +96,7 @@ public:
     //Will launch a PlanSceneSwitch event
     static inline void goToScene(SceneName scene)
     { //Do not use shorteners here since it trips the compiler
-        Value toSend = Value(ValueMap({{"Scene", Value(scene)}}));
+        Value toSend = Value(ValueMap({{EventInfoKey::Scene, Value(scene)}}));
         Director::getInstance()->getEventDispatcher()->dispatchCustomEvent("PlanSceneSwitch", &toSend);
     }
     
@@ -29,6 +29,9 @@ THE SOFTWARE.
 #include "FenneXCCBLoader.h"
 #include "InputLabel.h"
 #include "FileLogger.h"
+#include "Profiler.h"
+#include "TextureLoader.h"
+#include "StringUtility.h"
 
 NS_FENNEX_BEGIN
 // singleton stuff
@@ -45,8 +48,17 @@ SceneSwitcher* SceneSwitcher::sharedSwitcher(void)
     return s_SharedSwitcher;
 }
 
+static void stopSharedPreparationWorker()
+{
+    if(s_SharedSwitcher != nullptr)
+    {
+        s_SharedSwitcher->stopPreparationWorker();
+    }
+}
+
 SceneSwitcher::~SceneSwitcher()
 {
+    this->stopPreparationWorker();
     Director::getInstance()->getEventDispatcher()->removeEventListener(planSceneSwitchListener);
     s_SharedSwitcher = nullptr;
 }
@@ -60,6 +72,11 @@ void SceneSwitcher::init()
     isEventFired = false;
     keyboardLock = -1;
     delayReplace = 0;
+    preparationMemoryCap = 32 * 1024 * 1024;
+    preparedScene = None;
+    preparationMemory = 0;
+    preparationDone = false;
+    preparationStopping = false;
     Director::getInstance()->setNotificationNode(Node::create());
     planSceneSwitchListener = Director::getInstance()->getEventDispatcher()->addCustomEventListener("PlanSceneSwitch", std::bind(&SceneSwitcher::planSceneSwitch, this, std::placeholders::_1));
 }
@@ -77,6 +94,11 @@ void SceneSwitcher::initWithScene(SceneName nextSceneType, ValueMap param)
 
 void SceneSwitcher::trySceneSwitch(float deltaTime)
 {
+    FENNEX_PROFILE_SCOPE("SceneSwitcher::trySceneSwitch");
+    if(preparedScene != None)
+    {
+        this->updatePreparation();
+    }
     if(nextScene != None && !isEventFired)
     {
 #if VERBOSE_GENERAL_INFO
@@ -161,7 +183,11 @@ void SceneSwitcher::planSceneSwitch(EventCustom* event)
     {
         //Unbind all async texture load: since the scene will be replaced, the image won't need their new texture
         Director::getInstance()->getTextureCache()->unbindAllImageAsync();
-        nextScene = (SceneName) infos["Scene"].asInt();
+        nextScene = (SceneName) infos[EventInfoKey::Scene].asInt();
+        if(preparedScene != None && preparedScene != nextScene)
+        {
+            this->cancelScenePreparation();
+        }
 #if VERBOSE_GENERAL_INFO
         log("Planning Scene Switch to %s", formatSceneToString(nextScene).c_str());
 #endif
@@ -173,7 +199,7 @@ void SceneSwitcher::planSceneSwitch(EventCustom* event)
     }
     else
     {
-        queuedScene = (SceneName) infos["Scene"].asInt();
+        queuedScene = (SceneName) infos[EventInfoKey::Scene].asInt();
         queuedParam = ValueMap(infos);
 #if VERBOSE_GENERAL_INFO
         log("Queuing scene change as a scene switch is already happening");
@@ -231,7 +257,14 @@ void SceneSwitcher::replaceScene()
             currentScene->stop();
         }
         CCAssert(nextScene != None, "in replaceScene in SceneSwitcher cannot go to scene None");
+        //The cached sheet frames and animations keep their textures alive: drop them, so that the textures only used by the previous scene can be freed once it is released
+        Image::purgeAnimationCache();
         currentScene = Scene::createScene(nextScene, nextSceneParam);
+        //The scene holds what it uses from the preparation, the rest can be freed
+        if(preparedScene == nextScene)
+        {
+            this->cancelScenePreparation();
+        }
         if(Director::getInstance()->getRunningScene() == nullptr)
         {
             Director::getInstance()->runWithScene(currentScene->getCocosScene());
@@ -243,7 +276,7 @@ void SceneSwitcher::replaceScene()
         nextSceneParam.clear();
         currentSceneName = nextScene;
         this->takeQueuedScene();
-        Value infos = Value(ValueMap({{"Scene", Value(currentSceneName)}}));
+        Value infos = Value(ValueMap({{EventInfoKey::Scene, Value(currentSceneName)}}));
         Director::getInstance()->getEventDispatcher()->dispatchCustomEvent("SceneSwitched", &infos);
     }
     else
@@ -259,4 +292,231 @@ void SceneSwitcher::replaceScene()
     log("Replace Scene ended in %f ms",  getTimeDifferenceMS(startTime, endTime));
 #endif
 }
+
+void SceneSwitcher::prepareScene(SceneName scene, ValueMap param)
+{
+    CCAssert(sceneFilesFunc != nullptr, "in prepareScene in SceneSwitcher : setSceneFilesFunc must be called first");
+    if(scene == preparedScene)
+    {
+        return;
+    }
+    this->cancelScenePreparation();
+    preparedScene = scene;
+    preparation = std::make_shared<PreparationState>();
+    preparation->cancelled = false;
+    preparation->done = false;
+    //Files are resolved here, since FileUtils path resolution isn't thread safe. Files already cached as templates only need their textures
+    std::vector<std::pair<std::string, std::string>> files;
+    for(const std::string& file : sceneFilesFunc(scene, param))
+    {
+        std::string fullPath = CCBLoaderResolveFile(file);
+        if(!fullPath.empty())
+        {
+            files.push_back(std::make_pair(file, fullPath));
+        }
+    }
+    PreparationJob job;
+    job.state = preparation;
+    job.files = files;
+    queuePreparationJob(std::move(job));
+#if VERBOSE_GENERAL_INFO
+    log("Preparing scene %s: %d files", formatSceneToString(scene).c_str(), (int)files.size());
+#endif
+}
+
+void SceneSwitcher::stopPreparationWorker()
+{
+    this->cancelScenePreparation();
+    //The worker stops after its current file, since the preparation is cancelled. Queued jobs are dropped
+    {
+        std::lock_guard<std::mutex> lock(preparationJobsMutex);
+        preparationStopping = true;
+    }
+    preparationJobsCondition.notify_all();
+    if(preparationThread.joinable())
+    {
+        preparationThread.join();
+    }
+    std::lock_guard<std::mutex> lock(preparationJobsMutex);
+    preparationJobs.clear();
+    preparationStopping = false;
+}
+
+void SceneSwitcher::queuePreparationJob(PreparationJob job)
+{
+    if(!preparationThread.joinable())
+    {
+        static bool stopRegistered = false;
+        if(!stopRegistered)
+        {
+            stopRegistered = true;
+            atexit(stopSharedPreparationWorker);
+        }
+        preparationThread = std::thread([this]() {
+            Profiler::setThreadName("SceneSwitcher");
+            while(true)
+            {
+                PreparationJob current;
+                {
+                    std::unique_lock<std::mutex> lock(preparationJobsMutex);
+                    preparationJobsCondition.wait(lock, [this]{ return preparationStopping || !preparationJobs.empty(); });
+                    if(preparationStopping)
+                    {
+                        return;
+                    }
+                    current = std::move(preparationJobs.front());
+                    preparationJobs.pop_front();
+                }
+                runPreparationJob(current);
+            }
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(preparationJobsMutex);
+        preparationJobs.push_back(std::move(job));
+    }
+    preparationJobsCondition.notify_one();
+}
+
+void SceneSwitcher::runPreparationJob(const PreparationJob& job)
+{
+    const std::shared_ptr<PreparationState>& state = job.state;
+    for(const auto& file : job.files)
+    {
+        if(state->cancelled)
+        {
+            break;
+        }
+        FENNEX_PROFILE_SCOPE("SceneSwitcher prepare CCB");
+        PreparedFile prepared;
+        prepared.file = file.first;
+        prepared.filePath = file.second;
+        Data data = FileUtils::getInstance()->getDataFromFile(file.second);
+        if(data.isNull())
+        {
+            continue;
+        }
+        for(const std::string& string : CCBLoaderGetStrings(data))
+        {
+            if(stringEndsWith(string, ".png") || stringEndsWith(string, ".jpg") || stringEndsWith(string, ".jpeg"))
+            {
+                prepared.textures.push_back(string);
+            }
+        }
+        prepared.data = std::make_shared<Data>(std::move(data));
+        {
+            std::lock_guard<std::mutex> lock(state->readyMutex);
+            state->ready.push_back(std::move(prepared));
+        }
+        //Read files are consumed during a frame, wake up the Director if it renders on demand
+        Director::getInstance()->requestRedraw();
+    }
+    std::lock_guard<std::mutex> lock(state->readyMutex);
+    state->done = true;
+}
+
+void SceneSwitcher::updatePreparation()
+{
+    if(preparationDone)
+    {
+        return;
+    }
+    std::vector<PreparedFile> ready;
+    bool workerDone;
+    {
+        std::lock_guard<std::mutex> lock(preparation->readyMutex);
+        ready.swap(preparation->ready);
+        workerDone = preparation->done;
+    }
+    for(PreparedFile& prepared : ready)
+    {
+        if(preparationMemory >= preparationMemoryCap)
+        {
+            break;
+        }
+        if(!CCBLoaderHasTemplate(prepared.file))
+        {
+            preparationMemory += prepared.data->getSize();
+            CCBLoaderAddTemplate(prepared.file, prepared.filePath, prepared.data);
+            templatesToDescribe.push_back(prepared.file);
+        }
+        for(const std::string& texture : prepared.textures)
+        {
+            if(requestedTextures.insert(texture).second)
+            {
+                //Lowest priority: the textures of the current scene come first
+                long handle = TextureLoader::sharedLoader()->loadTexture(texture, [this, texture](Texture2D* loaded) {
+                    preparationLoads.erase(texture);
+                    this->textureToPrepareLoaded(loaded);
+                }, -FLT_MAX);
+                if(handle != 0)
+                {
+                    preparationLoads[texture] = handle;
+                }
+            }
+        }
+    }
+    if(preparationMemory >= preparationMemoryCap)
+    {
+#if VERBOSE_GENERAL_INFO
+        log("Scene preparation memory cap reached, %s is partially prepared", formatSceneToString(preparedScene).c_str());
+#endif
+        preparation->cancelled = true;
+        for(const auto& load : preparationLoads)
+        {
+            TextureLoader::sharedLoader()->cancel(load.second);
+        }
+        preparationLoads.clear();
+        templatesToDescribe.clear();
+        workerDone = true;
+    }
+    //Reading a template creates its sprites: wait for their textures, so that it doesn't decode them synchronously
+    else if(preparationLoads.empty() && !templatesToDescribe.empty())
+    {
+        FENNEX_PROFILE_SCOPE("SceneSwitcher describe CCB");
+        //The template drops its bytes once described, they stay counted to keep the cap conservative
+        preparationMemory += CCBLoaderDescribeTemplate(templatesToDescribe.front());
+        templatesToDescribe.pop_front();
+        //One file per frame: wake up the Director for the next one if it renders on demand
+        if(!templatesToDescribe.empty())
+        {
+            Director::getInstance()->requestRedraw();
+        }
+    }
+    preparationDone = workerDone && preparationLoads.empty() && templatesToDescribe.empty();
+}
+
+void SceneSwitcher::textureToPrepareLoaded(Texture2D* texture)
+{
+    if(texture != nullptr && !preparedTextures.contains(texture))
+    {
+        preparedTextures.pushBack(texture);
+        preparationMemory += (size_t)texture->getPixelsWide() * texture->getPixelsHigh() * texture->getBitsPerPixelForFormat() / 8;
+    }
+}
+
+void SceneSwitcher::cancelScenePreparation()
+{
+    if(preparation != nullptr)
+    {
+        preparation->cancelled = true;
+        preparation = nullptr;
+    }
+    for(const auto& load : preparationLoads)
+    {
+        TextureLoader::sharedLoader()->cancel(load.second);
+    }
+    preparationLoads.clear();
+    requestedTextures.clear();
+    templatesToDescribe.clear();
+    preparedTextures.clear();
+    preparedScene = None;
+    preparationMemory = 0;
+    preparationDone = false;
+}
+
+bool SceneSwitcher::isScenePrepared(SceneName scene)
+{
+    return preparedScene == scene && preparationDone;
+}
 NS_FENNEX_END
@@ -32,6 +32,11 @@ USING_NS_CC;
 #include "SceneName.h"
 #include "Scene.h"
 #include "FenneXMacros.h"
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <condition_variable>
 
 #define SCENE_SWITCH_OFFSET 0.1f
 
@@ -58,6 +63,24 @@ public:
     
     // This function allow you to reload a scene that is already loaded. Be careful, it's your reponsibility to reload the state of the scene.
     void allowReload();
+    
+    /* Prepare a scene while the current one keeps running, so that switching to it doesn't read or decode files:
+     the CCB files of the scene are read on a worker thread, then their bytes are cached as CCB templates,
+     and the textures they reference are decoded by TextureLoader and kept until the scene is created.
+     Once the textures are decoded, the templates are described on the cocos thread, one file per frame, so that the switch only instantiates nodes.
+     The node graph itself is still created during the switch, since nodes and GraphicLayer can only be used on the cocos thread.
+     Preparing another scene, or planning a switch to another scene, cancels the current preparation
+     */
+    void prepareScene(SceneName scene, ValueMap param = ValueMap());
+    void cancelScenePreparation();
+    //True once all the files of the scene are prepared, or when the memory cap was reached
+    bool isScenePrepared(SceneName scene);
+    //Return the CCB files loaded by a scene (as passed to loadCCBFromFileToFenneX). Required by prepareScene
+    void setSceneFilesFunc(std::function<std::vector<std::string>(SceneName, const ValueMap&)> func) { sceneFilesFunc = func; }
+    //Maximum memory used by the prepared CCB files and textures, in bytes. What remains isn't prepared once reached. Default 32 MB
+    void setPreparationMemoryCap(size_t bytes) { preparationMemoryCap = bytes; }
+    //Cancel the preparation and join the worker thread. Called by the destructor and automatically at exit, a later prepareScene starts a new worker
+    void stopPreparationWorker();
 protected:
     void init();
     void replaceScene();
@@ -79,6 +102,52 @@ protected:
     bool reloadAllowed = false;
     
     EventListenerCustom* planSceneSwitchListener;
+    
+    //Shared with the worker thread: a cancelled preparation stops after its current file
+    struct PreparedFile
+    {
+        std::string file;
+        std::string filePath;
+        std::shared_ptr<Data> data;
+        std::vector<std::string> textures;
+    };
+    struct PreparationState
+    {
+        std::atomic<bool> cancelled;
+        std::mutex readyMutex;
+        std::vector<PreparedFile> ready;
+        bool done;
+    };
+    struct PreparationJob
+    {
+        std::shared_ptr<PreparationState> state;
+        //File and full path
+        std::vector<std::pair<std::string, std::string>> files;
+    };
+    //A single worker thread, started on the first preparation and joined by stopPreparationWorker, runs the jobs in order
+    void queuePreparationJob(PreparationJob job);
+    static void runPreparationJob(const PreparationJob& job);
+    std::thread preparationThread;
+    std::mutex preparationJobsMutex;
+    std::condition_variable preparationJobsCondition;
+    std::deque<PreparationJob> preparationJobs;
+    bool preparationStopping;
+    //Add the files read by the worker and request their textures, then describe one added template. Called each frame
+    void updatePreparation();
+    void textureToPrepareLoaded(Texture2D* texture);
+    std::function<std::vector<std::string>(SceneName, const ValueMap&)> sceneFilesFunc;
+    size_t preparationMemoryCap;
+    SceneName preparedScene;
+    std::shared_ptr<PreparationState> preparation;
+    size_t preparationMemory;
+    bool preparationDone;
+    //TextureLoader handles of the textures being prepared
+    std::map<std::string, long> preparationLoads;
+    std::set<std::string> requestedTextures;
+    //Templates added by the preparation, described once their textures are decoded
+    std::deque<std::string> templatesToDescribe;
+    //Prepared textures, retained until the scene is created
+    Vector<Texture2D*> preparedTextures;
 };
 NS_FENNEX_END
 
@@ -39,116 +39,218 @@ DelayedDispatcher::~DelayedDispatcher()
     temporaryInstanceScene = nullptr;
 }
 
-void DelayedDispatcher::eventAfterDelay(std::string eventName, Value userData, float delay)
+DelayedHandle DelayedDispatcher::eventAfterDelay(const std::string& eventName, const Value& userData, float delay)
 {
-    DelayedDispatcher* instance = getInstance();
-    instance->events.push_back(EventTuple(delay, eventName, userData));
+    Delayed delayed;
+    delayed.userData = userData;
+    return getInstance()->schedule(Type::Event, delay, eventName, std::move(delayed));
 }
 
-void DelayedDispatcher::funcAfterDelay(std::function<void(EventCustom*)> func, Value userData, float delay, std::string eventName)
+DelayedHandle DelayedDispatcher::funcAfterDelay(std::function<void(EventCustom*)> func, const Value& userData, float delay, const std::string& eventName)
 {
-    DelayedDispatcher* instance = getInstance();
-    instance->funcsWithParam.push_back(FuncParamTuple(delay, func, userData, eventName));
+    Delayed delayed;
+    delayed.userData = userData;
+    delayed.funcWithParam = std::move(func);
+    return getInstance()->schedule(Type::FuncWithParam, delay, eventName, std::move(delayed));
 }
 
-void DelayedDispatcher::funcAfterDelay(std::function<void(void)> func, float delay, std::string eventName)
+DelayedHandle DelayedDispatcher::funcAfterDelay(std::function<void(void)> func, float delay, const std::string& eventName)
+{
+    Delayed delayed;
+    delayed.funcWithoutParam = std::move(func);
+    return getInstance()->schedule(Type::FuncWithoutParam, delay, eventName, std::move(delayed));
+}
+
+bool DelayedDispatcher::cancelEvents(const std::string& eventName)
 {
     DelayedDispatcher* instance = getInstance();
-    instance->funcsWithoutParam.push_back(FuncNoParamTuple(delay, func, eventName));
+    return instance->cancelNamed(instance->eventsByName, eventName);
 }
 
-bool DelayedDispatcher::cancelEvents(std::string eventName)
+bool DelayedDispatcher::cancelFuncs(const std::string& eventName)
 {
     DelayedDispatcher* instance = getInstance();
-    long before = instance->events.size();
-    if(before == 0) return false;
-    instance->events.erase(std::remove_if(instance->events.begin(), instance->events.end(), [&](const EventTuple& tuple) { return std::get<1>(tuple) == eventName; }), instance->events.end());
-    return before != instance->events.size();
+    return instance->cancelNamed(instance->funcsByName, eventName);
 }
 
-bool DelayedDispatcher::cancelFuncs(std::string eventName)
+bool DelayedDispatcher::cancel(DelayedHandle handle)
 {
     DelayedDispatcher* instance = getInstance();
-    long before = instance->funcsWithParam.size() + instance->funcsWithoutParam.size();
-    if(before == 0) return false;
-    instance->funcsWithParam.erase(std::remove_if(instance->funcsWithParam.begin(), instance->funcsWithParam.end(), [&](const FuncParamTuple& tuple) { return std::get<3>(tuple) == eventName; }), instance->funcsWithParam.end());
-    instance->funcsWithoutParam.erase(std::remove_if(instance->funcsWithoutParam.begin(), instance->funcsWithoutParam.end(), [&](const FuncNoParamTuple& tuple) { return std::get<2>(tuple) == eventName; }), instance->funcsWithoutParam.end());
-    return before != instance->funcsWithParam.size() + instance->funcsWithoutParam.size();
+    auto it = instance->pending.find(handle);
+    if(it == instance->pending.end()) return false;
+    instance->take(it);
+    return true;
 }
 
 void DelayedDispatcher::update(float deltaTime)
 {
-    //Use a separate vector for calling, as called events can modify this vector
-    
-    //First, call events
-    std::vector<EventTuple> eventsToCall;
-    for(EventTuple& tuple : events)
+    previousClock = clock;
+    clock += deltaTime;
+    updating = true;
+    dueHandles.clear();
+    //Events first, then funcs with param, then funcs without param, each in scheduling order (handles are increasing)
+    for(Type phase : {Type::Event, Type::FuncWithParam, Type::FuncWithoutParam})
     {
-        std::get<0>(tuple) -= deltaTime;
-        if(std::get<0>(tuple) < 0)
+        updatePhase = phase;
+        //Only pop what is due, including what the previous phases scheduled (see schedule). The delay was reached when the remaining time becomes negative
+        while(!deadlines.empty() && deadlines.top().first < clock)
         {
-            eventsToCall.push_back(tuple);
+            DelayedHandle handle = deadlines.top().second;
+            deadlines.pop();
+            if(pending.find(handle) != pending.end())
+            {
+                dueHandles.push_back(handle);
+            }
         }
+        std::vector<DelayedHandle> phaseHandles;
+        for(DelayedHandle handle : dueHandles)
+        {
+            auto it = pending.find(handle);
+            if(it != pending.end() && it->second.type == phase)
+            {
+                phaseHandles.push_back(handle);
+            }
+        }
+        std::sort(phaseHandles.begin(), phaseHandles.end());
+        
+        //Move due entries out of pending before calling them, as called events can schedule or cancel others
+        std::vector<Delayed> dueDelayed;
+        dueDelayed.reserve(phaseHandles.size());
+        for(DelayedHandle handle : phaseHandles)
+        {
+            dueDelayed.push_back(this->take(pending.find(handle)));
+        }
+        this->dispatch(dueDelayed);
     }
-    for(EventTuple& tuple : eventsToCall)
-    {
-#if VERBOSE_GENERAL_INFO
-        log("Launching event %s", std::get<1>(tuple).c_str());
-#endif
-        Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(std::get<1>(tuple), &std::get<2>(tuple));
-    }
-    if(events.size() > 0)
+    updating = false;
+    //Entries of a phase which already ran, scheduled with a negative delay by a later phase, wait for the next update
+    for(DelayedHandle handle : dueHandles)
     {
-        events.erase(std::remove_if(events.begin(), events.end(), [](const EventTuple& tuple) { return std::get<0>(tuple) < 0; }), events.end());
+        auto it = pending.find(handle);
+        if(it != pending.end())
+        {
+            deadlines.push(Deadline(it->second.deadline, handle));
+        }
     }
     
-    //Then call funcs with param
-    std::vector<FuncParamTuple> funcsToCall;
-    for(FuncParamTuple& tuple : funcsWithParam)
+    //Cancelled entries stay in the heap until their deadline: rebuild it if they pile up
+    if(deadlines.size() > pending.size() * 2 + 64)
     {
-        std::get<0>(tuple) -= deltaTime;
-        if(std::get<0>(tuple) < 0)
+        std::vector<Deadline> remaining;
+        remaining.reserve(pending.size());
+        for(const auto& it : pending)
         {
-            funcsToCall.push_back(tuple);
+            remaining.push_back(Deadline(it.second.deadline, it.first));
         }
+        deadlines = decltype(deadlines)(std::greater<Deadline>(), std::move(remaining));
     }
-    for(FuncParamTuple& tuple : funcsToCall)
+    this->requestRedrawForNextDeadline();
+}
+
+void DelayedDispatcher::dispatch(std::vector<Delayed>& dueDelayed)
+{
+    for(Delayed& delayed : dueDelayed)
     {
-        EventCustom* event = EventCustom::create(std::get<3>(tuple), &std::get<2>(tuple));
+        if(delayed.type == Type::Event)
+        {
+#if VERBOSE_GENERAL_INFO
+            log("Launching event %s", delayed.name.c_str());
+#endif
+            if(delayed.eventID >= 0)
+            {
+                Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(delayed.eventID, &delayed.userData);
+            }
+            else
+            {
+                Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(delayed.name, &delayed.userData);
+            }
+        }
+        else if(delayed.type == Type::FuncWithParam)
+        {
+            EventCustom* event = EventCustom::create(delayed.name, &delayed.userData);
+#if VERBOSE_GENERAL_INFO
+            log("Launching func named %s", delayed.name.c_str());
+#endif
+            delayed.funcWithParam(event);
+        }
+        else
+        {
 #if VERBOSE_GENERAL_INFO
-            log("Launching func named %s", std::get<3>(tuple).c_str());
+            log("Launching func named %s", delayed.name.c_str());
 #endif
-        std::get<1>(tuple)(event);
+            delayed.funcWithoutParam();
+        }
     }
-    if(funcsWithParam.size() > 0)
+}
+
+DelayedHandle DelayedDispatcher::schedule(Type type, float delay, const std::string& name, Delayed&& delayed)
+{
+    static DelayedHandle nextHandle = 0;
+    DelayedHandle handle = nextHandle++;
+    delayed.type = type;
+    //Like before the deadlines heap, what an update phase schedules for a later phase of the same update counts this update time
+    delayed.deadline = (updating && type > updatePhase ? previousClock : clock) + delay;
+    delayed.name = name;
+    if(type == Type::Event)
     {
-        funcsWithParam.erase(std::remove_if(funcsWithParam.begin(), funcsWithParam.end(), [](const FuncParamTuple& tuple) { return std::get<0>(tuple) < 0; }), funcsWithParam.end());
+        //Only use the ID of names somebody listens to, others would be registered for nothing
+        delayed.eventID = Director::getInstance()->getEventDispatcher()->findCustomEventID(name);
     }
-    
-    //Last, call funcs without param
-    std::vector<FuncNoParamTuple> funcsToCallNoParam;
-    for(FuncNoParamTuple& tuple : funcsWithoutParam)
+    deadlines.push(Deadline(delayed.deadline, handle));
+    this->getNameIndex(type)[name].insert(handle);
+    pending.emplace(handle, std::move(delayed));
+    this->requestRedrawForNextDeadline();
+    return handle;
+}
+
+void DelayedDispatcher::requestRedrawForNextDeadline()
+{
+    //When the Director renders on demand, make sure there is a frame right after the next deadline
+    if(!deadlines.empty() && Director::getInstance()->isRenderOnDemand())
     {
-        std::get<0>(tuple) -= deltaTime;
-        if(std::get<0>(tuple) < 0)
-        {
-            funcsToCallNoParam.push_back(tuple);
-        }
+        Director::getInstance()->requestRedraw(MAX(0, deadlines.top().first - clock) + 0.001);
     }
-    for(FuncNoParamTuple& tuple : funcsToCallNoParam)
+}
+
+DelayedDispatcher::Delayed DelayedDispatcher::take(std::unordered_map<DelayedHandle, Delayed>::iterator it)
+{
+    auto& index = this->getNameIndex(it->second.type);
+    auto named = index.find(it->second.name);
+    if(named != index.end())
     {
-#if VERBOSE_GENERAL_INFO
-        log("Launching func named %s", std::get<2>(tuple).c_str());
-#endif
-        std::get<1>(tuple)();
+        named->second.erase(it->first);
+        if(named->second.empty())
+        {
+            index.erase(named);
+        }
     }
-    if(funcsWithoutParam.size() > 0)
+    Delayed delayed = std::move(it->second);
+    pending.erase(it);
+    return delayed;
+}
+
+std::unordered_map<std::string, std::unordered_set<DelayedHandle>>& DelayedDispatcher::getNameIndex(Type type)
+{
+    return type == Type::Event ? eventsByName : funcsByName;
+}
+
+bool DelayedDispatcher::cancelNamed(std::unordered_map<std::string, std::unordered_set<DelayedHandle>>& index, const std::string& name)
+{
+    auto named = index.find(name);
+    if(named == index.end()) return false;
+    //take also updates the index: work on a copy
+    std::unordered_set<DelayedHandle> handles = named->second;
+    for(DelayedHandle handle : handles)
     {
-        funcsWithoutParam.erase(std::remove_if(funcsWithoutParam.begin(), funcsWithoutParam.end(), [](const FuncNoParamTuple& tuple) { return std::get<0>(tuple) < 0; }), funcsWithoutParam.end());
+        auto it = pending.find(handle);
+        if(it != pending.end())
+        {
+            this->take(it);
+        }
     }
+    return !handles.empty();
 }
 
-
 DelayedDispatcher* DelayedDispatcher::getInstance()
 {
     //A DelayedDispatcher must be linked to a scene to keep old behavior (delayed funcs/events don't last more than the scene they were created on)
@@ -27,34 +27,78 @@
 
 #include "cocos2d.h"
 #include "Pausable.h"
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
 USING_NS_CC;
 
 NS_FENNEX_BEGIN
 
-typedef std::tuple<float, std::string, Value> EventTuple;
-typedef std::tuple<float, std::function<void(cocos2d::EventCustom*)>, Value, std::string> FuncParamTuple;
-typedef std::tuple<float, std::function<void(void)>, std::string> FuncNoParamTuple;
+//Returned when scheduling, to cancel a specific event or func. Handles are never reused
+typedef long DelayedHandle;
 
 /* DelayedDispatcher works by attaching itself to current scene and monitoring updates.
  For retro-compatibility, it only works for current scene
+ Pending events and funcs are kept in a min-heap of absolute deadlines, so an update only costs the number of events and funcs which are due.
+ During an update, due events are dispatched first, then due funcs with param, then due funcs without param, each in scheduling order.
+ A func scheduled by an event (or a func without param by a func with param) with a delay shorter than the update time is called in the same update
  */
 class DelayedDispatcher : public Ref, public Pausable
 {
 public:
     ~DelayedDispatcher();
-    static void eventAfterDelay(std::string eventName, Value userData, float delay);
-    static void funcAfterDelay(std::function<void(cocos2d::EventCustom*)> func, Value userData, float delay, std::string eventName="");
-    static void funcAfterDelay(std::function<void()> func, float delay, std::string eventName="");
+    static DelayedHandle eventAfterDelay(const std::string& eventName, const Value& userData, float delay);
+    static DelayedHandle funcAfterDelay(std::function<void(cocos2d::EventCustom*)> func, const Value& userData, float delay, const std::string& eventName="");
+    static DelayedHandle funcAfterDelay(std::function<void()> func, float delay, const std::string& eventName="");
     //Return true if at least one was cancelled
-    static bool cancelEvents(std::string eventName);
-    static bool cancelFuncs(std::string eventName);
+    static bool cancelEvents(const std::string& eventName);
+    static bool cancelFuncs(const std::string& eventName);
+    //Return true if the event or func was still pending
+    static bool cancel(DelayedHandle handle);
     void update(float deltaTime);
 private:
+    enum class Type
+    {
+        Event = 0,
+        FuncWithParam,
+        FuncWithoutParam,
+    };
+    struct Delayed
+    {
+        Type type;
+        double deadline;
+        std::string name;
+        //ID of the event name if somebody listens to it when scheduling, so dispatching doesn't hash the name. -1 to dispatch by name
+        int eventID = -1;
+        Value userData;
+        std::function<void(cocos2d::EventCustom*)> funcWithParam;
+        std::function<void()> funcWithoutParam;
+    };
+    //Heap entries are not removed on cancel: they are skipped when they don't match a pending handle anymore
+    typedef std::pair<double, DelayedHandle> Deadline;
+    
     static DelayedDispatcher* getInstance();
-    std::vector<EventTuple> events;
-    std::vector<FuncParamTuple> funcsWithParam;
-    std::vector<FuncNoParamTuple> funcsWithoutParam;
+    DelayedHandle schedule(Type type, float delay, const std::string& name, Delayed&& delayed);
+    void dispatch(std::vector<Delayed>& dueDelayed);
+    //Used when the Director renders on demand, as the dispatcher is only updated when a frame is drawn
+    void requestRedrawForNextDeadline();
+    //Remove a pending entry from the pending map and the name index, and return it
+    Delayed take(std::unordered_map<DelayedHandle, Delayed>::iterator it);
+    std::unordered_map<std::string, std::unordered_set<DelayedHandle>>& getNameIndex(Type type);
+    bool cancelNamed(std::unordered_map<std::string, std::unordered_set<DelayedHandle>>& index, const std::string& name);
+    
+    double clock = 0;
+    //Clock before the current update, and phase being dispatched while updating
+    double previousClock = 0;
+    bool updating = false;
+    Type updatePhase = Type::Event;
+    std::unordered_map<DelayedHandle, Delayed> pending;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines;
+    //Name indexes, events and funcs are cancelled separately
+    std::unordered_map<std::string, std::unordered_set<DelayedHandle>> eventsByName;
+    std::unordered_map<std::string, std::unordered_set<DelayedHandle>> funcsByName;
+    std::vector<DelayedHandle> dueHandles;
 };
 
 NS_FENNEX_END
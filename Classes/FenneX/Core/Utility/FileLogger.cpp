@@ -26,7 +26,12 @@
 #include "FenneX.h"
 #include "NativeUtility.h"
 #include <iomanip>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "DevicePermissions.h"
+#include "Profiler.h"
 
 USING_NS_CC;
 USING_NS_FENNEX;
@@ -34,12 +39,137 @@ USING_NS_AC;
 
 static std::string currentFileDate = "";
 static std::string logsPath = "";
+static std::string packageLogsPath = "";
+static std::string logFilePath = "";
 static int logFilePreservationDelay = FILE_LOGGER_NEVER_DELETE;
 static const std::string logFileExtension = ".log";
 static const std::string logFileDateFormat = "%d_%m_%Y_%H_%M";
 
+//Writer thread thresholds
+static const size_t logQueueCapacity = 1024; //Must be a power of 2
+static const size_t logQueueWakeThreshold = 256; //Queued records before the writer is woken up
+static const size_t logFlushSize = 16 * 1024; //Pending bytes before they are written
+static const std::chrono::milliseconds logFlushDelay(1000);
+
+struct LogRecord
+{
+    FileLogger::Severity severity;
+    time_t time;
+    std::string text;
+};
+
+/* Bounded multi-producer queue: pushing never locks, and fails when the queue is full
+ Each slot sequence tells whether it is ready to be written (sequence == position) or read (sequence == position + 1)
+ */
+class LogQueue
+{
+public:
+    LogQueue()
+    {
+        for(size_t i = 0; i < logQueueCapacity; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    bool push(LogRecord&& record)
+    {
+        Slot* slot;
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while(true)
+        {
+            slot = &slots[position & (logQueueCapacity - 1)];
+            intptr_t difference = (intptr_t)slot->sequence.load(std::memory_order_acquire) - (intptr_t)position;
+            if(difference == 0)
+            {
+                if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            }
+            else if(difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = std::move(record);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool pop(LogRecord& record)
+    {
+        Slot* slot;
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        while(true)
+        {
+            slot = &slots[position & (logQueueCapacity - 1)];
+            intptr_t difference = (intptr_t)slot->sequence.load(std::memory_order_acquire) - (intptr_t)(position + 1);
+            if(difference == 0)
+            {
+                if(dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            }
+            else if(difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        record = std::move(slot->record);
+        slot->sequence.store(position + logQueueCapacity, std::memory_order_release);
+        return true;
+    }
+    
+    //Approximate, since producers may be pushing concurrently
+    size_t size()
+    {
+        size_t enqueued = enqueuePosition.load(std::memory_order_relaxed);
+        size_t dequeued = dequeuePosition.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+    
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+    Slot slots[logQueueCapacity];
+    std::atomic<size_t> enqueuePosition{0};
+    std::atomic<size_t> dequeuePosition{0};
+};
+
+static LogQueue logQueue;
+static std::atomic<long> droppedRecords{0};
+static std::atomic<bool> asyncLogging{false};
+static std::atomic<bool> writerRunning{false};
+static std::atomic<bool> writerStopped{false};
+static std::atomic<bool> urgentFlush{false};
+static std::atomic<bool> storagePermission{false};
+static std::atomic<time_t> lastPermissionCheck{0};
+static std::thread writerThread;
+static std::once_flag writerStarted;
+static std::mutex writerWakeMutex;
+static std::condition_variable writerWakeCondition;
+
+//Protects everything below, and the file state (setup, path). Only held while writing or setting up, never by a logging thread in async mode
+static std::recursive_mutex writeMutex;
+//Logs are kept in there until they can actually be written to file.
+//Sometimes, the log file just won't open right when needed
+static std::string unsavedLogs;
+static FILE* logFile = nullptr;
+static long reportedDroppedRecords = 0;
+static time_t lastDateTime = 0;
+static std::string lastDatePrint;
+static bool unwritableReported = false;
+
 void FileLogger::setup(std::string _logsPath, int deleteAfter)
 {
+    std::lock_guard<std::recursive_mutex> lock(writeMutex);
     if(!currentFileDate.empty()) {
         CCASSERT(1, "Trying to setup FileLogger several time. Previous setup date: " + currentFileDate);
     }
@@ -51,6 +181,9 @@ void FileLogger::setup(std::string _logsPath, int deleteAfter)
     
     logsPath = _logsPath;
     if(!stringEndsWith(logsPath, "/")) logsPath += "/";
+    //getPackageIdentifier is a native call which must be done on the main thread, while the path is used by the writer thread
+    packageLogsPath = logsPath + getPackageIdentifier() + "/";
+    logFilePath = "";
     logFilePreservationDelay = deleteAfter;
     
     removeOldLogs();
@@ -91,15 +224,35 @@ std::string FileLogger::currentFilename()
     return currentFileDate + logFileExtension;
 }
 
+void FileLogger::setAsync(bool async)
+{
+    if(!async)
+    {
+        flush();
+    }
+    //The writer thread isn't restarted after shutdown
+    asyncLogging = async && !writerStopped;
+}
+
+bool FileLogger::isAsync()
+{
+    return asyncLogging;
+}
+
+long FileLogger::getDroppedRecordsCount()
+{
+    return droppedRecords;
+}
+
 void FileLogger::removeOldLogs()
 {
-    if(logFilePreservationDelay == FILE_LOGGER_NEVER_DELETE || !DevicePermissions::hasPermission(Permission::STORAGE)) return;
+    if(logFilePreservationDelay == FILE_LOGGER_NEVER_DELETE || !hasStoragePermission()) return;
     
-    std::vector<std::string> logFiles = getFilesInFolder(logsPath + getPackageIdentifier() + "/");
+    std::vector<std::string> logFiles = getFilesInFolder(packageLogsPath);
     time_t now = time(nullptr);
     for(std::string file : logFiles)
     {
-        std::string fileFullPath = logsPath + getPackageIdentifier() + "/" + file;
+        std::string fileFullPath = packageLogsPath + file;
         if(now > getFileLastModificationDate(fileFullPath) + logFilePreservationDelay)
         {
             FileUtils::getInstance()->removeFile(fileFullPath);
@@ -109,9 +262,28 @@ void FileLogger::removeOldLogs()
 
 std::string FileLogger::getFilePath()
 {
-    FileUtils::getInstance()->createDirectory(logsPath);
-    FileUtils::getInstance()->createDirectory(logsPath + getPackageIdentifier() + "/");
-    return logsPath + getPackageIdentifier() + "/" + currentFilename();
+    //Directories are only created once per session
+    if(logFilePath.empty())
+    {
+        FileUtils::getInstance()->createDirectory(logsPath);
+        FileUtils::getInstance()->createDirectory(packageLogsPath);
+        logFilePath = FileUtils::getInstance()->getSuitableFOpen(packageLogsPath + currentFilename());
+    }
+    return logFilePath;
+}
+
+bool FileLogger::hasStoragePermission()
+{
+    if(!storagePermission)
+    {
+        time_t now = time(nullptr);
+        //Logging threads race here: only the first one to see a new second checks
+        if(lastPermissionCheck.exchange(now) != now)
+        {
+            storagePermission = DevicePermissions::hasPermission(Permission::STORAGE);
+        }
+    }
+    return storagePermission;
 }
 
 std::string FileLogger::severityPrint(Severity severity)
@@ -139,55 +311,181 @@ std::string FileLogger::currentDatePrint()
     return buff;
 }
 
-//Unsaved logs are kept in there until they can actually be written to file.
-//Sometimes, the log file just won't open right when needed
-std::vector<std::string> unsavedLogs;
+//The date is only formatted once per second
+void FileLogger::appendRecord(Severity severity, time_t time, const std::string& text)
+{
+    if(time != lastDateTime || lastDatePrint.empty())
+    {
+        struct tm date;
+        //Called by the writer thread: use the reentrant version instead of localtime
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+        localtime_s(&date, &time);
+#else
+        localtime_r(&time, &date);
+#endif
+        char buff[100];
+        strftime(buff, 100, "%d/%m/%Y %T", &date);
+        lastDateTime = time;
+        lastDatePrint = buff;
+    }
+    unsavedLogs += lastDatePrint;
+    unsavedLogs += " - ";
+    unsavedLogs += severityPrint(severity);
+    unsavedLogs += " - ";
+    unsavedLogs += text;
+    unsavedLogs += "\n";
+}
 
-void FileLogger::_log(Severity severity, std::string module, std::string message)
+void FileLogger::appendDroppedRecords()
 {
-    log("%s: %s", module.c_str(), message.c_str());
-    
-    std::string logStr = currentDatePrint() + " - " + severityPrint(severity) + " - " + module + " - " + message + "\n";
-    if(!DevicePermissions::hasPermission(Permission::STORAGE))
+    long dropped = droppedRecords;
+    if(dropped != reportedDroppedRecords)
     {
-        unsavedLogs.push_back(logStr);
-        log("FileLogger can't write to log file without storage permission. Log will be written next time.");
-        return;
+        appendRecord(Severity::WARNING, time(nullptr), "FileLogger - " + std::to_string(dropped - reportedDroppedRecords) + " records dropped because the queue was full");
+        reportedDroppedRecords = dropped;
     }
-    
-    if(currentFileDate.empty())
+}
+
+//Keep unsaved logs if they can't be written yet, they will be written next time
+void FileLogger::writeUnsavedLogs()
+{
+    if(unsavedLogs.empty()) return;
+    if(currentFileDate.empty() || !storagePermission)
     {
-        unsavedLogs.push_back(logStr);
-        log("FileLogger isn't setup yet. Log will be written next time.");
+        if(!unwritableReported)
+        {
+            log(currentFileDate.empty() ? "FileLogger isn't setup yet. Log will be written next time." : "FileLogger can't write to log file without storage permission. Log will be written next time.");
+            unwritableReported = true;
+        }
         return;
     }
-    
-    std::string fullPath = getFilePath();
-    
-    //Compose the full string that needs to be saved to file with logs that couldn't be saved first
-    std::string dataStr;
-    for(std::string unsaved : unsavedLogs)
-    {
-        dataStr += unsaved;
-    }
-    dataStr += logStr;
-    // Code copied and adapted from cocos2dx FileUtils: we want to append, and we don't need the result
-    Data data;
-    data.fastSet((unsigned char*)dataStr.c_str(), dataStr.size());
-    // Since this is a log file, we only append
-    const char* mode = "ab";
-    FILE *fp = fopen(FileUtils::getInstance()->getSuitableFOpen(fullPath).c_str(), mode);
-    if(fp != nullptr)
-    {
-        fwrite(data.getBytes(), data.getSize(), 1, fp);
-        fclose(fp);
+    // Since this is a log file, we only append. The file is kept open for the session
+    if(logFile == nullptr)
+    {
+        logFile = fopen(getFilePath().c_str(), "ab");
+    }
+    if(logFile != nullptr && fwrite(unsavedLogs.data(), unsavedLogs.size(), 1, logFile) == 1 && fflush(logFile) == 0)
+    {
         unsavedLogs.clear();
+        unwritableReported = false;
+    }
+    else
+    {
+        //If we cannot write to the file, try to reopen it next time
+        if(logFile != nullptr)
+        {
+            fclose(logFile);
+            logFile = nullptr;
+        }
+        if(!unwritableReported)
+        {
+            log("FileLogger could not open log file");
+            unwritableReported = true;
+        }
+    }
+}
+
+void FileLogger::drainQueue()
+{
+    LogRecord record;
+    while(logQueue.pop(record))
+    {
+        appendRecord(record.severity, record.time, record.text);
+        if(record.severity >= Severity::ERROR)
+        {
+            urgentFlush = true;
+        }
+    }
+    appendDroppedRecords();
+}
+
+void FileLogger::runWriter()
+{
+    FenneX::Profiler::setThreadName("FileLogger");
+    auto lastFlush = std::chrono::steady_clock::now();
+    while(writerRunning)
+    {
+        {
+            std::unique_lock<std::mutex> lock(writerWakeMutex);
+            writerWakeCondition.wait_for(lock, logFlushDelay, []{ return urgentFlush || !writerRunning || logQueue.size() >= logQueueWakeThreshold; });
+        }
+        FENNEX_PROFILE_SCOPE("FileLogger write");
+        std::lock_guard<std::recursive_mutex> lock(writeMutex);
+        drainQueue();
+        auto now = std::chrono::steady_clock::now();
+        if(urgentFlush || unsavedLogs.size() >= logFlushSize || now - lastFlush >= logFlushDelay)
+        {
+            urgentFlush = false;
+            writeUnsavedLogs();
+            lastFlush = now;
+        }
+    }
+}
+
+void FileLogger::flush()
+{
+    std::lock_guard<std::recursive_mutex> lock(writeMutex);
+    drainQueue();
+    urgentFlush = false;
+    writeUnsavedLogs();
+}
+
+void FileLogger::shutdown()
+{
+    writerStopped = true;
+    asyncLogging = false;
+    bool wasRunning;
+    {
+        //Change the predicate under the wake mutex, so the writer can't miss it between its check and its wait
+        std::lock_guard<std::mutex> lock(writerWakeMutex);
+        wasRunning = writerRunning.exchange(false);
+        writerWakeCondition.notify_one();
+    }
+    if(wasRunning)
+    {
+        writerThread.join();
+    }
+    flush();
+    std::lock_guard<std::recursive_mutex> lock(writeMutex);
+    if(logFile != nullptr)
+    {
+        fclose(logFile);
+        logFile = nullptr;
+    }
+}
+
+void FileLogger::_log(Severity severity, std::string module, std::string message)
+{
+    log("%s: %s", module.c_str(), message.c_str());
+    
+    //Permission is refreshed on the calling thread, since it may require a native call
+    hasStoragePermission();
+    LogRecord record{severity, time(nullptr), module + " - " + message};
+    if(asyncLogging)
+    {
+        std::call_once(writerStarted, []{
+            writerRunning = true;
+            writerThread = std::thread(runWriter);
+            atexit(shutdown);
+        });
+        if(!logQueue.push(std::move(record)))
+        {
+            droppedRecords++;
+            return;
+        }
+        if(severity >= Severity::ERROR || logQueue.size() >= logQueueWakeThreshold)
+        {
+            //Under the wake mutex, see shutdown
+            std::lock_guard<std::mutex> lock(writerWakeMutex);
+            if(severity >= Severity::ERROR) urgentFlush = true;
+            writerWakeCondition.notify_one();
+        }
     }
     else
     {
-        //If we cannot open the file, save the log for future saving.
-        unsavedLogs.push_back(logStr);
-        log("FileLogger could not open log file");
+        std::lock_guard<std::recursive_mutex> lock(writeMutex);
+        drainQueue();
+        appendRecord(record.severity, record.time, record.text);
+        writeUnsavedLogs();
     }
-    data.fastSet(nullptr, 0);
 }
@@ -35,6 +35,11 @@
  If a log is sent while FileLogger isn't setup, it will be logged to console, but not to file
  
  Any file older than the configured delay is removed
+ 
+ By default, each record is written to file on the calling thread, so that it is on disk even if the app crashes right after.
+ With setAsync(true), records are pushed to a lock-free queue, and a writer thread appends them to the file.
+ Pending records are written when enough of them are queued, after a short delay, right away for ERROR and CRITICAL, and at exit.
+ If the queue is full, the record is only logged to console, and counted as dropped.
  */
 #define FILE_LOGGER_NEVER_DELETE -1
 class FileLogger
@@ -58,12 +63,31 @@ public:
     
     static std::string getLogsPath();
     static std::string currentFilename();
+    
+    //Disabled by default. When disabled, records are written to file on the calling thread. Pending records are written first
+    static void setAsync(bool async);
+    static bool isAsync();
+    //Write all pending records now, blocking the calling thread
+    static void flush();
+    //Write pending records and stop the writer thread. Called automatically at exit, logging afterward is synchronous
+    static void shutdown();
+    //Number of records which couldn't be written to file because the queue was full
+    static long getDroppedRecordsCount();
 private:
     static void removeOldLogs();
     static std::string getFilePath();
+    //DevicePermissions is a native call: a granted permission is cached, a missing one is checked at most once per second
+    static bool hasStoragePermission();
     static std::string severityPrint(Severity severity);
     static std::string currentDatePrint();
     static void _log(Severity severity, std::string module, std::string message);
+    
+    //Writer side, all called with the write lock held except runWriter
+    static void runWriter();
+    static void drainQueue();
+    static void appendRecord(Severity severity, time_t time, const std::string& text);
+    static void appendDroppedRecords();
+    static void writeUnsavedLogs();
 };
 
 
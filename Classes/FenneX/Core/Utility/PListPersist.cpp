@@ -26,6 +26,14 @@ THE SOFTWARE.
 #include "Shorteners.h"
 #include <errno.h>
 #include <unistd.h>
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <io.h>
+#include <windows.h>
+#endif
 #include "NativeUtility.h"
 #include "AppMacros.h"
 #include "FenneXMacros.h"
@@ -98,9 +106,404 @@ void appendObject(Value& val, xml_node& node)
     }
 }
 
-void saveValueToFile(Value& val, std::string fileName, FileLocation location)
+/**********************************************************************************
+ Binary format
+ *********************************************************************************/
+//Header: magic and format version
+static const char binaryPListHeader[] = {'F', 'N', 'X', 'P', 'L', 'S', 'T', 1};
+static const int binaryPListMaxDepth = 512;
+
+enum BinaryPListTag : unsigned char
+{
+    BinaryNone = 0,
+    BinaryDict,
+    BinaryIntKeyDict,
+    BinaryArray,
+    BinaryString,
+    BinaryInteger,
+    BinaryReal,
+    BinaryTrue,
+    BinaryFalse,
+};
+
+static bool isBinaryPList(const void* data, size_t size)
+{
+    return size >= sizeof(binaryPListHeader) && memcmp(data, binaryPListHeader, sizeof(binaryPListHeader)) == 0;
+}
+
+//Write values directly to the file as they are visited, without building the whole document first
+class BinaryPListWriter
+{
+public:
+    BinaryPListWriter(FILE* file) : file(file) {}
+    
+    void writeHeader()
+    {
+        fwrite(binaryPListHeader, 1, sizeof(binaryPListHeader), file);
+    }
+    
+    void writeValue(const Value& val)
+    {
+        switch(val.getType())
+        {
+            case Value::Type::MAP:
+                writeTag(BinaryDict);
+                writeVarint(val.asValueMap().size());
+                for(const auto& it : val.asValueMap())
+                {
+                    writeString(it.first);
+                    writeValue(it.second);
+                }
+                break;
+            case Value::Type::INT_KEY_MAP:
+                writeTag(BinaryIntKeyDict);
+                writeVarint(val.asIntKeyMap().size());
+                for(const auto& it : val.asIntKeyMap())
+                {
+                    writeVarint(zigzag(it.first));
+                    writeValue(it.second);
+                }
+                break;
+            case Value::Type::VECTOR:
+                writeTag(BinaryArray);
+                writeVarint(val.asValueVector().size());
+                for(const Value& child : val.asValueVector())
+                {
+                    writeValue(child);
+                }
+                break;
+            case Value::Type::STRING:
+                writeTag(BinaryString);
+                writeString(val.asString());
+                break;
+            case Value::Type::INTEGER:
+                writeTag(BinaryInteger);
+                writeVarint(zigzag(val.asInt()));
+                break;
+            case Value::Type::FLOAT:
+            case Value::Type::DOUBLE:
+            {
+                writeTag(BinaryReal);
+                double real = val.asDouble();
+                uint64_t bits;
+                memcpy(&bits, &real, sizeof(bits));
+                unsigned char bytes[8];
+                for(int i = 0; i < 8; i++)
+                {
+                    bytes[i] = (unsigned char)(bits >> (i * 8));
+                }
+                fwrite(bytes, 1, 8, file);
+                break;
+            }
+            case Value::Type::BOOLEAN:
+                writeTag(val.asBool() ? BinaryTrue : BinaryFalse);
+                break;
+            default:
+#if VERBOSE_SAVE_PLIST
+                log("Warning: unrecognized Value type when saving plist, check if the object is in plist format. Value description: %s", val.getDescription().c_str());
+#endif
+                //Keep the structure valid: it will be ignored when loading, as XML unrecognized types
+                writeTag(BinaryNone);
+                break;
+        }
+    }
+    
+private:
+    static uint64_t zigzag(int64_t value)
+    {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+    
+    void writeTag(BinaryPListTag tag)
+    {
+        fputc(tag, file);
+    }
+    
+    void writeVarint(uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            fputc((int)((value & 0x7F) | 0x80), file);
+            value >>= 7;
+        }
+        fputc((int)value, file);
+    }
+    
+    void writeString(const std::string& value)
+    {
+        writeVarint(value.size());
+        fwrite(value.data(), 1, value.size(), file);
+    }
+    
+    FILE* file;
+};
+
+//Read values from a memory block (usually mapped), checking bounds. On corrupted data, the result is a null Value
+class BinaryPListReader
+{
+public:
+    BinaryPListReader(const unsigned char* data, size_t size) :
+    cursor(data + sizeof(binaryPListHeader)),
+    end(data + size),
+    failed(false)
+    {
+    }
+    
+    Value readDocument()
+    {
+        Value result = readValue(0);
+        return failed ? Value() : result;
+    }
+    
+private:
+    Value readValue(int depth)
+    {
+        if(cursor >= end || depth > binaryPListMaxDepth)
+        {
+            failed = true;
+            return Value();
+        }
+        unsigned char tag = *cursor++;
+        uint64_t count;
+        switch(tag)
+        {
+            case BinaryNone:
+                return Value();
+            case BinaryDict:
+            {
+                if(!readCount(count)) return Value();
+                ValueMap map;
+                map.reserve(count);
+                for(uint64_t i = 0; i < count && !failed; i++)
+                {
+                    std::string key;
+                    if(!readString(key)) break;
+                    Value result = readValue(depth + 1);
+                    if(!result.isNull())
+                    {
+                        map[std::move(key)] = std::move(result);
+                    }
+                }
+                return Value(std::move(map));
+            }
+            case BinaryIntKeyDict:
+            {
+                if(!readCount(count)) return Value();
+                ValueMapIntKey map;
+                map.reserve(count);
+                for(uint64_t i = 0; i < count && !failed; i++)
+                {
+                    uint64_t key;
+                    if(!readVarint(key)) break;
+                    Value result = readValue(depth + 1);
+                    if(!result.isNull())
+                    {
+                        map[(int)unzigzag(key)] = std::move(result);
+                    }
+                }
+                return Value(std::move(map));
+            }
+            case BinaryArray:
+            {
+                if(!readCount(count)) return Value();
+                ValueVector vector;
+                vector.reserve(count);
+                for(uint64_t i = 0; i < count && !failed; i++)
+                {
+                    Value result = readValue(depth + 1);
+                    if(!result.isNull())
+                    {
+                        vector.push_back(std::move(result));
+                    }
+                }
+                return Value(std::move(vector));
+            }
+            case BinaryString:
+            {
+                std::string value;
+                if(!readString(value)) return Value();
+                return Value(value);
+            }
+            case BinaryInteger:
+            {
+                uint64_t value;
+                if(!readVarint(value)) return Value();
+                return Value((int)unzigzag(value));
+            }
+            case BinaryReal:
+            {
+                if(end - cursor < 8)
+                {
+                    failed = true;
+                    return Value();
+                }
+                uint64_t bits = 0;
+                for(int i = 0; i < 8; i++)
+                {
+                    bits |= (uint64_t)cursor[i] << (i * 8);
+                }
+                cursor += 8;
+                double real;
+                memcpy(&real, &bits, sizeof(real));
+                return Value(real);
+            }
+            case BinaryTrue:
+                return Value(true);
+            case BinaryFalse:
+                return Value(false);
+            default:
+#if VERBOSE_LOAD_PLIST
+                log("Warning: unrecognized tag %d when loading binary plist, the file is corrupted", tag);
+#endif
+                failed = true;
+                return Value();
+        }
+    }
+    
+    static int64_t unzigzag(uint64_t value)
+    {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+    
+    bool readVarint(uint64_t& value)
+    {
+        value = 0;
+        for(int shift = 0; shift < 64; shift += 7)
+        {
+            if(cursor >= end)
+            {
+                break;
+            }
+            unsigned char byte = *cursor++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        failed = true;
+        return false;
+    }
+    
+    //Each element takes at least one byte: a larger count means the file is corrupted, and it must not be used to reserve memory
+    bool readCount(uint64_t& count)
+    {
+        if(!readVarint(count)) return false;
+        if(count > (uint64_t)(end - cursor))
+        {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+    
+    bool readString(std::string& value)
+    {
+        uint64_t length;
+        if(!readVarint(length)) return false;
+        if(length > (uint64_t)(end - cursor))
+        {
+            failed = true;
+            return false;
+        }
+        value.assign((const char*)cursor, (size_t)length);
+        cursor += length;
+        return true;
+    }
+    
+    const unsigned char* cursor;
+    const unsigned char* end;
+    bool failed;
+};
+
+//Atomically replace destination by source. rename doesn't replace an existing file on Windows
+static bool replaceFile(const std::string& source, const std::string& destination)
+{
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+    return rename(source.c_str(), destination.c_str()) == 0;
+#else
+    return MoveFileExA(source.c_str(), destination.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#endif
+}
+
+static void saveBinaryValueToFile(const Value& val, const std::string& fullPath)
+{
+    //Write to a temporary file first, so that an interrupted save doesn't corrupt the previous one
+    std::string temporaryPath = fullPath + ".tmp";
+    FILE* file = fopen(temporaryPath.c_str(), "wb");
+    if(file == nullptr)
+    {
+#if VERBOSE_WARNING
+        log("Warning: cannot open %s for writing, errno %d", temporaryPath.c_str(), errno);
+#endif
+        return;
+    }
+    BinaryPListWriter writer(file);
+    writer.writeHeader();
+    writer.writeValue(val);
+    //The data must be on disk before the rename, otherwise a crash could leave the new name on an empty file
+    bool failed = ferror(file) != 0 || fflush(file) != 0;
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+    failed = failed || fsync(fileno(file)) != 0;
+#else
+    failed = failed || _commit(_fileno(file)) != 0;
+#endif
+    failed = fclose(file) != 0 || failed;
+    if(failed || !replaceFile(temporaryPath, fullPath))
+    {
+#if VERBOSE_WARNING
+        log("Warning: problem while saving binary plist to %s, errno %d", fullPath.c_str(), errno);
+#endif
+        remove(temporaryPath.c_str());
+    }
+}
+
+//Return true if the file could be mapped and is a binary plist, in which case result is its content (null if it is corrupted)
+//Files which can't be opened directly (inside an apk for example) are left to the FileUtils path
+static bool loadBinaryFile(const std::string& path, Value& result)
+{
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(binaryPListHeader))
+    {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)fileStat.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+    {
+        return false;
+    }
+    bool isBinary = isBinaryPList(data, size);
+    if(isBinary)
+    {
+        result = BinaryPListReader((const unsigned char*)data, size).readDocument();
+    }
+    munmap(data, size);
+    return isBinary;
+#else
+    return false;
+#endif
+}
+
+/**********************************************************************************
+ XML format
+ *********************************************************************************/
+void saveValueToFile(Value& val, std::string fileName, FileLocation location, PListFormat format)
 {
     CCAssert(location != FileLocation::Resources, "Cannot save file to resources, it is read-only");
+    if(format == PListFormat::Binary)
+    {
+        saveBinaryValueToFile(val, getFullPath(fileName, location));
+        return;
+    }
     xml_document doc;
     //add the verbose things so that it's a proper plist like those created by xcode
     xml_node decl = doc.prepend_child(node_declaration);
@@ -245,7 +648,16 @@ Value loadValueFromFile(std::string fileName, FileLocation location)
     log("local path : %s", getLocalPath(fileName).c_str());
 #endif
     std::string path = getFullPath(fileName, location);
+    Value binaryResult;
+    if(loadBinaryFile(path, binaryResult))
+    {
+        return binaryResult;
+    }
     std::string charbuffer = FileUtils::getInstance()->getStringFromFile(path);
+    if(isBinaryPList(charbuffer.data(), charbuffer.size()))
+    {
+        return BinaryPListReader((const unsigned char*)charbuffer.data(), charbuffer.size()).readDocument();
+    }
 #if VERBOSE_LOAD_PLIST
     log("Loading from path :\n%s", path.c_str());
 #endif
@@ -274,4 +686,39 @@ Value loadValueFromFile(std::string fileName, FileLocation location)
 #endif
     return result;
 }
+
+void benchmarkPListPersist(Value& val, int iterations)
+{
+    const std::string files[2] = {"PListPersistBenchmark.plist", "PListPersistBenchmark.bplist"};
+    const PListFormat formats[2] = {PListFormat::XML, PListFormat::Binary};
+    float saveTimes[2];
+    float loadTimes[2];
+    for(int format = 0; format < 2; format++)
+    {
+        timeval startTime;
+        timeval endTime;
+        gettimeofday(&startTime, nullptr);
+        for(int i = 0; i < iterations; i++)
+        {
+            saveValueToFile(val, files[format], FileLocation::Local, formats[format]);
+        }
+        gettimeofday(&endTime, nullptr);
+        saveTimes[format] = getTimeDifferenceMS(startTime, endTime) / iterations;
+        gettimeofday(&startTime, nullptr);
+        for(int i = 0; i < iterations; i++)
+        {
+            loadValueFromFile(files[format], FileLocation::Local);
+        }
+        gettimeofday(&endTime, nullptr);
+        loadTimes[format] = getTimeDifferenceMS(startTime, endTime) / iterations;
+    }
+    log("PListPersist benchmark, average of %d iterations: XML save %f ms, load %f ms (%ld bytes), binary save %f ms, load %f ms (%ld bytes)",
+        iterations,
+        saveTimes[0], loadTimes[0], (long)FileUtils::getInstance()->getFileSize(getFullPath(files[0], FileLocation::Local)),
+        saveTimes[1], loadTimes[1], (long)FileUtils::getInstance()->getFileSize(getFullPath(files[1], FileLocation::Local)));
+    for(const std::string& file : files)
+    {
+        remove(getFullPath(file, FileLocation::Local).c_str());
+    }
+}
 NS_FENNEX_END
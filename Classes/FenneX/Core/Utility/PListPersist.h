@@ -34,10 +34,27 @@ USING_NS_CC;
 //Currently handle Dictionary, Array, Integer, Float, Bool and String in a plist format
 // NOT HANDLED : Date and Data
 
+/* Values can also be saved in a compact binary format, which is much faster to load than XML (no DOM, no text parsing)
+ It is tagged and length-prefixed: a header, then each value is a tag byte followed by its content
+ - dict/intKeydict/array: element count, then key/value pairs (or values)
+ - string: length then bytes, integer: zigzag varint, real: 8 bytes little-endian double, true/false: no content
+ Counts, lengths and keys of intKeydict are varints. Reals are loaded as double, the same way as XML plists
+ loadValueFromFile detects the format, so files can be converted to binary without changing how they are loaded
+ */
+
 NS_FENNEX_BEGIN
 
-void saveValueToFile(Value& val, std::string fileName, FileLocation location = FileLocation::Local);
+enum class PListFormat
+{
+    XML = 0, // Apple plist, readable and compatible with other tools
+    Binary = 1, // FenneX binary format, written in a stream and read using mmap when possible
+};
+
+void saveValueToFile(Value& val, std::string fileName, FileLocation location = FileLocation::Local, PListFormat format = PListFormat::XML);
 Value loadValueFromFile(std::string fileName, FileLocation location = FileLocation::Local);
+
+//Save val in both formats to local temporary files, load them back iterations times and log the average times
+void benchmarkPListPersist(Value& val, int iterations = 10);
 NS_FENNEX_END
 
 #endif /* defined(__FenneX__PListPersist__) */
@@ -0,0 +1,350 @@
+/****************************************************************************
+Copyright (c) 2013-2014 Auticiel SAS
+
+http://www.fennex.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************///
+
+#include "Profiler.h"
+#include "FileUtility.h"
+#include "network/HttpClient.h"
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+NS_FENNEX_BEGIN
+
+#define BUFFER_CAPACITY 8192 //Spans kept per thread
+#define SLOW_FRAME_EXPORT_DELAY 10000000 //Minimum time between two slow frame exports, in microseconds
+
+std::atomic<bool> Profiler::enabled(false);
+
+struct ProfilerSpan
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+/* Single writer ring buffer: the owning thread writes a span, then publishes it by incrementing written.
+ Readers copy the spans, then discard the ones which may have been overwritten during the copy
+ */
+struct ThreadBuffer
+{
+    std::atomic<uint64_t> written;
+    std::atomic<const char*> threadName;
+    int threadId;
+    bool owned; //False once its thread exited: it is kept for the traces until another thread takes it
+    ProfilerSpan spans[BUFFER_CAPACITY];
+};
+
+/* Buffers are only created for threads which record a span, and recycled when their thread exits, so there are at most as many as threads recording at the same time.
+ Locked when a thread records for the first time or exits, and during an export
+ */
+static std::mutex buffersMutex;
+static std::vector<ThreadBuffer*> buffers;
+static int nextThreadId = 1;
+
+//Gives the buffer back when the thread exits
+struct ThreadBufferOwner
+{
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadBufferOwner()
+    {
+        if(buffer != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            buffer->owned = false;
+        }
+    }
+};
+static thread_local ThreadBufferOwner threadBufferOwner;
+//Kept apart from the buffer, so naming a thread doesn't allocate one
+static thread_local const char* currentThreadName = nullptr;
+
+//Frame stages, only used on the cocos thread
+static std::vector<EventListenerCustom*> directorListeners;
+static uint64_t frameStart = 0;
+static uint64_t stageStart = 0;
+static uint64_t drawEnd = 0;
+static bool frameStarted = false;
+static float slowFrameThreshold = 0;
+static uint64_t lastSlowFrameExport = 0;
+
+static ThreadBuffer* getThreadBuffer()
+{
+    ThreadBuffer*& threadBuffer = threadBufferOwner.buffer;
+    if(threadBuffer == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for(ThreadBuffer* buffer : buffers)
+        {
+            if(!buffer->owned)
+            {
+                threadBuffer = buffer;
+                break;
+            }
+        }
+        if(threadBuffer == nullptr)
+        {
+            threadBuffer = new ThreadBuffer();
+            buffers.push_back(threadBuffer);
+        }
+        //Exports hold the mutex, so the previous spans can be dropped safely
+        threadBuffer->written = 0;
+        threadBuffer->threadName = currentThreadName;
+        threadBuffer->threadId = nextThreadId++;
+        threadBuffer->owned = true;
+    }
+    return threadBuffer;
+}
+
+static void beginFrame(uint64_t time)
+{
+    if(!frameStarted)
+    {
+        frameStarted = true;
+        frameStart = time;
+    }
+}
+
+static void endFrame(uint64_t time)
+{
+    frameStarted = false;
+    drawEnd = time;
+    Profiler::record("Frame", frameStart, time);
+    if(slowFrameThreshold > 0 && (time - frameStart) / 1000.f > slowFrameThreshold
+       && (lastSlowFrameExport == 0 || time - lastSlowFrameExport > SLOW_FRAME_EXPORT_DELAY))
+    {
+        lastSlowFrameExport = time;
+        std::string path = getLocalPath("slow_frame_" + std::to_string(Director::getInstance()->getTotalFrames()) + ".json");
+        Profiler::exportChromeTrace(path);
+#if VERBOSE_PERFORMANCE_TIME
+        log("Slow frame: %.2f ms, trace exported to %s", (time - frameStart) / 1000.f, path.c_str());
+#endif
+    }
+}
+
+static void addDirectorListeners()
+{
+    EventDispatcher* dispatcher = Director::getInstance()->getEventDispatcher();
+    auto addListener = [dispatcher](const char* event, const std::function<void(uint64_t)>& onEvent) {
+        EventListenerCustom* listener = dispatcher->addCustomEventListener(event, [onEvent](EventCustom*) { onEvent(Profiler::now()); });
+        listener->retain();
+        directorListeners.push_back(listener);
+    };
+    addListener(Director::EVENT_BEFORE_UPDATE, [](uint64_t time) {
+        beginFrame(time);
+        stageStart = time;
+    });
+    addListener(Director::EVENT_AFTER_UPDATE, [](uint64_t time) {
+        Profiler::record("Scheduler", stageStart, time);
+    });
+    //When the Director is paused, the frame starts with the draw
+    addListener(Director::EVENT_BEFORE_DRAW, [](uint64_t time) {
+        beginFrame(time);
+        stageStart = time;
+    });
+    //The scene visit also renders its commands, the render stage is the notification node and the stats
+    addListener(Director::EVENT_AFTER_VISIT, [](uint64_t time) {
+        Profiler::record("Visit", stageStart, time);
+        stageStart = time;
+    });
+    addListener(Director::EVENT_AFTER_DRAW, [](uint64_t time) {
+        Profiler::record("Render", stageStart, time);
+        endFrame(time);
+    });
+    //Ends right after the swap: the wait for the next frame, like the idle wait when rendering on demand, isn't part of it
+    addListener(Director::EVENT_AFTER_SWAP, [](uint64_t time) {
+        if(drawEnd != 0)
+        {
+            Profiler::record("Swap", drawEnd, time);
+            drawEnd = 0;
+        }
+    });
+}
+
+//Start of the request processed by the current network thread
+static thread_local uint64_t httpRequestStart = 0;
+
+//Set once and never changed afterward, since the network threads read it without synchronization
+static void addHttpClientObserver()
+{
+    static bool added = false;
+    if(!added)
+    {
+        added = true;
+        network::HttpClient::setRequestObserver([](network::HttpRequest* request, bool starting) {
+            if(starting)
+            {
+                Profiler::setThreadName("HttpClient");
+                httpRequestStart = Profiler::isEnabled() ? Profiler::now() : 0;
+            }
+            else if(httpRequestStart != 0 && Profiler::isEnabled())
+            {
+                Profiler::record("HTTP request", httpRequestStart, Profiler::now());
+            }
+        });
+    }
+}
+
+static void removeDirectorListeners()
+{
+    EventDispatcher* dispatcher = Director::getInstance()->getEventDispatcher();
+    for(EventListenerCustom* listener : directorListeners)
+    {
+        dispatcher->removeEventListener(listener);
+        listener->release();
+    }
+    directorListeners.clear();
+    frameStarted = false;
+    drawEnd = 0;
+}
+
+void Profiler::setEnabled(bool enable)
+{
+    if(enable != enabled.load())
+    {
+        enabled = enable;
+        if(enable)
+        {
+            setThreadName("Main");
+            addDirectorListeners();
+            addHttpClientObserver();
+        }
+        else
+        {
+            removeDirectorListeners();
+        }
+    }
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    currentThreadName = name;
+    if(threadBufferOwner.buffer != nullptr)
+    {
+        threadBufferOwner.buffer->threadName = name;
+    }
+}
+
+uint64_t Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    buffer->spans[index % BUFFER_CAPACITY] = {name, start, end};
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::setSlowFrameThreshold(float threshold)
+{
+    slowFrameThreshold = threshold;
+}
+
+//Demangle typeid names and escape the name for JSON
+static const std::string& getSpanName(const char* name, std::unordered_map<const char*, std::string>& names)
+{
+    auto it = names.find(name);
+    if(it != names.end())
+    {
+        return it->second;
+    }
+    std::string readable = name;
+#if defined(__GNUC__) || defined(__clang__)
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if(status == 0 && demangled != nullptr)
+    {
+        readable = demangled;
+    }
+    free(demangled);
+#endif
+    std::string escaped;
+    escaped.reserve(readable.size());
+    for(char c : readable)
+    {
+        if(c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return names[name] = escaped;
+}
+
+bool Profiler::exportChromeTrace(const std::string& path)
+{
+    //Buffers can't be recycled during the export
+    std::unique_lock<std::mutex> lock(buffersMutex);
+    std::vector<ThreadBuffer*> threads = buffers;
+    std::unordered_map<const char*, std::string> names;
+    std::vector<ProfilerSpan> spans;
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+    for(ThreadBuffer* buffer : threads)
+    {
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = written > BUFFER_CAPACITY ? written - BUFFER_CAPACITY : 0;
+        spans.clear();
+        for(uint64_t i = begin; i < written; i++)
+        {
+            spans.push_back(buffer->spans[i % BUFFER_CAPACITY]);
+        }
+        //The owning thread kept recording during the copy: drop the spans which may have been overwritten
+        uint64_t writtenAfter = buffer->written.load(std::memory_order_acquire);
+        uint64_t firstValid = writtenAfter > BUFFER_CAPACITY ? writtenAfter - BUFFER_CAPACITY : 0;
+        
+        const char* threadName = buffer->threadName.load();
+        json += StringUtils::format("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                                    first ? "" : ",", buffer->threadId,
+                                    threadName != nullptr ? getSpanName(threadName, names).c_str() : ("Thread " + std::to_string(buffer->threadId)).c_str());
+        first = false;
+        for(uint64_t i = MAX(begin, firstValid); i < written; i++)
+        {
+            const ProfilerSpan& span = spans[i - begin];
+            json += StringUtils::format(",{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}",
+                                        getSpanName(span.name, names).c_str(), buffer->threadId,
+                                        (unsigned long long)span.start, (unsigned long long)(span.end - span.start));
+        }
+    }
+    json += "]}";
+    lock.unlock();
+    FILE* file = fopen(path.c_str(), "wb");
+    if(file == nullptr)
+    {
+#if VERBOSE_WARNING
+        log("Warning : couldn't write profiler trace to %s", path.c_str());
+#endif
+        return false;
+    }
+    bool success = fwrite(json.data(), 1, json.size(), file) == json.size();
+    fclose(file);
+    return success;
+}
+
+NS_FENNEX_END
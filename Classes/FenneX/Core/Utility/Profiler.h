@@ -0,0 +1,94 @@
+/****************************************************************************
+Copyright (c) 2013-2014 Auticiel SAS
+
+http://www.fennex.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************///
+
+#ifndef __FenneX__Profiler__
+#define __FenneX__Profiler__
+
+#include "cocos2d.h"
+#include "FenneXMacros.h"
+#include <atomic>
+
+//Set to 0 to compile out the profiling scopes
+#ifndef FENNEX_PROFILER
+#define FENNEX_PROFILER 1
+#endif
+
+NS_FENNEX_BEGIN
+/* Frame profiler recording timed spans, exported as Chrome trace JSON (chrome://tracing or ui.perfetto.dev)
+ Spans are recorded with FENNEX_PROFILE_SCOPE(name), for the duration of the current scope. name must have a static storage (string literal, typeid name)
+ since only the pointer is kept. Each thread records in its own ring buffer without locking, which keeps the last few seconds of spans.
+ The frame stages (scheduler, visit, render, swap) are recorded using the Director events, and the requests of the HttpClient threads through its request observer.
+ Disabled by default: when disabled, a scope only costs an atomic load
+ */
+class Profiler
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    
+    //Name of the calling thread in the traces. name must have a static storage
+    static void setThreadName(const char* name);
+    
+    //Monotonic time in microseconds
+    static uint64_t now();
+    static void record(const char* name, uint64_t start, uint64_t end);
+    
+    //Write the spans currently in the buffers. Return false if the file couldn't be written
+    static bool exportChromeTrace(const std::string& path);
+    //When a frame takes more than threshold ms, export the trace in local path as slow_frame_<frame>.json, at most once every 10 seconds. 0 to disable (default)
+    static void setSlowFrameThreshold(float threshold);
+protected:
+    static std::atomic<bool> enabled;
+};
+
+class ProfilerScope
+{
+public:
+    ProfilerScope(const char* scopeName) :
+    name(Profiler::isEnabled() ? scopeName : nullptr),
+    start(name != nullptr ? Profiler::now() : 0)
+    {
+    }
+    ~ProfilerScope()
+    {
+        if(name != nullptr)
+        {
+            Profiler::record(name, start, Profiler::now());
+        }
+    }
+private:
+    const char* name;
+    uint64_t start;
+};
+NS_FENNEX_END
+
+#if FENNEX_PROFILER
+#define FENNEX_PROFILE_CONCAT_(a, b) a##b
+#define FENNEX_PROFILE_CONCAT(a, b) FENNEX_PROFILE_CONCAT_(a, b)
+#define FENNEX_PROFILE_SCOPE(name) FenneX::ProfilerScope FENNEX_PROFILE_CONCAT(profilerScope, __LINE__)(name)
+#else
+#define FENNEX_PROFILE_SCOPE(name)
+#endif
+
+#endif /* defined(__FenneX__Profiler__) */
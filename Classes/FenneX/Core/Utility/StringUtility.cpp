@@ -75,66 +75,155 @@ std::vector<std::pair<std::string, std::string>>* getConversions()
     return result;
 }
 
-std::string upperCase(std::string text)
+/* Case conversion tables, built once from letters_conversion.txt
+ Characters are keyed by their UTF-8 bytes packed in an integer, so that they don't need to be decoded
+ */
+struct CaseConversion
 {
-    //TODO : speed up by sorting the vector and doing a better search
-    std::vector<std::pair<std::string, std::string>>* conversions = getConversions();
-    if(conversions->size() == 0)
+    uint32_t from;
+    uint32_t to;
+    unsigned char toLength;
+    
+    bool operator<(const CaseConversion& other) const
     {
-        log("Warning: missing file letters_conversion.txt, required for upperCase, string %s not converted", text.c_str());
-        return text;
+        return from < other.from;
     }
-    std::string to;
-    for(int i = 0; i < text.length(); i+= utf8_chsize(&text[i]))
+};
+
+struct CaseTable
+{
+    //Conversion of each ASCII character, or -1 when it is converted to a non-ASCII character
+    short ascii[128];
+    //Sorted by from
+    std::vector<CaseConversion> conversions;
+};
+
+static uint32_t packCharacter(const char* source, long length)
+{
+    uint32_t packed = 0;
+    for(long i = 0; i < length; i++)
     {
-        long charLength = utf8_chsize(&text[i]);
-        std::string charString = text.substr(i, charLength);
-        int conversionIndex = 0;
-        while(conversionIndex < conversions->size() && conversions->at(conversionIndex).second != charString)
+        packed = (packed << 8) | (unsigned char)source[i];
+    }
+    return packed;
+}
+
+static CaseTable buildCaseTable(bool toUpper)
+{
+    CaseTable table;
+    for(const std::pair<std::string, std::string>& conversion : *getConversions())
+    {
+        const std::string& from = toUpper ? conversion.second : conversion.first;
+        const std::string& to = toUpper ? conversion.first : conversion.second;
+        if(!from.empty() && from.size() <= 4 && !to.empty() && to.size() <= 4)
         {
-            conversionIndex++;
+            table.conversions.push_back({packCharacter(from.data(), from.size()), packCharacter(to.data(), to.size()), (unsigned char)to.size()});
         }
-        if(conversionIndex < conversions->size())
+    }
+    //Some characters have several conversions: keep the first one of the file, like a linear search would
+    std::stable_sort(table.conversions.begin(), table.conversions.end());
+    table.conversions.erase(std::unique(table.conversions.begin(), table.conversions.end(), [](const CaseConversion& a, const CaseConversion& b) {
+        return a.from == b.from;
+    }), table.conversions.end());
+    for(int c = 0; c < 128; c++)
+    {
+        auto it = std::lower_bound(table.conversions.begin(), table.conversions.end(), CaseConversion{(uint32_t)c, 0, 0});
+        if(it == table.conversions.end() || it->from != (uint32_t)c)
         {
-            to += conversions->at(conversionIndex).first;
+            table.ascii[c] = c;
         }
         else
         {
-            to += charString;
+            table.ascii[c] = it->toLength == 1 && it->to < 128 ? it->to : -1;
         }
     }
-    return to;
+    return table;
 }
 
-std::string lowerCase(std::string text)
+static std::string convertCase(std::string text, const CaseTable& table)
 {
-    //TODO : speed up by sorting the vector and doing a better search
-    std::vector<std::pair<std::string, std::string>>* conversions = getConversions();
-    if(conversions->size() == 0)
+    if(table.conversions.empty())
     {
         log("Warning: missing file letters_conversion.txt, required for upperCase, string %s not converted", text.c_str());
         return text;
     }
-    std::string to;
-    for(int i = 0; i < text.length(); i+= utf8_chsize(&text[i]))
+    //ASCII fast path: convert in place until a character needs the full table
+    size_t i = 0;
+    for(; i < text.size(); i++)
     {
-        long charLength = utf8_chsize(&text[i]);
-        std::string charString = text.substr(i, charLength);
-        int conversionIndex = 0;
-        while(conversionIndex < conversions->size() && conversions->at(conversionIndex).first != charString)
+        unsigned char c = text[i];
+        if(c >= 128 || table.ascii[c] < 0) break;
+        text[i] = (char)table.ascii[c];
+    }
+    if(i == text.size())
+    {
+        return text;
+    }
+    std::string result;
+    result.reserve(text.size() + text.size() / 4);
+    result.append(text, 0, i);
+    while(i < text.size())
+    {
+        unsigned char c = text[i];
+        if(c < 128 && table.ascii[c] >= 0)
         {
-            conversionIndex++;
+            result += (char)table.ascii[c];
+            i++;
+            continue;
         }
-        if(conversionIndex < conversions->size())
+        long length = MIN(utf8_chsize(&text[i]), (long)(text.size() - i));
+        auto it = table.conversions.end();
+        if(length <= 4)
         {
-            to += conversions->at(conversionIndex).second;
+            it = std::lower_bound(table.conversions.begin(), table.conversions.end(), CaseConversion{packCharacter(&text[i], length), 0, 0});
+        }
+        if(it != table.conversions.end() && it->from == packCharacter(&text[i], length))
+        {
+            for(int byte = it->toLength - 1; byte >= 0; byte--)
+            {
+                result += (char)(it->to >> (byte * 8));
+            }
         }
         else
         {
-            to += charString;
+            result.append(text, i, length);
+        }
+        i += length;
+    }
+    return result;
+}
+
+std::string upperCase(std::string text)
+{
+    static const CaseTable table = buildCaseTable(true);
+    return convertCase(std::move(text), table);
+}
+
+std::string lowerCase(std::string text)
+{
+    static const CaseTable table = buildCaseTable(false);
+    return convertCase(std::move(text), table);
+}
+
+void benchmarkCaseConversion(const std::string& text, int iterations)
+{
+    //Build the tables before timing
+    upperCase("");
+    lowerCase("");
+    timeval startTime;
+    timeval endTime;
+    float times[2];
+    for(int method = 0; method < 2; method++)
+    {
+        gettimeofday(&startTime, nullptr);
+        for(int i = 0; i < iterations; i++)
+        {
+            std::string result = method == 0 ? upperCase(text) : lowerCase(text);
         }
+        gettimeofday(&endTime, nullptr);
+        times[method] = getTimeDifferenceMS(startTime, endTime) / iterations;
     }
-    return to;
+    log("Case conversion benchmark for %d bytes, average of %d iterations: upperCase %f ms, lowerCase %f ms", (int)text.size(), iterations, times[0], times[1]);
 }
 
 bool stringStartsWith(std::string str, std::string prefix)
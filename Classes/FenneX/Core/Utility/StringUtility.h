@@ -37,6 +37,8 @@ NS_FENNEX_BEGIN
 //Those methods are UTF-8 aware and require letters_conversion.txt resource to work (add it to project on iOS)
 std::string upperCase(std::string text);
 std::string lowerCase(std::string text);
+//Log the time taken by upperCase and lowerCase for this text
+void benchmarkCaseConversion(const std::string& text, int iterations = 100);
 
 bool stringStartsWith(std::string str, std::string prefix);
 bool stringEndsWith(std::string str, std::string suffix);
@@ -27,6 +27,7 @@ THE SOFTWARE.
 #include "RawObject.h"
 #include "AppMacros.h"
 #include "FenneXMacros.h"
+#include "Profiler.h"
 
 NS_FENNEX_BEGIN
 // singleton stuff
@@ -46,35 +47,78 @@ SynchronousReleaser* SynchronousReleaser::sharedReleaser(void)
 void SynchronousReleaser::init()
 {
     releasePool.reserve(32);
+    releaseIndex = 0;
+    releaseBudget = 0;
+    lastStats = {0, 0, 0};
 }
 
 SynchronousReleaser::~SynchronousReleaser()
 {
+    for(size_t i = releaseIndex; i < releasePool.size(); i++)
+    {
+        releasePool[i]->release();
+    }
     releasePool.clear();
+    pooledObjects.clear();
     s_SharedReleaser = nullptr;
 }
 
 
 void SynchronousReleaser::emptyReleasePool()
 {
-#if VERBOSE_DEALLOC
-    for(Ref* obj : releasePool)
+    FENNEX_PROFILE_SCOPE("SynchronousReleaser::emptyReleasePool");
+    timeval startTime;
+    gettimeofday(&startTime, nullptr);
+    timeval currentTime = startTime;
+    long released = 0;
+    //Use the size at each step: releasing an object may add others to the pool
+    while(releaseIndex < releasePool.size())
     {
+        if(releaseBudget > 0 && released > 0)
+        {
+            gettimeofday(&currentTime, nullptr);
+            if(getTimeDifferenceMS(startTime, currentTime) >= releaseBudget)
+            {
+                break;
+            }
+        }
+        Ref* obj = releasePool[releaseIndex];
+        releaseIndex++;
+#if VERBOSE_DEALLOC
         if(obj->getReferenceCount() != 1)
         {
-            const char* name = isKindOfClass(obj, RawObject) ? ((RawObject*)obj)->getName() : "Unknown";
-            log("!!Warning!! before releasing from ReleasePool, obj %s have retainCount %d", name, obj->getReferenceCount());
+            std::string name = isKindOfClass(obj, RawObject) ? ((RawObject*)obj)->getName() : "Unknown";
+            log("!!Warning!! before releasing from ReleasePool, obj %s have retainCount %d", name.c_str(), obj->getReferenceCount());
         }
+#endif
+        pooledObjects.erase(obj);
+        obj->release();
+        released++;
+    }
+    //Drop the released prefix, even when the budget was exhausted, so that a steady backlog doesn't keep dangling pointers
+    if(releaseIndex > 0)
+    {
+        releasePool.erase(releasePool.begin(), releasePool.begin() + releaseIndex);
+        releaseIndex = 0;
+    }
+    gettimeofday(&currentTime, nullptr);
+    lastStats.released = released;
+    lastStats.remaining = releasePool.size() - releaseIndex;
+    lastStats.time = getTimeDifferenceMS(startTime, currentTime);
+#if VERBOSE_PERFORMANCE_TIME
+    if(released > 0)
+    {
+        log("SynchronousReleaser released %ld objects in %f ms, %ld remaining", lastStats.released, lastStats.time, lastStats.remaining);
     }
 #endif
-    releasePool.clear();
 }
 
 void SynchronousReleaser::addObjectToReleasePool(Ref* obj)
 {
-    if(obj != nullptr && !releasePool.contains(obj))
+    if(obj != nullptr && pooledObjects.insert(obj).second)
     {
-        releasePool.pushBack(obj);
+        obj->retain();
+        releasePool.push_back(obj);
     }
 }
 NS_FENNEX_END
@@ -29,9 +29,12 @@ THE SOFTWARE.
 
 #include "cocos2d.h"
 USING_NS_CC;
+#include <unordered_set>
 
 NS_FENNEX_BEGIN
 //This object is used to ensure some objects are released at a specific time (and not when the auto-release pool wants to do so)
+//By default, the whole pool is released on each emptyReleasePool. With a release budget, objects are released in the order they were added,
+//until the budget is spent, and the rest waits for the next frames. It avoids a hitch when a lot of objects are destroyed at once (scene teardown)
 class SynchronousReleaser
 {
 public:
@@ -40,9 +43,28 @@ public:
     
     void emptyReleasePool();
     void addObjectToReleasePool(Ref* obj);
+    
+    //Time allowed for each emptyReleasePool, in milliseconds. At least one object is released per call. 0 (default) releases everything at once
+    void setReleaseBudget(float milliseconds) { releaseBudget = milliseconds; }
+    float getReleaseBudget() { return releaseBudget; }
+    
+    //Stats of the last emptyReleasePool
+    struct ReleaseStats
+    {
+        long released; //number of objects released
+        long remaining; //number of objects left for the next frames
+        float time; //time spent releasing, in milliseconds
+    };
+    const ReleaseStats& getLastReleaseStats() { return lastStats; }
+    long getPendingCount() { return releasePool.size() - releaseIndex; }
 protected:
     void init();
-    Vector<Ref*> releasePool;
+    //Retained objects, released from releaseIndex
+    std::vector<Ref*> releasePool;
+    size_t releaseIndex;
+    std::unordered_set<Ref*> pooledObjects;
+    float releaseBudget;
+    ReleaseStats lastStats;
 };
 NS_FENNEX_END
 
@@ -26,6 +26,7 @@
 #define FenneX_NativeUtility_h
 
 #include "Shorteners.h"
+#include "TextureBudget.h"
 #include "AppDelegate.h"
 #include "FenneXMacros.h"
 
@@ -164,6 +165,10 @@ static inline void notifyVolumeChanged()
 }
 
 inline void notifyMemoryWarning(){
+	//FenneX caches are only used from the cocos thread
+	cocos2d::Director::getInstance()->getScheduler()->performFunctionInCocosThread([]{
+		TextureBudget::sharedBudget()->purgeCaches();
+	});
 	AppDelegate* delegate = (AppDelegate*)cocos2d::Application::getInstance();
     //warning : maybe this should be async to run on main thread ?
     //No problem so far, converting the #warning to a simple comment
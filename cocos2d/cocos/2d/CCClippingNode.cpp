@@ -34,6 +34,7 @@
 #include "base/CCDirector.h"
 #include "base/CCStencilStateManager.h"
 #include "2d/CCDrawNode.h"
+#include "2d/CCCamera.h"
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32 || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
 #define CC_CLIPPING_NODE_OPENGLES 0
@@ -43,6 +44,31 @@
 
 NS_CC_BEGIN
 
+//World rectangle covered by size if transform has no rotation, skew or depth
+static bool getAxisAlignedRect(const Mat4& transform, const Size& size, Rect& rect)
+{
+    const float* m = transform.m;
+    if(m[1] != 0 || m[2] != 0 || m[3] != 0 || m[4] != 0 || m[6] != 0 || m[7] != 0 || m[14] != 0)
+    {
+        return false;
+    }
+    float x1 = m[12];
+    float x2 = m[0] * size.width + m[12];
+    float y1 = m[13];
+    float y2 = m[5] * size.height + m[13];
+    rect.setRect(MIN(x1, x2), MIN(y1, y2), fabsf(x2 - x1), fabsf(y2 - y1));
+    return true;
+}
+
+static Rect intersectRects(const Rect& rect1, const Rect& rect2)
+{
+    float minX = MAX(rect1.getMinX(), rect2.getMinX());
+    float minY = MAX(rect1.getMinY(), rect2.getMinY());
+    float maxX = MIN(rect1.getMaxX(), rect2.getMaxX());
+    float maxY = MIN(rect1.getMaxY(), rect2.getMaxY());
+    return Rect(minX, minY, MAX(0, maxX - minX), MAX(0, maxY - minY));
+}
+
 #if CC_CLIPPING_NODE_OPENGLES
 static void setProgram(Node *n, GLProgram *p)
 {
@@ -205,6 +231,16 @@ void ClippingNode::visit(Renderer *renderer, const Mat4 &parentTransform, uint32
     director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
     director->loadMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, _modelViewTransform);
 
+    //The scissor is in screen points: only use it when drawing with the default camera projection (not in a RenderTexture).
+    //The rectangle is the one drawn by setSquareStencil, through the stencil transform, so that it matches what the stencil would clip
+    Camera* defaultCamera = Camera::getDefaultCamera();
+    bool useScissor = _scissorEnabled && isSquareStencil && !isInverted()
+        && _stencil != nullptr && _stencil->isVisible()
+        && (Camera::getVisitingCamera() == nullptr || Camera::getVisitingCamera() == defaultCamera)
+        && defaultCamera != nullptr
+        && memcmp(director->getMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION).m, defaultCamera->getViewProjectionMatrix().m, sizeof(Mat4)) == 0
+        && getAxisAlignedRect(_modelViewTransform * _stencil->getNodeToParentTransform(), _squareStencilSize, _scissorRect);
+    
     //Add group command
         
     _groupCommand.init(_globalZOrder);
@@ -213,31 +249,39 @@ void ClippingNode::visit(Renderer *renderer, const Mat4 &parentTransform, uint32
     renderer->pushGroup(_groupCommand.getRenderQueueID());
 
     _beforeVisitCmd.init(_globalZOrder);
-    _beforeVisitCmd.func = CC_CALLBACK_0(StencilStateManager::onBeforeVisit, _stencilStateManager);
-    renderer->addCommand(&_beforeVisitCmd);
-    
-    auto alphaThreshold = this->getAlphaThreshold();
-    if (alphaThreshold < 1)
+    if (useScissor)
     {
+        _beforeVisitCmd.func = CC_CALLBACK_0(ClippingNode::onBeforeVisitScissor, this);
+        renderer->addCommand(&_beforeVisitCmd);
+    }
+    else
+    {
+        _beforeVisitCmd.func = CC_CALLBACK_0(StencilStateManager::onBeforeVisit, _stencilStateManager);
+        renderer->addCommand(&_beforeVisitCmd);
+    
+        auto alphaThreshold = this->getAlphaThreshold();
+        if (alphaThreshold < 1)
+        {
 #if CC_CLIPPING_NODE_OPENGLES
-        // since glAlphaTest do not exists in OES, use a shader that writes
-        // pixel only if greater than an alpha threshold
-        GLProgram *program = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_NAME_POSITION_TEXTURE_ALPHA_TEST_NO_MV);
-        GLint alphaValueLocation = glGetUniformLocation(program->getProgram(), GLProgram::UNIFORM_NAME_ALPHA_TEST_VALUE);
-        // set our alphaThreshold
-        program->use();
-        program->setUniformLocationWith1f(alphaValueLocation, alphaThreshold);
-        // we need to recursively apply this shader to all the nodes in the stencil node
-        // FIXME: we should have a way to apply shader to all nodes without having to do this
-        setProgram(_stencil, program);
+            // since glAlphaTest do not exists in OES, use a shader that writes
+            // pixel only if greater than an alpha threshold
+            GLProgram *program = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_NAME_POSITION_TEXTURE_ALPHA_TEST_NO_MV);
+            GLint alphaValueLocation = glGetUniformLocation(program->getProgram(), GLProgram::UNIFORM_NAME_ALPHA_TEST_VALUE);
+            // set our alphaThreshold
+            program->use();
+            program->setUniformLocationWith1f(alphaValueLocation, alphaThreshold);
+            // we need to recursively apply this shader to all the nodes in the stencil node
+            // FIXME: we should have a way to apply shader to all nodes without having to do this
+            setProgram(_stencil, program);
 #endif
 
-    }
-    _stencil->visit(renderer, _modelViewTransform, flags);
+        }
+        _stencil->visit(renderer, _modelViewTransform, flags);
 
-    _afterDrawStencilCmd.init(_globalZOrder);
-    _afterDrawStencilCmd.func = CC_CALLBACK_0(StencilStateManager::onAfterDrawStencil, _stencilStateManager);
-    renderer->addCommand(&_afterDrawStencilCmd);
+        _afterDrawStencilCmd.init(_globalZOrder);
+        _afterDrawStencilCmd.func = CC_CALLBACK_0(StencilStateManager::onAfterDrawStencil, _stencilStateManager);
+        renderer->addCommand(&_afterDrawStencilCmd);
+    }
 
     int i = 0;
     bool visibleByCamera = isVisitableByVisitingCamera();
@@ -268,7 +312,10 @@ void ClippingNode::visit(Renderer *renderer, const Mat4 &parentTransform, uint32
     }
 
     _afterVisitCmd.init(_globalZOrder);
-    _afterVisitCmd.func = CC_CALLBACK_0(StencilStateManager::onAfterVisit, _stencilStateManager);
+    if (useScissor)
+        _afterVisitCmd.func = CC_CALLBACK_0(ClippingNode::onAfterVisitScissor, this);
+    else
+        _afterVisitCmd.func = CC_CALLBACK_0(StencilStateManager::onAfterVisit, _stencilStateManager);
     renderer->addCommand(&_afterVisitCmd);
 
     renderer->popGroup();
@@ -276,6 +323,55 @@ void ClippingNode::visit(Renderer *renderer, const Mat4 &parentTransform, uint32
     director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
 }
 
+void ClippingNode::onBeforeVisitScissor()
+{
+    auto glview = Director::getInstance()->getOpenGLView();
+    Rect rect = _scissorRect;
+    //Intersect with the scissor currently set, whether it comes from another ClippingNode or from ui::Layout
+    _scissorOldState = glview->isScissorEnabled();
+    if (_scissorOldState)
+    {
+        _scissorOldRect = glview->getScissorRect();
+        rect = intersectRects(rect, _scissorOldRect);
+    }
+    else
+    {
+        glEnable(GL_SCISSOR_TEST);
+    }
+    glview->setScissorInPoints(rect.origin.x, rect.origin.y, rect.size.width, rect.size.height);
+}
+
+void ClippingNode::onAfterVisitScissor()
+{
+    if (_scissorOldState)
+    {
+        Director::getInstance()->getOpenGLView()->setScissorInPoints(_scissorOldRect.origin.x, _scissorOldRect.origin.y, _scissorOldRect.size.width, _scissorOldRect.size.height);
+    }
+    else
+    {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+void ClippingNode::setScissorEnabled(bool enabled)
+{
+    _scissorEnabled = enabled;
+}
+
+bool ClippingNode::isScissorEnabled() const
+{
+    return _scissorEnabled;
+}
+
+bool ClippingNode::getWorldClippingRect(Rect& rect)
+{
+    if (isSquareStencil && _stencil != nullptr)
+    {
+        return getAxisAlignedRect(getNodeToWorldTransform() * _stencil->getNodeToParentTransform(), _squareStencilSize, rect);
+    }
+    return getAxisAlignedRect(getNodeToWorldTransform(), _contentSize, rect);
+}
+
 void ClippingNode::setCameraMask(unsigned short mask, bool applyChildren)
 {
     Node::setCameraMask(mask, applyChildren);
@@ -295,6 +391,9 @@ void ClippingNode::setStencil(Node *stencil)
     if (_stencil == stencil)
         return;
     
+    // CUSTOM: a stencil set from outside is no longer the rectangle of setSquareStencil
+    isSquareStencil = false;
+    
 #if CC_ENABLE_GC_FOR_NATIVE_OBJECTS
     auto sEngine = ScriptEngineManager::getInstance()->getScriptEngine();
     if (sEngine)
@@ -366,12 +465,13 @@ void ClippingNode::setInverted(bool inverted)
 
 void ClippingNode::setSquareStencil()
 {
-    isSquareStencil = true;
     if(getStencil() == nullptr || dynamic_cast<DrawNode*>(getStencil()) == nullptr)
     {
         setStencil(DrawNode::create());
         //addChild(getStencil()); //If you need to see what the stencil is like, for debug purpose
     }
+    isSquareStencil = true;
+    _squareStencilSize = this->getContentSize();
     DrawNode* stencil = (DrawNode*)getStencil();
     stencil->clear();
     Vec2 rectangle[4];
@@ -147,6 +147,21 @@ public:
      */
     virtual void updateTweenAction(float value, const std::string& key) override;
     
+    /* CUSTOM METHOD
+     when enabled, a square stencil is replaced by a scissor test as long as the node and its stencil are drawn axis-aligned
+     (no rotation or skew) by the default camera and the node isn't inverted, which avoids the stencil clear and draw.
+     The scissor intersects with the one already set (nested ClippingNode or ui::Layout).
+     The stencil is still used in the other cases. Disabled by default
+     */
+    void setScissorEnabled(bool enabled);
+    bool isScissorEnabled() const;
+    
+    /* CUSTOM METHOD
+     compute the rectangle covered by the square stencil (or the content size if there is none) in world coordinates, as used by the scissor
+     @return false if the node to world transform is not axis-aligned, in which case rect is not changed
+     */
+    bool getWorldClippingRect(Rect& rect);
+    
 CC_CONSTRUCTOR_ACCESS:
     ClippingNode();
     
@@ -177,6 +192,17 @@ protected:
     CustomCommand _afterVisitCmd;
 
     bool isSquareStencil = false;
+    
+    void onBeforeVisitScissor();
+    void onAfterVisitScissor();
+    
+    bool _scissorEnabled = false;
+    Rect _scissorRect;
+    //Content size when setSquareStencil was last called, which is the size of the stencil rectangle
+    Size _squareStencilSize;
+    //Scissor state before this node, restored after its children
+    bool _scissorOldState = false;
+    Rect _scissorOldRect;
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(ClippingNode);
 };
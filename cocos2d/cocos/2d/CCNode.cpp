@@ -81,6 +81,7 @@ Node::Node()
 , _additionalTransform(nullptr)
 , _additionalTransformDirty(false)
 , _transformUpdated(true)
+, _transformVersion(0)
 // children (lazy allocs)
 // lazy alloc
 , _localZOrderAndArrival(0)
@@ -243,6 +244,7 @@ void Node::setSkewX(float skewX)
     
     _skewX = skewX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 float Node::getSkewY() const
@@ -257,6 +259,7 @@ void Node::setSkewY(float skewY)
     
     _skewY = skewY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 void Node::setLocalZOrder(int z)
@@ -310,6 +313,7 @@ void Node::setRotation(float rotation)
     
     _rotationZ_X = _rotationZ_Y = rotation;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
     
     updateRotationQuat();
 }
@@ -327,6 +331,7 @@ void Node::setRotation3D(const Vec3& rotation)
         return;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 
     _rotationX = rotation.x;
     _rotationY = rotation.y;
@@ -378,6 +383,7 @@ void Node::setRotationQuat(const Quaternion& quat)
     _rotationQuat = quat;
     updateRotation3D();
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 Quaternion Node::getRotationQuat() const
@@ -392,6 +398,7 @@ void Node::setRotationSkewX(float rotationX)
     
     _rotationZ_X = rotationX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
     
     updateRotationQuat();
 }
@@ -408,6 +415,7 @@ void Node::setRotationSkewY(float rotationY)
     
     _rotationZ_Y = rotationY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
     
     updateRotationQuat();
 }
@@ -427,6 +435,7 @@ void Node::setScale(float scale)
     
     _scaleX = _scaleY = _scaleZ = scale;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 /// scaleX getter
@@ -444,6 +453,7 @@ void Node::setScale(float scaleX,float scaleY)
     _scaleX = scaleX;
     _scaleY = scaleY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 /// scaleX setter
@@ -454,6 +464,7 @@ void Node::setScaleX(float scaleX)
     
     _scaleX = scaleX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 /// scaleY getter
@@ -470,6 +481,7 @@ void Node::setScaleZ(float scaleZ)
     
     _scaleZ = scaleZ;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 /// scaleY getter
@@ -486,6 +498,7 @@ void Node::setScaleY(float scaleY)
     
     _scaleY = scaleY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 
@@ -516,6 +529,7 @@ void Node::setPosition(float x, float y)
     _position.y = y;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
     _usingNormalizedPosition = false;
 }
 
@@ -561,6 +575,7 @@ void Node::setPositionZ(float positionZ)
         return;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 
     _positionZ = positionZ;
 }
@@ -581,6 +596,7 @@ void Node::setPositionNormalized(const Vec2& position)
     _usingNormalizedPosition = true;
     _normalizedPositionDirty = true;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 ssize_t Node::getChildrenCount() const
@@ -600,6 +616,8 @@ void Node::setVisible(bool visible)
     if(visible != _visible)
     {
         _visible = visible;
+        // CUSTOM: hiding a node changes its version too
+        _transformVersion++;
         if(_visible)
             _transformUpdated = _transformDirty = _inverseDirty = true;
     }
@@ -623,6 +641,7 @@ void Node::setAnchorPoint(const Vec2& point)
         _anchorPoint = point;
         _anchorPointInPoints.set(_contentSize.width * _anchorPoint.x, _contentSize.height * _anchorPoint.y);
         _transformUpdated = _transformDirty = _inverseDirty = true;
+        _transformVersion++;
     }
 }
 
@@ -640,6 +659,7 @@ void Node::setContentSize(const Size & size)
 
         _anchorPointInPoints.set(_contentSize.width * _anchorPoint.x, _contentSize.height * _anchorPoint.y);
         _transformUpdated = _transformDirty = _inverseDirty = _contentSizeDirty = true;
+        _transformVersion++;
     }
 }
 
@@ -654,6 +674,7 @@ void Node::setParent(Node * parent)
 {
     _parent = parent;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    _transformVersion++;
 }
 
 /// isRelativeAnchorPoint getter
@@ -669,6 +690,7 @@ void Node::setIgnoreAnchorPointForPosition(bool newValue)
     {
         _ignoreAnchorPointForPosition = newValue;
         _transformUpdated = _transformDirty = _inverseDirty = true;
+        _transformVersion++;
     }
 }
 
@@ -1207,6 +1229,7 @@ uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFl
             _position.x = _normalizedPosition.x * s.width;
             _position.y = _normalizedPosition.y * s.height;
             _transformUpdated = _transformDirty = _inverseDirty = true;
+            _transformVersion++;
             _normalizedPositionDirty = false;
         }
     }
@@ -1224,6 +1247,10 @@ uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFl
     if(flags & FLAGS_DIRTY_MASK)
         _modelViewTransform = this->transform(parentTransform);
     
+    // CUSTOM: lets Director render on demand know that the scene is still changing
+    if(_transformUpdated || _contentSizeDirty)
+        _director->markSceneChanged();
+    
     _transformUpdated = false;
     _contentSizeDirty = false;
 
@@ -581,6 +581,12 @@ public:
      */
     virtual bool isVisible() const;
 
+    /* CUSTOM METHOD
+     Incremented each time the position, scale, rotation, skew, anchor point, content size, visibility or parent of the node changes,
+     so that a change can be detected without comparing all the properties
+     */
+    unsigned int getTransformVersion() const { return _transformVersion; }
+
 
     /**
      * Sets the rotation (angle) of the node in degrees.
@@ -1939,6 +1945,7 @@ protected:
     mutable Mat4* _additionalTransform; ///< two transforms needed by additional transforms
     mutable bool _additionalTransformDirty; ///< transform dirty ?
     bool _transformUpdated;         ///< Whether or not the Transform object was updated since the last frame
+    unsigned int _transformVersion; ///< CUSTOM: see getTransformVersion
 
     std::int64_t _localZOrderAndArrival; /// cache, for 64bits compress optimize.
     int _localZOrder; /// < Local order (relative to its siblings) used to sort the node
@@ -99,6 +99,7 @@ const char *Director::EVENT_BEFORE_UPDATE = "director_before_update";
 const char *Director::EVENT_AFTER_UPDATE = "director_after_update";
 const char *Director::EVENT_RESET = "director_reset";
 const char *Director::EVENT_BEFORE_DRAW = "director_before_draw";
+const char *Director::EVENT_AFTER_SWAP = "director_after_swap"; // CUSTOM
 
 Director* Director::getInstance()
 {
@@ -144,6 +145,13 @@ bool Director::init(void)
     // paused ?
     _paused = false;
 
+    // render on demand ?
+    _renderOnDemand = false;
+    _redrawRequested = true;
+    _hasNextRedrawTime = false;
+    _renderIdle = false;
+    _sceneChanged = false;
+
     // purge ?
     _purgeDirectorInNextLoop = false;
     
@@ -178,6 +186,8 @@ bool Director::init(void)
     _eventAfterDraw->setUserData(this);
     _eventBeforeDraw = new (std::nothrow) EventCustom(EVENT_BEFORE_DRAW);
     _eventBeforeDraw->setUserData(this);
+    _eventAfterSwap = new (std::nothrow) EventCustom(EVENT_AFTER_SWAP); // CUSTOM
+    _eventAfterSwap->setUserData(this);
     _eventAfterVisit = new (std::nothrow) EventCustom(EVENT_AFTER_VISIT);
     _eventAfterVisit->setUserData(this);
     _eventBeforeUpdate = new (std::nothrow) EventCustom(EVENT_BEFORE_UPDATE);
@@ -221,6 +231,7 @@ Director::~Director(void)
     CC_SAFE_RELEASE(_eventAfterUpdate);
     CC_SAFE_RELEASE(_eventAfterDraw);
     CC_SAFE_RELEASE(_eventBeforeDraw);
+    CC_SAFE_RELEASE(_eventAfterSwap); // CUSTOM
     CC_SAFE_RELEASE(_eventAfterVisit);
     CC_SAFE_RELEASE(_eventProjectionChanged);
     CC_SAFE_RELEASE(_eventResetDirector);
@@ -352,11 +363,20 @@ void Director::drawScene()
 
     _totalFrames++;
 
+    // keep drawing while something is moving
+    if (_renderOnDemand && (_sceneChanged || _nextScene != nullptr || _actionManager->getNumberOfRunningActions() > 0))
+    {
+        _redrawRequested = true;
+    }
+    _sceneChanged = false;
+
     // swap buffers
     if (_openGLView)
     {
         _openGLView->swapBuffers();
     }
+    // CUSTOM: lets profilers tell the swap apart from the wait for the next frame
+    _eventDispatcher->dispatchEvent(_eventAfterSwap);
 
     if (_displayStats)
     {
@@ -385,6 +405,13 @@ void Director::calculateDeltaTime()
         }
         _deltaTime = MAX(0, _deltaTime);
     }
+    
+    // CUSTOM: when rendering on demand, the time spent idle isn't given to the first frame drawn afterwards
+    if (_renderIdle)
+    {
+        _deltaTime = MIN(_deltaTime, _animationInterval);
+        _renderIdle = false;
+    }
 
 #if COCOS2D_DEBUG
     // If we are debugging our code, prevent big delta time
@@ -1507,7 +1534,26 @@ void Director::mainLoop()
     }
     else if (! _invalid)
     {
-        drawScene();
+        bool draw = true;
+        if (_renderOnDemand)
+        {
+            bool deadlineReached = _hasNextRedrawTime && std::chrono::steady_clock::now() >= _nextRedrawTime;
+            if (deadlineReached)
+            {
+                _hasNextRedrawTime = false;
+            }
+            draw = _redrawRequested.exchange(false) || deadlineReached;
+        }
+        if (draw)
+        {
+            drawScene();
+        }
+        if (_renderOnDemand && !_redrawRequested && !_hasNextRedrawTime)
+        {
+            // Nothing pending: the run loop waits for an event before the next frame.
+            // Waits for a deadline are not idle, the time until the deadline is given to the next frame
+            _renderIdle = true;
+        }
      
         // release the objects
         PoolManager::getInstance()->getCurrentPool()->clear();
@@ -1521,6 +1567,52 @@ void Director::mainLoop(float dt)
     mainLoop();
 }
 
+void Director::setRenderOnDemand(bool renderOnDemand)
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    _renderOnDemand = renderOnDemand;
+#else
+    CCLOG("Director: render on demand is only supported on desktop platforms");
+#endif
+    requestRedraw();
+}
+
+void Director::requestRedraw(float delay)
+{
+    if (delay <= 0)
+    {
+        _redrawRequested = true;
+        if (_renderOnDemand && _openGLView != nullptr)
+        {
+            _openGLView->wakeUp();
+        }
+    }
+    else
+    {
+        CCASSERT(_cocos2d_thread_id == std::thread::id() || _cocos2d_thread_id == std::this_thread::get_id(), "Director::requestRedraw with a delay must be called on the cocos thread");
+        auto redrawTime = std::chrono::steady_clock::now() + std::chrono::microseconds((long long)(delay * 1000000));
+        if (!_hasNextRedrawTime || redrawTime < _nextRedrawTime)
+        {
+            _nextRedrawTime = redrawTime;
+            _hasNextRedrawTime = true;
+        }
+    }
+}
+
+float Director::getTimeUntilRedraw() const
+{
+    if (!_renderOnDemand || _redrawRequested)
+    {
+        return 0;
+    }
+    if (!_hasNextRedrawTime)
+    {
+        return -1;
+    }
+    float delay = std::chrono::duration_cast<std::chrono::microseconds>(_nextRedrawTime - std::chrono::steady_clock::now()).count() / 1000000.0f;
+    return MAX(0, delay);
+}
+
 void Director::stopAnimation()
 {
     _invalid = true;
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include <stack>
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 #include "platform/CCPlatformMacros.h"
 #include "base/CCRef.h"
@@ -116,6 +117,8 @@ public:
     static const char* EVENT_AFTER_DRAW;
     /** Director will trigger an event before a scene is drawn, right after clear. */
     static const char* EVENT_BEFORE_DRAW;
+    /* CUSTOM: Director will trigger an event once the buffers of a drawn scene are swapped, before waiting for the next frame. */
+    static const char* EVENT_AFTER_SWAP;
 
     /**
      * @brief Possible OpenGL projections used by director
@@ -401,6 +404,35 @@ public:
      */
     void mainLoop(float dt);
 
+    /* CUSTOM METHOD
+     On-demand rendering: when enabled, mainLoop skips the whole frame (update, visit, render and swap) while nothing requested a redraw.
+     Redraws are requested by input events (from the GLFW input callbacks), window resizes, running actions, nodes whose transform or content size changed during the last frame,
+     callbacks given to Scheduler::performFunctionInCocosThread, and explicit requestRedraw calls (for example from an update which
+     needs to run every frame, or for a deadline). Only supported on desktop platforms (Linux, mac and win32 run loops wait for events), other platforms always present the frame.
+     Time doesn't advance while idle: the first frame drawn after waiting for an event with no redraw deadline gets a delta time of at most one animation interval.
+     Waiting for a deadline (requestRedraw with a delay) counts in the delta time, so delayed events fire on time.
+     Disabled by default
+     */
+    void setRenderOnDemand(bool renderOnDemand);
+    bool isRenderOnDemand() const { return _renderOnDemand; }
+    
+    /* CUSTOM METHOD
+     Request a frame to be drawn in delay seconds (0 for the next loop iteration) when rendering on demand.
+     An immediate request is thread safe and wakes up the run loop, a delayed one must be done on the cocos thread (asserted)
+     */
+    void requestRedraw(float delay = 0);
+    
+    /* CUSTOM METHOD
+     Time in seconds before the next frame needs to be drawn: 0 when a redraw is pending, -1 if nothing is scheduled (wait for an input event).
+     Always 0 when not rendering on demand
+     */
+    float getTimeUntilRedraw() const;
+    
+    /* CUSTOM METHOD
+     Called by nodes whose transform or content size changed while visited, so that the following frame is drawn too
+     */
+    void markSceneChanged() { _sceneChanged = true; }
+
     /** The size in pixels of the surface. It could be different than the screen size.
      * High-res devices might have a higher surface size than the screen size.
      * Only available when compiled using SDK >= 4.0.
@@ -633,6 +665,7 @@ protected:
      */
     EventDispatcher* _eventDispatcher;
     EventCustom *_eventProjectionChanged, *_eventBeforeDraw, *_eventAfterDraw, *_eventAfterVisit, *_eventBeforeUpdate, *_eventAfterUpdate, *_eventResetDirector, *_beforeSetNextScene, *_afterSetNextScene;
+    EventCustom *_eventAfterSwap; // CUSTOM
         
     /* delta time since last tick to main loop */
 	float _deltaTime;
@@ -688,6 +721,16 @@ protected:
     /* whether or not the next delta time will be zero */
     bool _nextDeltaTimeZero;
     
+    /* on-demand rendering state, see setRenderOnDemand */
+    //Read by requestRedraw, which may be called from any thread
+    std::atomic<bool> _renderOnDemand;
+    std::atomic<bool> _redrawRequested;
+    //Only used on the cocos thread
+    std::chrono::steady_clock::time_point _nextRedrawTime;
+    bool _hasNextRedrawTime;
+    bool _renderIdle;
+    bool _sceneChanged;
+    
     /* projection used */
     Projection _projection;
 
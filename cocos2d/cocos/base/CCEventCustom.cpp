@@ -31,9 +31,24 @@ EventCustom::EventCustom(const std::string& eventName)
 : Event(Type::CUSTOM)
 , _userData(nullptr)
 , _eventName(eventName)
+, _eventID(-1)
+, _registeredName(nullptr)
 {
 }
 
+EventCustom::EventCustom(int eventID, const std::string& eventName)
+: Event(Type::CUSTOM)
+, _userData(nullptr)
+, _eventID(eventID)
+, _registeredName(&eventName)
+{
+}
+
+const std::string& EventCustom::getEventName() const
+{
+    return _registeredName != nullptr ? *_registeredName : _eventName;
+}
+
 EventCustom* EventCustom::create(const std::string& eventName, void* data)
 {
     EventCustom* event = new EventCustom(eventName);
@@ -48,6 +48,12 @@ public:
      */
     EventCustom(const std::string& eventName);
     
+    /* CUSTOM METHOD
+     * Constructor from an ID returned by EventDispatcher::getCustomEventID and its registered name: does not copy the name,
+     * which must outlive the event (EventDispatcher::getCustomEventName does).
+     */
+    EventCustom(int eventID, const std::string& eventName);
+    
     /** CUSTOM create */
     static EventCustom* create(const std::string& eventName = "", void* data = NULL);
 
@@ -67,10 +73,17 @@ public:
      *
      * @return The name of the event.
      */
-    const std::string& getEventName() const { return _eventName; }
+    const std::string& getEventName() const;
+    
+    /* CUSTOM METHOD
+     * Gets the registered event ID, or -1 if the event was created from a name.
+     */
+    int getEventID() const { return _eventID; }
 protected:
     void* _userData;       ///< User data
     std::string _eventName;
+    int _eventID;
+    const std::string* _registeredName; ///< CUSTOM: name of an event created from an ID, owned by the EventDispatcher
 };
 
 NS_CC_END
@@ -23,6 +23,7 @@
  ****************************************************************************/
 #include "base/CCEventDispatcher.h"
 #include <algorithm>
+#include <chrono>
 
 #include "base/CCEventCustom.h"
 #include "base/CCEventListenerTouch.h"
@@ -202,6 +203,8 @@ EventDispatcher::EventDispatcher()
 : _inDispatch(0)
 , _isEnabled(false)
 , _nodePriorityIndex(0)
+, _hasEmptyListeners(false)
+, _threadID(std::this_thread::get_id())
 {
     _toAddedListeners.reserve(50);
     _toRemovedListeners.reserve(50);
@@ -595,11 +598,23 @@ void EventDispatcher::addEventListenerWithFixedPriority(EventListener* listener,
 
 EventListenerCustom* EventDispatcher::addCustomEventListener(const std::string &eventName, const std::function<void(EventCustom*)>& callback)
 {
+    // CUSTOM: register the name, so that dispatching it by name goes through its ID. IDs are only used on the dispatcher thread
+    if (isDispatcherThread())
+    {
+        return addCustomEventListener(getCustomEventID(eventName), callback);
+    }
     EventListenerCustom *listener = EventListenerCustom::create(eventName, callback);
     addEventListenerWithFixedPriority(listener, 1);
     return listener;
 }
 
+EventListenerCustom* EventDispatcher::addCustomEventListener(int eventID, const std::function<void(EventCustom*)>& callback)
+{
+    EventListenerCustom *listener = EventListenerCustom::create(getCustomEventName(eventID), callback);
+    addEventListenerWithFixedPriority(listener, 1);
+    return listener;
+}
+
 void EventDispatcher::removeEventListener(EventListener* listener)
 {
     if (listener == nullptr)
@@ -683,6 +698,7 @@ void EventDispatcher::removeEventListener(EventListener* listener)
             auto list = iter->second;
             iter = _listenerMap.erase(iter);
             CC_SAFE_DELETE(list);
+            invalidateCustomListeners();
         }
         else
         {
@@ -904,7 +920,6 @@ void EventDispatcher::dispatchEvent(Event* event)
     
     updateDirtyFlagForSceneGraph();
     
-    
     DispatchGuard guard(_inDispatch);
     
     if (event->getType() == Event::Type::TOUCH)
@@ -940,11 +955,164 @@ void EventDispatcher::dispatchEvent(Event* event)
 
 void EventDispatcher::dispatchCustomEvent(const std::string &eventName, void *optionalUserData)
 {
+    // CUSTOM: go through the ID if the name is registered, without registering names that nobody listens to.
+    // IDs are only used on the dispatcher thread, other threads keep dispatching by name
+    if (isDispatcherThread())
+    {
+        auto iter = _customEventIDs.find(eventName);
+        if (iter != _customEventIDs.end())
+        {
+            dispatchCustomEvent(iter->second, optionalUserData);
+            return;
+        }
+    }
+    
     EventCustom ev(eventName);
     ev.setUserData(optionalUserData);
     dispatchEvent(&ev);
 }
 
+void EventDispatcher::dispatchCustomEvent(int eventID, void *optionalUserData)
+{
+    if (!_isEnabled)
+        return;
+    
+    updateDirtyFlagForSceneGraph();
+    
+    DispatchGuard guard(_inDispatch);
+    
+    EventCustom ev(eventID, getCustomEventName(eventID));
+    ev.setUserData(optionalUserData);
+    
+    auto listeners = getCustomListeners(eventID);
+    if (listeners != nullptr)
+    {
+        // Only captures a pointer, so the std::function does not allocate
+        EventCustom* event = &ev;
+        auto onEvent = [event](EventListener* listener) -> bool{
+            event->setCurrentTarget(listener->getAssociatedNode());
+            listener->_onEvent(event);
+            return event->isStopped();
+        };
+        
+        dispatchEventToListeners(listeners, onEvent);
+    }
+    
+    updateListeners(&ev);
+}
+
+int EventDispatcher::getCustomEventID(const std::string& eventName)
+{
+    CCASSERT(isDispatcherThread(), "Custom event IDs must only be used on the thread which created the dispatcher");
+    auto iter = _customEventIDs.find(eventName);
+    if (iter != _customEventIDs.end())
+    {
+        return iter->second;
+    }
+    int eventID = (int)_customEventNames.size();
+    _customEventNames.push_back(eventName);
+    _customEventIDs.emplace(eventName, eventID);
+    return eventID;
+}
+
+int EventDispatcher::findCustomEventID(const std::string& eventName) const
+{
+    CCASSERT(isDispatcherThread(), "Custom event IDs must only be used on the thread which created the dispatcher");
+    auto iter = _customEventIDs.find(eventName);
+    return iter != _customEventIDs.end() ? iter->second : -1;
+}
+
+const std::string& EventDispatcher::getCustomEventName(int eventID) const
+{
+    CCASSERT(eventID >= 0 && eventID < (int)_customEventNames.size(), "Invalid custom event ID");
+    return _customEventNames[eventID];
+}
+
+bool EventDispatcher::isDispatcherThread() const
+{
+    return std::this_thread::get_id() == _threadID;
+}
+
+EventDispatcher::EventListenerVector* EventDispatcher::getCustomListeners(int eventID)
+{
+    if (eventID >= (int)_customListeners.size())
+    {
+        _customListeners.resize(_customEventNames.size(), {nullptr, true});
+    }
+    
+    CustomListenersEntry& entry = _customListeners[eventID];
+    const std::string& eventName = getCustomEventName(eventID);
+    if (entry.listeners == nullptr)
+    {
+        // Absent IDs are not cached, a listener may be added later
+        auto iter = _listenerMap.find(eventName);
+        if (iter == _listenerMap.end())
+            return nullptr;
+        entry.listeners = iter->second;
+        entry.dirty = true;
+    }
+    
+    if (entry.dirty)
+    {
+        sortEventListeners(eventName);
+        // Sorting without a running scene keeps the scene graph flag set
+        auto dirtyIter = _priorityDirtyFlagMap.find(eventName);
+        entry.dirty = dirtyIter != _priorityDirtyFlagMap.end() && dirtyIter->second != DirtyFlag::NONE;
+    }
+    return entry.listeners;
+}
+
+void EventDispatcher::invalidateCustomListeners()
+{
+    _customListeners.clear();
+}
+
+void EventDispatcher::benchmarkEventDispatch(int dispatches, int listenersPerEvent)
+{
+    // Its own dispatcher, so the benchmark names are released with it
+    EventDispatcher* dispatcher = new (std::nothrow) EventDispatcher();
+    dispatcher->setEnabled(true);
+    std::vector<std::string> names;
+    std::vector<int> ids;
+    long received = 0;
+    for (int i = 0; i < 20; i++)
+    {
+        names.push_back("BenchmarkEventDispatch" + std::to_string(i));
+        ids.push_back(dispatcher->getCustomEventID(names.back()));
+        for (int j = 0; j < listenersPerEvent; j++)
+        {
+            dispatcher->addCustomEventListener(ids.back(), [&received](EventCustom*) { received++; });
+        }
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < dispatches; i++)
+    {
+        EventCustom event(names[i % names.size()]);
+        dispatcher->dispatchEvent(&event);
+    }
+    float eventTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0f;
+    
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < dispatches; i++)
+    {
+        dispatcher->dispatchCustomEvent(names[i % names.size()]);
+    }
+    float nameTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0f;
+    
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < dispatches; i++)
+    {
+        dispatcher->dispatchCustomEvent(ids[i % ids.size()]);
+    }
+    float idTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0f;
+    
+    CCASSERT(received == (long)dispatches * listenersPerEvent * 3, "benchmarkEventDispatch: listeners were not all called");
+    log("Event dispatch benchmark, %d dispatches to %d listeners each: EventCustom by name %f ms, name wrapper %f ms, ID %f ms",
+        dispatches, listenersPerEvent, eventTime, nameTime, idTime);
+    dispatcher->release();
+}
+
 bool EventDispatcher::hasEventListener(const EventListener::ListenerID& listenerID) const
 {
     return getListeners(listenerID) != nullptr;
@@ -1168,6 +1336,7 @@ void EventDispatcher::updateListeners(Event* event)
                 auto l = *iter;
                 if (!l->isRegistered())
                 {
+                    _hasEmptyListeners = true;
                     iter = sceneGraphPriorityListeners->erase(iter);
                     // if item in toRemove list, remove it from the list
                     auto matchIter = std::find(_toRemovedListeners.begin(), _toRemovedListeners.end(), l);
@@ -1189,6 +1358,7 @@ void EventDispatcher::updateListeners(Event* event)
                 auto l = *iter;
                 if (!l->isRegistered())
                 {
+                    _hasEmptyListeners = true;
                     iter = fixedPriorityListeners->erase(iter);
                     // if item in toRemove list, remove it from the list
                     auto matchIter = std::find(_toRemovedListeners.begin(), _toRemovedListeners.end(), l);
@@ -1219,6 +1389,11 @@ void EventDispatcher::updateListeners(Event* event)
         onUpdateListeners(EventListenerTouchOneByOne::LISTENER_ID);
         onUpdateListeners(EventListenerTouchAllAtOnce::LISTENER_ID);
     }
+    else if (event->getType() == Event::Type::CUSTOM)
+    {
+        // CUSTOM: avoid copying the event name
+        onUpdateListeners(static_cast<EventCustom*>(event)->getEventName());
+    }
     else
     {
         onUpdateListeners(__getListenerID(event));
@@ -1226,17 +1401,23 @@ void EventDispatcher::updateListeners(Event* event)
     
     CCASSERT(_inDispatch == 1, "_inDispatch should be 1 here.");
     
-    for (auto iter = _listenerMap.begin(); iter != _listenerMap.end();)
+    // CUSTOM: only walk the whole map when a listener was actually removed
+    if (_hasEmptyListeners)
     {
-        if (iter->second->empty())
+        _hasEmptyListeners = false;
+        for (auto iter = _listenerMap.begin(); iter != _listenerMap.end();)
         {
-            _priorityDirtyFlagMap.erase(iter->first);
-            delete iter->second;
-            iter = _listenerMap.erase(iter);
-        }
-        else
-        {
-            ++iter;
+            if (iter->second->empty())
+            {
+                _priorityDirtyFlagMap.erase(iter->first);
+                delete iter->second;
+                iter = _listenerMap.erase(iter);
+                invalidateCustomListeners();
+            }
+            else
+            {
+                ++iter;
+            }
         }
     }
     
@@ -1436,6 +1617,11 @@ void EventDispatcher::removeEventListenersForListenerID(const EventListener::Lis
             listeners->clear();
             delete listeners;
             _listenerMap.erase(listenerItemIter);
+            invalidateCustomListeners();
+        }
+        else
+        {
+            _hasEmptyListeners = true;
         }
     }
     
@@ -1513,6 +1699,7 @@ void EventDispatcher::removeAllEventListeners()
     if (!_inDispatch && cleanMap)
     {
         _listenerMap.clear();
+        invalidateCustomListeners();
     }
 }
 
@@ -1554,6 +1741,16 @@ void EventDispatcher::setDirty(const EventListener::ListenerID& listenerID, Dirt
         int ret = (int)flag | (int)iter->second;
         iter->second = (DirtyFlag) ret;
     }
+    
+    // CUSTOM: the cached listeners of a custom event ID need sorting again
+    if (!_customListeners.empty())
+    {
+        auto idIter = _customEventIDs.find(listenerID);
+        if (idIter != _customEventIDs.end() && idIter->second < (int)_customListeners.size())
+        {
+            _customListeners[idIter->second].dirty = true;
+        }
+    }
 }
 
 void EventDispatcher::cleanToRemovedListeners()
@@ -1596,6 +1793,7 @@ void EventDispatcher::cleanToRemovedListeners()
 
         if (find)
         {
+            _hasEmptyListeners = true;
             if (sceneGraphPriorityListeners && sceneGraphPriorityListeners->empty())
             {
                 listeners->clearSceneGraphListeners();
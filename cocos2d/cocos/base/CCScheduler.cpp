@@ -806,8 +806,12 @@ void Scheduler::resumeTargets(const std::set<void*>& targetsToResume)
 
 void Scheduler::performFunctionInCocosThread(std::function<void ()> function)
 {
-    std::lock_guard<std::mutex> lock(_performMutex);
-    _functionsToPerform.push_back(std::move(function));
+    {
+        std::lock_guard<std::mutex> lock(_performMutex);
+        _functionsToPerform.push_back(std::move(function));
+    }
+    // CUSTOM: the function runs during the next frame, make sure there is one when rendering on demand
+    Director::getInstance()->requestRedraw();
 }
 
 void Scheduler::removeAllFunctionsToBePerformedInCocosThread()
@@ -20,6 +20,11 @@ This file was modified to fit the cocos2d-x project
 
 #include "math/MathUtil.h"
 #include "base/ccMacros.h"
+#include "base/ccTypes.h"
+#include "base/CCConsole.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include <cpu-features.h>
@@ -31,6 +36,7 @@ This file was modified to fit the cocos2d-x project
 //#define INCLUDE_NEON64    : neon 64 code included
 //#define USE_SSE           : SSE code used
 //#define INCLUDE_SSE       : SSE code included
+//#define INCLUDE_AVX2      : AVX2 code included, used after a runtime check
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
     #if defined (__arm64__)
@@ -58,6 +64,10 @@ This file was modified to fit the cocos2d-x project
 #define INCLUDE_SSE
 #endif
 
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__)) && defined (__SSE2__)
+#define INCLUDE_AVX2
+#endif
+
 #ifdef INCLUDE_NEON32
 #include "math/MathUtilNeon.inl"
 #endif
@@ -70,6 +80,10 @@ This file was modified to fit the cocos2d-x project
 #include "math/MathUtilSSE.inl"
 #endif
 
+#ifdef INCLUDE_AVX2
+#include "math/MathUtilAVX2.inl"
+#endif
+
 #include "math/MathUtil.inl"
 
 NS_CC_MATH_BEGIN
@@ -135,6 +149,16 @@ bool MathUtil::isNeon64Enabled()
 #endif
 }
 
+bool MathUtil::isAVX2Enabled()
+{
+#ifdef INCLUDE_AVX2
+    static bool isAVX2Supported = __builtin_cpu_supports("avx2");
+    return isAVX2Supported;
+#else
+    return false;
+#endif
+}
+
 void MathUtil::addMatrix(const float* m, float scalar, float* dst)
 {
 #ifdef USE_NEON32
@@ -275,4 +299,102 @@ void MathUtil::crossVec3(const float* v1, const float* v2, float* dst)
 #endif
 }
 
+void MathUtil::transformVertices(const float* m, float* v, size_t count, size_t stride)
+{
+#ifdef USE_NEON32
+    MathUtilNeon::transformVertices(m, v, count, stride);
+#elif defined (USE_NEON64)
+    MathUtilNeon64::transformVertices(m, v, count, stride);
+#elif defined (INCLUDE_NEON32)
+    if(isNeon32Enabled()) MathUtilNeon::transformVertices(m, v, count, stride);
+    else MathUtilC::transformVertices(m, v, count, stride);
+#elif defined (INCLUDE_AVX2)
+    if(isAVX2Enabled()) MathUtilAVX2::transformVertices(m, v, count, stride);
+    else
+    {
+        __m128 col[4] = {_mm_loadu_ps(m), _mm_loadu_ps(m + 4), _mm_loadu_ps(m + 8), _mm_loadu_ps(m + 12)};
+        transformVertices(col, v, count, stride);
+    }
+#elif defined (USE_SSE)
+    __m128 col[4] = {_mm_loadu_ps(m), _mm_loadu_ps(m + 4), _mm_loadu_ps(m + 8), _mm_loadu_ps(m + 12)};
+    transformVertices(col, v, count, stride);
+#else
+    MathUtilC::transformVertices(m, v, count, stride);
+#endif
+}
+
+void MathUtil::offsetIndices(const unsigned short* src, unsigned short* dst, size_t count, unsigned short offset)
+{
+#ifdef USE_NEON32
+    MathUtilNeon::offsetIndices(src, dst, count, offset);
+#elif defined (USE_NEON64)
+    MathUtilNeon64::offsetIndices(src, dst, count, offset);
+#elif defined (INCLUDE_NEON32)
+    if(isNeon32Enabled()) MathUtilNeon::offsetIndices(src, dst, count, offset);
+    else MathUtilC::offsetIndices(src, dst, count, offset);
+#elif defined (INCLUDE_AVX2)
+    if(isAVX2Enabled()) MathUtilAVX2::offsetIndices(src, dst, count, offset);
+    else offsetIndices(_mm_set1_epi16((short)offset), src, dst, count);
+#elif defined (__SSE2__)
+    offsetIndices(_mm_set1_epi16((short)offset), src, dst, count);
+#else
+    MathUtilC::offsetIndices(src, dst, count, offset);
+#endif
+}
+
+void MathUtil::benchmarkVertexTransform(int iterations)
+{
+    Mat4 modelView;
+    Mat4::createRotationZ(0.3f, &modelView);
+    modelView.scale(1.5f);
+    modelView.translate(120, -40, 0);
+    for (int quads : {10000, 50000, 100000})
+    {
+        std::vector<V3F_C4B_T2F> source(quads * 4);
+        std::vector<unsigned short> sourceIndices(quads * 6);
+        for (int i = 0; i < quads; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                source[i * 4 + j].vertices = Vec3(i % 100 + (j % 2) * 10, i / 100 + (j / 2) * 10, 0);
+            }
+            const unsigned short quadIndices[6] = {0, 1, 2, 3, 2, 1};
+            for (int j = 0; j < 6; j++)
+            {
+                sourceIndices[i * 6 + j] = (unsigned short)(i * 4 + quadIndices[j]);
+            }
+        }
+        std::vector<V3F_C4B_T2F> verts(source.size());
+        std::vector<unsigned short> indices(sourceIndices.size());
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            std::copy(source.begin(), source.end(), verts.begin());
+            for (V3F_C4B_T2F& vertex : verts)
+            {
+                modelView.transformPoint(&vertex.vertices);
+            }
+            for (size_t j = 0; j < indices.size(); j++)
+            {
+                indices[j] = (unsigned short)(i + sourceIndices[j]);
+            }
+        }
+        float scalarTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0f / iterations;
+        Vec3 scalarLast = verts.back().vertices;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            std::copy(source.begin(), source.end(), verts.begin());
+            transformVertices(modelView.m, &verts[0].vertices.x, verts.size(), sizeof(V3F_C4B_T2F));
+            offsetIndices(sourceIndices.data(), indices.data(), indices.size(), (unsigned short)i);
+        }
+        float batchedTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0f / iterations;
+        CCASSERT(verts.back().vertices.distanceSquared(scalarLast) < 0.01f, "benchmarkVertexTransform: batched transform doesn't match Mat4::transformPoint");
+        log("Vertex transform benchmark on %d quads, average of %d iterations: per-vertex %f ms, batched %f ms",
+            quads, iterations, scalarTime, batchedTime);
+    }
+}
+
 NS_CC_MATH_END
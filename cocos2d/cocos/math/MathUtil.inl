@@ -42,6 +42,10 @@ public:
     inline static void transformVec4(const float* m, const float* v, float* dst);
     
     inline static void crossVec3(const float* v1, const float* v2, float* dst);
+
+    inline static void transformVertices(const float* m, float* v, size_t count, size_t stride);
+
+    inline static void offsetIndices(const unsigned short* src, unsigned short* dst, size_t count, unsigned short offset);
 };
 
 inline void MathUtilC::addMatrix(const float* m, float scalar, float* dst)
@@ -215,4 +219,27 @@ inline void MathUtilC::crossVec3(const float* v1, const float* v2, float* dst)
     dst[2] = z;
 }
 
+inline void MathUtilC::transformVertices(const float* m, float* v, size_t count, size_t stride)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float x = v[0] * m[0] + v[1] * m[4] + v[2] * m[8] + m[12];
+        float y = v[0] * m[1] + v[1] * m[5] + v[2] * m[9] + m[13];
+        float z = v[0] * m[2] + v[1] * m[6] + v[2] * m[10] + m[14];
+        
+        v[0] = x;
+        v[1] = y;
+        v[2] = z;
+        v = (float*)((char*)v + stride);
+    }
+}
+
+inline void MathUtilC::offsetIndices(const unsigned short* src, unsigned short* dst, size_t count, unsigned short offset)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        dst[i] = src[i] + offset;
+    }
+}
+
 NS_CC_MATH_END
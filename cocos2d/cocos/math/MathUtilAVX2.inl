@@ -0,0 +1,99 @@
+/****************************************************************************
+ Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include <immintrin.h>
+
+NS_CC_MATH_BEGIN
+
+// Compiled for AVX2 regardless of the build flags: only call these after MathUtil::isAVX2Enabled()
+class MathUtilAVX2
+{
+public:
+    __attribute__((target("avx2"))) static void transformVertices(const float* m, float* v, size_t count, size_t stride);
+
+    __attribute__((target("avx2"))) static void offsetIndices(const unsigned short* src, unsigned short* dst, size_t count, unsigned short offset);
+};
+
+__attribute__((target("avx2"))) inline void MathUtilAVX2::transformVertices(const float* m, float* v, size_t count, size_t stride)
+{
+    // Two vertices per iteration, one in each 128 bits lane
+    __m256 col0 = _mm256_broadcast_ps((const __m128*)m);
+    __m256 col1 = _mm256_broadcast_ps((const __m128*)(m + 4));
+    __m256 col2 = _mm256_broadcast_ps((const __m128*)(m + 8));
+    __m256 col3 = _mm256_broadcast_ps((const __m128*)(m + 12));
+    // Lane indices of x, y and z once both points are packed as x0 y0 z0 0 x1 y1 z1 0
+    const __m256i xIndex = _mm256_setr_epi32(0, 0, 0, 0, 4, 4, 4, 4);
+    const __m256i yIndex = _mm256_setr_epi32(1, 1, 1, 1, 5, 5, 5, 5);
+    const __m256i zIndex = _mm256_setr_epi32(2, 2, 2, 2, 6, 6, 6, 6);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        float* v1 = (float*)((char*)v + stride);
+        // Only 3 floats are read from each element, the stride may not leave room for a 4th one
+        __m128 p0 = _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)v), _mm_load_ss(v + 2));
+        __m128 p1 = _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)v1), _mm_load_ss(v1 + 2));
+        __m256 points = _mm256_insertf128_ps(_mm256_castps128_ps256(p0), p1, 1);
+        __m256 x = _mm256_permutevar8x32_ps(points, xIndex);
+        __m256 y = _mm256_permutevar8x32_ps(points, yIndex);
+        __m256 z = _mm256_permutevar8x32_ps(points, zIndex);
+        __m256 dst = _mm256_add_ps(
+                                   _mm256_add_ps(_mm256_mul_ps(col0, x), _mm256_mul_ps(col1, y)),
+                                   _mm256_add_ps(_mm256_mul_ps(col2, z), col3)
+                                   );
+        __m128 dst0 = _mm256_castps256_ps128(dst);
+        __m128 dst1 = _mm256_extractf128_ps(dst, 1);
+        // Only x, y, z are written back, the rest of the element is left untouched
+        _mm_storel_pi((__m64*)v, dst0);
+        _mm_store_ss(v + 2, _mm_movehl_ps(dst0, dst0));
+        _mm_storel_pi((__m64*)v1, dst1);
+        _mm_store_ss(v1 + 2, _mm_movehl_ps(dst1, dst1));
+        v = (float*)((char*)v1 + stride);
+    }
+    if (i < count)
+    {
+        __m128 dst = _mm_add_ps(
+                                _mm_add_ps(_mm_mul_ps(_mm256_castps256_ps128(col0), _mm_set1_ps(v[0])), _mm_mul_ps(_mm256_castps256_ps128(col1), _mm_set1_ps(v[1]))),
+                                _mm_add_ps(_mm_mul_ps(_mm256_castps256_ps128(col2), _mm_set1_ps(v[2])), _mm256_castps256_ps128(col3))
+                                );
+        _mm_storel_pi((__m64*)v, dst);
+        _mm_store_ss(v + 2, _mm_movehl_ps(dst, dst));
+    }
+}
+
+__attribute__((target("avx2"))) inline void MathUtilAVX2::offsetIndices(const unsigned short* src, unsigned short* dst, size_t count, unsigned short offset)
+{
+    __m256i offsets = _mm256_set1_epi16((short)offset);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i indices = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi16(indices, offsets));
+    }
+    for (; i < count; ++i)
+    {
+        dst[i] = src[i] + offset;
+    }
+}
+
+NS_CC_MATH_END
@@ -17,6 +17,8 @@
 
  This file was modified to fit the cocos2d-x project
  */
+#include <arm_neon.h>
+
 NS_CC_MATH_BEGIN
 
 class MathUtilNeon
@@ -41,6 +43,10 @@ public:
     inline static void transformVec4(const float* m, const float* v, float* dst);
     
     inline static void crossVec3(const float* v1, const float* v2, float* dst);
+
+    inline static void transformVertices(const float* m, float* v, size_t count, size_t stride);
+
+    inline static void offsetIndices(const unsigned short* src, unsigned short* dst, size_t count, unsigned short offset);
 };
 
 inline void MathUtilNeon::addMatrix(const float* m, float scalar, float* dst)
@@ -268,4 +274,36 @@ inline void MathUtilNeon::crossVec3(const float* v1, const float* v2, float* dst
                  );
 }
 
+inline void MathUtilNeon::transformVertices(const float* m, float* v, size_t count, size_t stride)
+{
+    float32x4_t col0 = vld1q_f32(m);
+    float32x4_t col1 = vld1q_f32(m + 4);
+    float32x4_t col2 = vld1q_f32(m + 8);
+    float32x4_t col3 = vld1q_f32(m + 12);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float32x4_t dst = vmlaq_n_f32(col3, col0, v[0]);
+        dst = vmlaq_n_f32(dst, col1, v[1]);
+        dst = vmlaq_n_f32(dst, col2, v[2]);
+        // Only x, y, z are written back, the rest of the element is left untouched
+        vst1_f32(v, vget_low_f32(dst));
+        vst1q_lane_f32(v + 2, dst, 2);
+        v = (float*)((char*)v + stride);
+    }
+}
+
+inline void MathUtilNeon::offsetIndices(const unsigned short* src, unsigned short* dst, size_t count, unsigned short offset)
+{
+    uint16x8_t offsets = vdupq_n_u16(offset);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        vst1q_u16(dst + i, vaddq_u16(vld1q_u16(src + i), offsets));
+    }
+    for (; i < count; ++i)
+    {
+        dst[i] = src[i] + offset;
+    }
+}
+
 NS_CC_MATH_END
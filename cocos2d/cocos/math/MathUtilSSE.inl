@@ -151,6 +151,39 @@ void MathUtil::transformVec4(const __m128 m[4], const __m128& v, __m128& dst)
                      );
 }
 
+void MathUtil::transformVertices(const __m128 m[4], float* v, size_t count, size_t stride)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        __m128 dst = _mm_add_ps(
+                                _mm_add_ps(_mm_mul_ps(m[0], _mm_set1_ps(v[0])), _mm_mul_ps(m[1], _mm_set1_ps(v[1]))),
+                                _mm_add_ps(_mm_mul_ps(m[2], _mm_set1_ps(v[2])), m[3])
+                                );
+        // Only x, y, z are written back, the rest of the element is left untouched
+        _mm_storel_pi((__m64*)v, dst);
+        _mm_store_ss(v + 2, _mm_movehl_ps(dst, dst));
+        v = (float*)((char*)v + stride);
+    }
+}
+
+#endif
+
+#ifdef __SSE2__
+
+void MathUtil::offsetIndices(const __m128i& offset, const unsigned short* src, unsigned short* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i indices = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi16(indices, offset));
+    }
+    for (; i < count; ++i)
+    {
+        dst[i] = src[i] + (unsigned short)_mm_extract_epi16(offset, 0);
+    }
+}
+
 #endif
 
 
@@ -787,7 +787,7 @@ void HttpClient::networkThread()
         
         // Create a HttpResponse object, the default setting is http access failed
         HttpResponse *response = new (std::nothrow) HttpResponse(request);
-        processResponse(response, _responseMessage);
+        processObservedResponse(response, _responseMessage);
         
         // add response packet into queue
         _responseQueueMutex.lock();
@@ -820,7 +820,7 @@ void HttpClient::networkThreadAlone(HttpRequest* request, HttpResponse* response
     increaseThreadCount();
 
     char responseMessage[RESPONSE_BUFFER_SIZE] = { 0 };
-    processResponse(response, responseMessage);
+    processObservedResponse(response, responseMessage);
 
     _schedulerMutex.lock();
     if (_scheduler != nullptr)
@@ -106,7 +106,7 @@ void HttpClient::networkThread()
         // Create a HttpResponse object, the default setting is http access failed
         HttpResponse *response = new (std::nothrow) HttpResponse(request);
 
-        processResponse(response, _responseMessage);
+        processObservedResponse(response, _responseMessage);
 
 
         // add response packet into queue
@@ -140,7 +140,7 @@ void HttpClient::networkThreadAlone(HttpRequest* request, HttpResponse* response
     increaseThreadCount();
 
     char responseMessage[RESPONSE_BUFFER_SIZE] = { 0 };
-    processResponse(response, responseMessage);
+    processObservedResponse(response, responseMessage);
 
     _schedulerMutex.lock();
     if (nullptr != _scheduler)
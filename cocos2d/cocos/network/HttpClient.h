@@ -29,6 +29,7 @@
 
 #include <thread>
 #include <condition_variable>
+#include <functional>
 #include "base/CCVector.h"
 #include "base/CCScheduler.h"
 #include "network/HttpRequest.h"
@@ -149,6 +150,12 @@ public:
     std::mutex& getCookieFileMutex() {return _cookieFileMutex;}
 
     std::mutex& getSSLCaFileMutex() {return _sslCaFileMutex;}
+
+    /* CUSTOM METHOD
+     * Observer called on the network threads around each request: with true before it is processed, then with false once its response is ready.
+     * Used to profile the network threads. It isn't synchronized with them: set it before sending requests.
+     */
+    static void setRequestObserver(const std::function<void(HttpRequest*, bool)>& observer) { getRequestObserver() = observer; }
 private:
     HttpClient();
     virtual ~HttpClient();
@@ -165,6 +172,19 @@ private:
     void dispatchResponseCallbacks();
 
     void processResponse(HttpResponse* response, char* responseMessage);
+    // CUSTOM: shared by the platform implementations, which process their requests through processObservedResponse
+    static std::function<void(HttpRequest*, bool)>& getRequestObserver()
+    {
+        static std::function<void(HttpRequest*, bool)> observer;
+        return observer;
+    }
+    void processObservedResponse(HttpResponse* response, char* responseMessage)
+    {
+        auto& observer = getRequestObserver();
+        if (observer) observer(response->getHttpRequest(), true);
+        processResponse(response, responseMessage);
+        if (observer) observer(response->getHttpRequest(), false);
+    }
     void increaseThreadCount();
     void decreaseThreadCountAndMayDeleteThis();
 
@@ -127,6 +127,15 @@ void GLView::pollEvents()
 {
 }
 
+void GLView::waitEvents(float timeout)
+{
+    pollEvents();
+}
+
+void GLView::wakeUp()
+{
+}
+
 void GLView::updateDesignResolutionSize()
 {
     if (_screenSize.width > 0 && _screenSize.height > 0
@@ -158,6 +158,17 @@ public:
     
     /** Polls the events. */
     virtual void pollEvents();
+    
+    /** CUSTOM METHOD
+     * Waits for events for at most timeout seconds (-1 to wait until an event arrives), then processes them.
+     * Used by the run loop when Director renders on demand. Default implementation only polls.
+     */
+    virtual void waitEvents(float timeout);
+    
+    /** CUSTOM METHOD
+     * Interrupts waitEvents. Thread safe.
+     */
+    virtual void wakeUp();
 
     /**
      * Get the frame size of EGL view.
@@ -429,6 +429,23 @@ void GLViewImpl::pollEvents()
     glfwPollEvents();
 }
 
+void GLViewImpl::waitEvents(float timeout)
+{
+    if (timeout < 0)
+    {
+        glfwWaitEvents();
+    }
+    else
+    {
+        glfwWaitEventsTimeout(timeout);
+    }
+}
+
+void GLViewImpl::wakeUp()
+{
+    glfwPostEmptyEvent();
+}
+
 void GLViewImpl::enableRetina(bool enabled)
 {
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
@@ -643,6 +660,8 @@ void GLViewImpl::onGLFWError(int errorID, const char* errorDesc)
 
 void GLViewImpl::onGLFWMouseCallBack(GLFWwindow* /*window*/, int button, int action, int /*modify*/)
 {
+    // CUSTOM: input wakes up Director render on demand
+    Director::getInstance()->requestRedraw();
     if(GLFW_MOUSE_BUTTON_LEFT == button)
     {
         if(GLFW_PRESS == action)
@@ -687,6 +706,8 @@ void GLViewImpl::onGLFWMouseCallBack(GLFWwindow* /*window*/, int button, int act
 
 void GLViewImpl::onGLFWMouseMoveCallBack(GLFWwindow* window, double x, double y)
 {
+    // CUSTOM: input wakes up Director render on demand
+    Director::getInstance()->requestRedraw();
     _mouseX = (float)x;
     _mouseY = (float)y;
 
@@ -732,6 +753,8 @@ void GLViewImpl::onGLFWMouseMoveCallBack(GLFWwindow* window, double x, double y)
 
 void GLViewImpl::onGLFWMouseScrollCallback(GLFWwindow* /*window*/, double x, double y)
 {
+    // CUSTOM: input wakes up Director render on demand
+    Director::getInstance()->requestRedraw();
     EventMouse event(EventMouse::MouseEventType::MOUSE_SCROLL);
     //Because OpenGL and cocos2d-x uses different Y axis, we need to convert the coordinate here
     float cursorX = (_mouseX - _viewPortRect.origin.x) / _scaleX;
@@ -743,6 +766,8 @@ void GLViewImpl::onGLFWMouseScrollCallback(GLFWwindow* /*window*/, double x, dou
 
 void GLViewImpl::onGLFWKeyCallback(GLFWwindow* /*window*/, int key, int /*scancode*/, int action, int /*mods*/)
 {
+    // CUSTOM: input wakes up Director render on demand
+    Director::getInstance()->requestRedraw();
     if (GLFW_REPEAT != action)
     {
         EventKeyboard event(g_keyCodeMap[key], GLFW_PRESS == action);
@@ -775,6 +800,8 @@ void GLViewImpl::onGLFWKeyCallback(GLFWwindow* /*window*/, int key, int /*scanco
 
 void GLViewImpl::onGLFWCharCallback(GLFWwindow* /*window*/, unsigned int character)
 {
+    // CUSTOM: input wakes up Director render on demand
+    Director::getInstance()->requestRedraw();
     char16_t wcharString[2] = { (char16_t) character, 0 };
     std::string utf8String;
 
@@ -845,6 +872,8 @@ void GLViewImpl::onGLFWWindowSizeFunCallback(GLFWwindow* /*window*/, int width,
         setDesignResolutionSize(baseDesignSize.width, baseDesignSize.height, baseResolutionPolicy);
         Director::getInstance()->setViewport();
         Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(GLViewImpl::EVENT_WINDOW_RESIZED, nullptr);
+        // CUSTOM: the resized window must be redrawn when rendering on demand
+        Director::getInstance()->requestRedraw();
     }
 }
 
@@ -78,6 +78,8 @@ public:
 
     bool windowShouldClose() override;
     void pollEvents() override;
+    void waitEvents(float timeout) override;
+    void wakeUp() override;
     GLFWwindow* getWindow() const { return _mainWindow; }
 
     bool isFullscreen() const;
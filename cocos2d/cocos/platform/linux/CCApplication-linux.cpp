@@ -87,7 +87,14 @@ int Application::run()
         glview->pollEvents();
 
         curTime = getCurrentMillSecond();
-        if (curTime - lastTime < _animationInterval)
+        float timeUntilRedraw = director->getTimeUntilRedraw();
+        if (director->isRenderOnDemand() && timeUntilRedraw != 0)
+        {
+            // Nothing to draw: sleep until the next redraw deadline or input event, without exceeding the frame rate
+            float frameTimeLeft = MAX(0, _animationInterval - curTime + lastTime) / 1000.0f;
+            glview->waitEvents(timeUntilRedraw < 0 ? -1 : MAX(timeUntilRedraw, frameTimeLeft));
+        }
+        else if (curTime - lastTime < _animationInterval)
         {
             usleep((_animationInterval - curTime + lastTime)*1000);
         }
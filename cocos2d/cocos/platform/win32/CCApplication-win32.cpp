@@ -109,7 +109,16 @@ int Application::run()
         {
             nLast.QuadPart = nNow.QuadPart;
             director->mainLoop();
-            glview->pollEvents();
+            float timeUntilRedraw = director->getTimeUntilRedraw();
+            if (director->isRenderOnDemand() && timeUntilRedraw != 0)
+            {
+                // Nothing to draw: sleep until the next redraw deadline or input event. The frame rate is still capped by the interval check
+                glview->waitEvents(timeUntilRedraw);
+            }
+            else
+            {
+                glview->pollEvents();
+            }
         }
         else
         {
@@ -44,6 +44,7 @@
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventType.h"
+#include "math/MathUtil.h"
 #include "2d/CCCamera.h"
 #include "2d/CCScene.h"
 
@@ -710,18 +711,11 @@ void Renderer::fillVerticesAndIndices(const TrianglesCommand* cmd)
     memcpy(&_verts[_filledVertex], cmd->getVertices(), sizeof(V3F_C4B_T2F) * cmd->getVertexCount());
 
     // fill vertex, and convert them to world coordinates
-    const Mat4& modelView = cmd->getModelView();
-    for(ssize_t i=0; i < cmd->getVertexCount(); ++i)
-    {
-        modelView.transformPoint(&(_verts[i + _filledVertex].vertices));
-    }
+    // the whole span is transformed at once, using SIMD when the CPU supports it
+    MathUtil::transformVertices(cmd->getModelView().m, &_verts[_filledVertex].vertices.x, cmd->getVertexCount(), sizeof(V3F_C4B_T2F));
 
     // fill index
-    const unsigned short* indices = cmd->getIndices();
-    for(ssize_t i=0; i< cmd->getIndexCount(); ++i)
-    {
-        _indices[_filledIndex + i] = _filledVertex + indices[i];
-    }
+    MathUtil::offsetIndices(cmd->getIndices(), &_indices[_filledIndex], cmd->getIndexCount(), _filledVertex);
 
     _filledVertex += cmd->getVertexCount();
     _filledIndex += cmd->getIndexCount();
@@ -306,6 +306,8 @@ void TextureCache::loadImage()
         _responseMutex.lock();
         _responseQueue.push_back(asyncStruct);
         _responseMutex.unlock();
+        // CUSTOM: the response is handled during a frame, wake up Director render on demand
+        Director::getInstance()->requestRedraw();
     }
 }
 